@@ -48,6 +48,9 @@ static char* c_conn_set_out_rate (cJSON *params);
 static char* c_conn_set_iq_blk_sz (cJSON *params);
 static char* c_conn_set_mic_blk_sz (cJSON *params);
 static char* c_conn_set_duplex (cJSON *params);
+static char* c_conn_set_rx_batch_sz (cJSON *params);
+static char* c_conn_set_flush_denormals (cJSON *params);
+static char* c_conn_set_dsp_scheduler (cJSON *params);
 static char* c_conn_set_fft_size (cJSON *params);
 static char* c_conn_set_window_type (cJSON *params);
 static char* c_conn_set_av_mode (cJSON *params);
@@ -100,6 +103,12 @@ static char* c_conn_set_tx_mode(cJSON *params);
 static char* c_conn_set_rx_1_agc(cJSON *params);
 static char* c_conn_set_rx_2_agc(cJSON *params);
 static char* c_conn_set_rx_3_agc(cJSON *params);
+static char* c_conn_set_rx_1_nr(cJSON *params);
+static char* c_conn_set_rx_2_nr(cJSON *params);
+static char* c_conn_set_rx_3_nr(cJSON *params);
+static char* c_conn_set_rx_1_pipeline(cJSON *params);
+static char* c_conn_set_rx_2_pipeline(cJSON *params);
+static char* c_conn_set_rx_3_pipeline(cJSON *params);
 static char* c_conn_set_rx_1_gain(cJSON *params);
 static char* c_conn_set_rx_2_gain(cJSON *params);
 static char* c_conn_set_rx_3_gain(cJSON *params);
@@ -156,6 +165,12 @@ stringToFunc funcCases[] =
 	{ "set_rx1_agc",		c_conn_set_rx_1_agc },
 	{ "set_rx2_agc",		c_conn_set_rx_2_agc },
 	{ "set_rx3_agc",		c_conn_set_rx_3_agc },
+	{ "set_rx1_nr",			c_conn_set_rx_1_nr },
+	{ "set_rx2_nr",			c_conn_set_rx_2_nr },
+	{ "set_rx3_nr",			c_conn_set_rx_3_nr },
+	{ "set_rx1_pipeline",	c_conn_set_rx_1_pipeline },
+	{ "set_rx2_pipeline",	c_conn_set_rx_2_pipeline },
+	{ "set_rx3_pipeline",	c_conn_set_rx_3_pipeline },
 	{ "set_rx1_gain",		c_conn_set_rx_1_gain },
 	{ "set_rx2_gain",		c_conn_set_rx_2_gain },
 	{ "set_rx3_gain",		c_conn_set_rx_3_gain },
@@ -164,6 +179,9 @@ stringToFunc funcCases[] =
 	{ "set_iq_blk_sz",		c_conn_set_iq_blk_sz },
 	{ "set_mic_blk_sz",		c_conn_set_mic_blk_sz },
 	{ "set_duplex",			c_conn_set_duplex },
+	{ "set_rx_batch_sz",	c_conn_set_rx_batch_sz },
+	{ "set_flush_denormals",	c_conn_set_flush_denormals },
+	{ "set_dsp_scheduler",	c_conn_set_dsp_scheduler },
 	{ "set_fft_size",		c_conn_set_fft_size },
 	{ "set_window_type",	c_conn_set_window_type },
 	{ "set_av_mode",		c_conn_set_av_mode },
@@ -472,6 +490,37 @@ static char* c_conn_set_duplex(cJSON *params) {
 	return encode_ack_nak("ACK");
 }
 
+static char* c_conn_set_rx_batch_sz(cJSON *params) {
+	/*
+	** Arguments:
+	** 	p0		-- 	most frames per receive call
+	*/
+	c_server_set_rx_batch_sz(cJSON_GetArrayItem(params, 0)->valueint);
+	return encode_ack_nak("ACK");
+}
+
+static char* c_conn_set_flush_denormals(cJSON *params) {
+	/*
+	** Arguments:
+	** 	p0		-- 	1 to flush denormals to zero in the DSP threads
+	*/
+	c_server_set_flush_denormals(cJSON_GetArrayItem(params, 0)->valueint);
+	return encode_ack_nak("ACK");
+}
+
+static char* c_conn_set_dsp_scheduler(cJSON *params) {
+	/*
+	** Arguments:
+	** 	p0		-- 	workers running the DSP channels, 0 for a thread per channel
+	** 	p1		-- 	first core the workers are pinned to, -1 to leave them unpinned
+	** 	p2		-- 	SCHED_FIFO priority of the workers, 0 for none
+	** 	p3		-- 	core of a worker of its own for TX, -1 for none
+	*/
+	c_server_set_dsp_scheduler(cJSON_GetArrayItem(params, 0)->valueint, cJSON_GetArrayItem(params, 1)->valueint,
+		cJSON_GetArrayItem(params, 2)->valueint, cJSON_GetArrayItem(params, 3)->valueint);
+	return encode_ack_nak("ACK");
+}
+
 static char* c_conn_set_fft_size(cJSON *params) {
 	/*
 	** Arguments:
@@ -1131,6 +1180,63 @@ static char* c_conn_set_rx_3_agc(cJSON *params) {
 	return encode_ack_nak("ACK");
 }
 
+static char* c_conn_set_rx_1_nr(cJSON *params) {
+	/*
+	** Arguments:
+	** 	p0		-- 	1 to run noise reduction
+	*/
+	c_server_set_rx_nr(0, cJSON_GetArrayItem(params, 0)->valueint);
+	return encode_ack_nak("ACK");
+}
+
+static char* c_conn_set_rx_2_nr(cJSON *params) {
+	/*
+	** Arguments:
+	** 	p0		-- 	1 to run noise reduction
+	*/
+	c_server_set_rx_nr(1, cJSON_GetArrayItem(params, 0)->valueint);
+	return encode_ack_nak("ACK");
+}
+
+static char* c_conn_set_rx_3_nr(cJSON *params) {
+	/*
+	** Arguments:
+	** 	p0		-- 	1 to run noise reduction
+	*/
+	c_server_set_rx_nr(2, cJSON_GetArrayItem(params, 0)->valueint);
+	return encode_ack_nak("ACK");
+}
+
+static char* c_conn_set_rx_1_pipeline(cJSON *params) {
+	/*
+	** Arguments:
+	** 	p0		-- 	number of DSP pipeline segments, 1..4
+	** 	p1		-- 	core of the first pipeline worker, -1 for none
+	*/
+	c_server_set_rx_pipeline(0, cJSON_GetArrayItem(params, 0)->valueint, cJSON_GetArrayItem(params, 1)->valueint);
+	return encode_ack_nak("ACK");
+}
+
+static char* c_conn_set_rx_2_pipeline(cJSON *params) {
+	/*
+	** Arguments:
+	** 	p0		-- 	number of DSP pipeline segments, 1..4
+	** 	p1		-- 	core of the first pipeline worker, -1 for none
+	*/
+	c_server_set_rx_pipeline(1, cJSON_GetArrayItem(params, 0)->valueint, cJSON_GetArrayItem(params, 1)->valueint);
+	return encode_ack_nak("ACK");
+}
+
+static char* c_conn_set_rx_3_pipeline(cJSON *params) {
+	/*
+	** Arguments:
+	** 	p0		-- 	number of DSP pipeline segments, 1..4
+	** 	p1		-- 	core of the first pipeline worker, -1 for none
+	*/
+	c_server_set_rx_pipeline(2, cJSON_GetArrayItem(params, 0)->valueint, cJSON_GetArrayItem(params, 1)->valueint);
+	return encode_ack_nak("ACK");
+}
+
 static char* c_conn_set_rx_1_gain(cJSON *params) {
 	/*
 	** Arguments:
@@ -42,6 +42,16 @@ The authors can be reached by email at:
 #define MAX_TX 1
 #define MAX_RX 7
 
+// Precision of the decode -> DSP -> encode path
+// Build with make DSP_FLOAT=1 to run it in single precision, the default is double
+#ifdef DSP_FLOAT
+	typedef float dsp_t;
+	#define DSP_PRECISION "float"
+#else
+	typedef double dsp_t;
+	#define DSP_PRECISION "double"
+#endif
+
 // Defaults for argument structure
 #define IN_RATE 48000
 #define OUT_RATE 48000
@@ -49,6 +59,16 @@ The authors can be reached by email at:
 #define MIC_BLK_SZ 1024
 #define FFT_SZ 8192
 #define DISPLAY_WIDTH 600
+#define RX_BATCH_SZ 16
+
+// Most frames the reader will take in one receive call
+#define MAX_RX_BATCH 64
+// Most frames the writer will send in one burst
+#define MAX_TX_BURST 16
+// Output frames still queued at the low point of a block period beyond this are sent early to bound latency
+#define TX_MAX_BACKLOG 8
+// Silent frames sent once output first appears so a block arriving late does not run the radio dry
+#define TX_PRIME_FRAMES 2
 
 #define HPSDR "HPSDR"
 #define LOCAL "Local"
@@ -35,6 +35,7 @@ bob@bobcowdery.plus.com
 #include <stdlib.h>
 #include <sys/types.h>
 #include <time.h>
+#include <errno.h>
 
 #define HAVE_STRUCT_TIMESPEC
 
@@ -42,6 +43,7 @@ bob@bobcowdery.plus.com
 	#include <sys/socket.h> 
 	#include <arpa/inet.h> 
 	#include <netinet/in.h> 
+	#include <stdatomic.h>
 #else
 	#define _WINSOCK_DEPRECATED_NO_WARNINGS
 	#include <winsock2.h>
@@ -74,6 +76,8 @@ bob@bobcowdery.plus.com
 #include "../server/dsp_man.h"
 // Pipeline processing
 #include "../pipeline/pipeline.h"
+#include "../pipeline/iq_unpack.h"
+#include "../pipeline/pcm_pack.h"
 // Radio hardware interfacing and processing
 #include "radio_defs.h"
 #include "../radio/hw_control.h"
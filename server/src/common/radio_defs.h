@@ -98,8 +98,6 @@ extern int channel_number;
 extern int display_number;
 extern int input_samplerate;
 extern int output_samplerate;
-extern unsigned char *iq;
-extern unsigned char *mic;
 extern char *local_mic;
 extern float *pan;
 extern int pan_sz_r1;
@@ -111,9 +109,9 @@ extern short peak_input_level;
 extern Args *pargs;
 extern Pipeline *ppl;
 extern AudioDefault audioDefault;
-extern ringb_t *rb_iq_in;
+extern ringb_t *rb_iq_in[];
 extern ringb_t *rb_mic_in;
-extern ringb_t *rb_out;
+extern struct ep2_queue *eq_out;
 extern pthread_mutex_t pipeline_mutex;
 extern pthread_cond_t pipeline_con;
 extern int local_input_running;
@@ -0,0 +1,369 @@
+/*
+iq_unpack.c
+
+Vectorised 24 bit big endian IQ unpacking for the SDRLibE library
+
+Copyright (C) 2018 by G3UKB Bob Cowdery
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+The authors can be reached by email at:
+
+	bob@bobcowdery.plus.com
+
+*/
+
+/*
+The IQ data from the radio is a stream of 24 bit big endian values, I then Q for
+each receiver in turn. Taken 3 bytes at a time a sample set is therefore a sequence of
+I/Q pairs cycling through the receivers. In the radio frames each sample set is followed
+by the 2 mic bytes so consecutive sets are stride bytes apart.
+
+The vector kernels shuffle 4 values (12 bytes) at a time into the top 3 bytes of 32 bit
+lanes, shift down arithmetically to sign extend, convert to dsp_t and scale. Each 4 values
+is 2 complete I/Q pairs which are stored to the receiver they belong to, so the deinterleave
+is done in the same pass. A set with an odd number of pairs finishes with a single pair.
+When the sets are contiguous (stride == num_rx * 6) the whole buffer is treated as one set.
+
+The kernel is selected at run time according to the CPU. All kernels give identical
+results to the scalar version as the integer conversion is exact for both double and
+float (24 bits fits the float mantissa) and the scale is a power of 2.
+*/
+
+// Includes
+#include "../common/include.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+	#define IQ_UNPACK_X86
+	#include <immintrin.h>
+	#if defined(_MSC_VER)
+		#include <intrin.h>
+		#define TARGET(isa)
+	#else
+		#define TARGET(isa) __attribute__((target(isa)))
+	#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+	#define IQ_UNPACK_NEON
+	#include <arm_neon.h>
+#endif
+
+// Move on to the next I/Q pair, cycling through the receivers
+#define NEXT_PAIR(rx, idx, num_rx) if (++(rx) == (num_rx)) { (rx) = 0; (idx) += 2; }
+
+#ifdef IQ_UNPACK_X86
+// Store 4 converted values from v as 2 pairs, or the low 2 values as 1 pair
+#ifdef DSP_FLOAT
+	#define SSE_SCALE(s) _mm_set1_ps((float)(s))
+	#define SSE_STORE_2(dst, rx, idx, num_rx, v, vscale) { \
+		__m128 f_ = _mm_mul_ps(_mm_cvtepi32_ps(v), vscale); \
+		_mm_storel_pi((__m64 *)((dst)[rx] + (idx)), f_); NEXT_PAIR(rx, idx, num_rx); \
+		_mm_storeh_pi((__m64 *)((dst)[rx] + (idx)), f_); NEXT_PAIR(rx, idx, num_rx); }
+	#define SSE_STORE_1(dst, rx, idx, num_rx, v, vscale) { \
+		_mm_storel_pi((__m64 *)((dst)[rx] + (idx)), _mm_mul_ps(_mm_cvtepi32_ps(v), vscale)); NEXT_PAIR(rx, idx, num_rx); }
+	typedef __m128 sse_scale_t;
+#else
+	#define SSE_SCALE(s) _mm_set1_pd(s)
+	#define SSE_STORE_2(dst, rx, idx, num_rx, v, vscale) { \
+		_mm_storeu_pd((dst)[rx] + (idx), _mm_mul_pd(_mm_cvtepi32_pd(v), vscale)); NEXT_PAIR(rx, idx, num_rx); \
+		_mm_storeu_pd((dst)[rx] + (idx), _mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(v, 8)), vscale)); NEXT_PAIR(rx, idx, num_rx); }
+	#define SSE_STORE_1(dst, rx, idx, num_rx, v, vscale) { \
+		_mm_storeu_pd((dst)[rx] + (idx), _mm_mul_pd(_mm_cvtepi32_pd(v), vscale)); NEXT_PAIR(rx, idx, num_rx); }
+	typedef __m128d sse_scale_t;
+#endif
+#endif
+
+// Selected kernel
+static IQUnpackFn unpack_fn = iq_unpack_scalar;
+static const char *unpack_name = "scalar";
+
+// Convert and stash n_pairs contiguous I/Q pairs, continuing from receiver *rx and output index *idx
+static void unpack_pairs(const unsigned char *src, int n_pairs, int num_rx, dsp_t **dst, int *rx, int *idx, double scale) {
+	int i, as_int;
+
+	for (i = 0; i < n_pairs; i++, src += 6) {
+		// big endian stores the most significant byte in the lowest address
+		// Convert and stash the I
+		as_int = (int)(((unsigned int)src[0] << 24) | (src[1] << 16) | (src[2] << 8)) >> 8;
+		dst[*rx][*idx] = (dsp_t)scale * (dsp_t)as_int;
+		// Convert and stash the Q
+		as_int = (int)(((unsigned int)src[3] << 24) | (src[4] << 16) | (src[5] << 8)) >> 8;
+		dst[*rx][*idx + 1] = (dsp_t)scale * (dsp_t)as_int;
+		NEXT_PAIR(*rx, *idx, num_rx);
+	}
+}
+
+// Work out how the sample sets are walked
+// Contiguous sets are run together as one set
+static void set_layout(int stride, int n_smpls, int num_rx, int *n_sets, int *pairs_per_set) {
+	if (stride == num_rx * 6) {
+		*n_sets = 1;
+		*pairs_per_set = n_smpls * num_rx;
+	} else {
+		*n_sets = n_smpls;
+		*pairs_per_set = num_rx;
+	}
+}
+
+void iq_unpack_scalar(const unsigned char *src, int stride, int n_smpls, int num_rx, dsp_t **dst, int dst_index, double scale) {
+	int set, n_sets, pairs_per_set;
+	int rx = 0, idx = dst_index;
+
+	set_layout(stride, n_smpls, num_rx, &n_sets, &pairs_per_set);
+	for (set = 0; set < n_sets; set++, src += stride) {
+		unpack_pairs(src, pairs_per_set, num_rx, dst, &rx, &idx, scale);
+	}
+}
+
+#ifdef IQ_UNPACK_X86
+
+TARGET("ssse3")
+static void iq_unpack_ssse3(const unsigned char *src, int stride, int n_smpls, int num_rx, dsp_t **dst, int dst_index, double scale) {
+	int set, n_sets, pairs_per_set, k;
+	int rx = 0, idx = dst_index;
+	const unsigned char *p;
+	// Loads must stay inside the buffer
+	const unsigned char *end = src + (n_smpls - 1) * stride + num_rx * 6;
+	const __m128i shuf = _mm_setr_epi8(-1, 2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9);
+	const sse_scale_t vscale = SSE_SCALE(scale);
+	__m128i v;
+
+	set_layout(stride, n_smpls, num_rx, &n_sets, &pairs_per_set);
+	for (set = 0; set < n_sets; set++) {
+		p = src + set * stride;
+		k = pairs_per_set;
+		// 2 pairs from a 16 byte load
+		for (; k >= 2 && p + 16 <= end; k -= 2, p += 12) {
+			v = _mm_srai_epi32(_mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)p), shuf), 8);
+			SSE_STORE_2(dst, rx, idx, num_rx, v, vscale);
+		}
+		// 1 pair from an 8 byte load
+		for (; k >= 1 && p + 8 <= end; k--, p += 6) {
+			v = _mm_srai_epi32(_mm_shuffle_epi8(_mm_loadl_epi64((const __m128i *)p), shuf), 8);
+			SSE_STORE_1(dst, rx, idx, num_rx, v, vscale);
+		}
+		unpack_pairs(p, k, num_rx, dst, &rx, &idx, scale);
+	}
+}
+
+TARGET("avx2")
+static void iq_unpack_avx2(const unsigned char *src, int stride, int n_smpls, int num_rx, dsp_t **dst, int dst_index, double scale) {
+	int set, n_sets, pairs_per_set, k;
+	int rx = 0, idx = dst_index;
+	const unsigned char *p;
+	// Loads must stay inside the buffer
+	const unsigned char *end = src + (n_smpls - 1) * stride + num_rx * 6;
+	const __m256i shuf = _mm256_setr_epi8(-1, 2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9,
+										  -1, 2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9);
+	const sse_scale_t vscale1 = SSE_SCALE(scale);
+#ifdef DSP_FLOAT
+	const __m256 vscale = _mm256_set1_ps((float)scale);
+	__m256 f;
+	__m128 lo, hi;
+#else
+	const __m256d vscale = _mm256_set1_pd(scale);
+	__m256d lo, hi;
+#endif
+	__m256i v;
+	__m128i v1;
+
+	set_layout(stride, n_smpls, num_rx, &n_sets, &pairs_per_set);
+	for (set = 0; set < n_sets; set++) {
+		p = src + set * stride;
+		k = pairs_per_set;
+		// 4 pairs from two 16 byte loads 12 bytes apart
+		for (; k >= 4 && p + 28 <= end; k -= 4, p += 24) {
+			v = _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)p));
+			v = _mm256_inserti128_si256(v, _mm_loadu_si128((const __m128i *)(p + 12)), 1);
+			v = _mm256_srai_epi32(_mm256_shuffle_epi8(v, shuf), 8);
+#ifdef DSP_FLOAT
+			f = _mm256_mul_ps(_mm256_cvtepi32_ps(v), vscale);
+			if (num_rx == 1) {
+				// Single receiver is contiguous
+				_mm256_storeu_ps(dst[0] + idx, f);
+				idx += 8;
+			} else {
+				lo = _mm256_castps256_ps128(f);
+				hi = _mm256_extractf128_ps(f, 1);
+				_mm_storel_pi((__m64 *)(dst[rx] + idx), lo);
+				NEXT_PAIR(rx, idx, num_rx);
+				_mm_storeh_pi((__m64 *)(dst[rx] + idx), lo);
+				NEXT_PAIR(rx, idx, num_rx);
+				_mm_storel_pi((__m64 *)(dst[rx] + idx), hi);
+				NEXT_PAIR(rx, idx, num_rx);
+				_mm_storeh_pi((__m64 *)(dst[rx] + idx), hi);
+				NEXT_PAIR(rx, idx, num_rx);
+			}
+#else
+			lo = _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(v)), vscale);
+			hi = _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(v, 1)), vscale);
+			if (num_rx == 1) {
+				// Single receiver is contiguous
+				_mm256_storeu_pd(dst[0] + idx, lo);
+				_mm256_storeu_pd(dst[0] + idx + 4, hi);
+				idx += 8;
+			} else {
+				_mm_storeu_pd(dst[rx] + idx, _mm256_castpd256_pd128(lo));
+				NEXT_PAIR(rx, idx, num_rx);
+				_mm_storeu_pd(dst[rx] + idx, _mm256_extractf128_pd(lo, 1));
+				NEXT_PAIR(rx, idx, num_rx);
+				_mm_storeu_pd(dst[rx] + idx, _mm256_castpd256_pd128(hi));
+				NEXT_PAIR(rx, idx, num_rx);
+				_mm_storeu_pd(dst[rx] + idx, _mm256_extractf128_pd(hi, 1));
+				NEXT_PAIR(rx, idx, num_rx);
+			}
+#endif
+		}
+		// 2 pairs from a 16 byte load
+		for (; k >= 2 && p + 16 <= end; k -= 2, p += 12) {
+			v1 = _mm_srai_epi32(_mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)p), _mm256_castsi256_si128(shuf)), 8);
+			SSE_STORE_2(dst, rx, idx, num_rx, v1, vscale1);
+		}
+		// 1 pair from an 8 byte load
+		for (; k >= 1 && p + 8 <= end; k--, p += 6) {
+			v1 = _mm_srai_epi32(_mm_shuffle_epi8(_mm_loadl_epi64((const __m128i *)p), _mm256_castsi256_si128(shuf)), 8);
+			SSE_STORE_1(dst, rx, idx, num_rx, v1, vscale1);
+		}
+		unpack_pairs(p, k, num_rx, dst, &rx, &idx, scale);
+	}
+}
+
+static int cpu_has_ssse3() {
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	return (info[2] & (1 << 9)) != 0;
+#else
+	return __builtin_cpu_supports("ssse3");
+#endif
+}
+
+static int cpu_has_avx2() {
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	// OSXSAVE and AVX and the OS saves the YMM state
+	if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0)
+		return FALSE;
+	if ((_xgetbv(0) & 6) != 6)
+		return FALSE;
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+#ifdef IQ_UNPACK_NEON
+
+static void iq_unpack_neon(const unsigned char *src, int stride, int n_smpls, int num_rx, dsp_t **dst, int dst_index, double scale) {
+	int set, n_sets, pairs_per_set, k;
+	int rx = 0, idx = dst_index;
+	const unsigned char *p;
+	// Loads must stay inside the buffer
+	const unsigned char *end = src + (n_smpls - 1) * stride + num_rx * 6;
+	// Out of range indices give zero
+	static const uint8_t shuf_tbl[16] = { 255, 2, 1, 0, 255, 5, 4, 3, 255, 8, 7, 6, 255, 11, 10, 9 };
+	const uint8x16_t shuf = vld1q_u8(shuf_tbl);
+	const uint8x8_t shuf_lo = vld1_u8(shuf_tbl);
+	int32x4_t v;
+	int32x2_t v2;
+#ifdef DSP_FLOAT
+	float32x4_t f;
+#endif
+
+	set_layout(stride, n_smpls, num_rx, &n_sets, &pairs_per_set);
+	for (set = 0; set < n_sets; set++) {
+		p = src + set * stride;
+		k = pairs_per_set;
+		// 2 pairs from a 16 byte load
+		for (; k >= 2 && p + 16 <= end; k -= 2, p += 12) {
+			v = vshrq_n_s32(vreinterpretq_s32_u8(vqtbl1q_u8(vld1q_u8(p), shuf)), 8);
+#ifdef DSP_FLOAT
+			f = vmulq_n_f32(vcvtq_f32_s32(v), (float)scale);
+			vst1_f32(dst[rx] + idx, vget_low_f32(f));
+			NEXT_PAIR(rx, idx, num_rx);
+			vst1_f32(dst[rx] + idx, vget_high_f32(f));
+			NEXT_PAIR(rx, idx, num_rx);
+#else
+			vst1q_f64(dst[rx] + idx, vmulq_n_f64(vcvtq_f64_s64(vmovl_s32(vget_low_s32(v))), scale));
+			NEXT_PAIR(rx, idx, num_rx);
+			vst1q_f64(dst[rx] + idx, vmulq_n_f64(vcvtq_f64_s64(vmovl_high_s32(v)), scale));
+			NEXT_PAIR(rx, idx, num_rx);
+#endif
+		}
+		// 1 pair from an 8 byte load
+		for (; k >= 1 && p + 8 <= end; k--, p += 6) {
+			v2 = vshr_n_s32(vreinterpret_s32_u8(vtbl1_u8(vld1_u8(p), shuf_lo)), 8);
+#ifdef DSP_FLOAT
+			vst1_f32(dst[rx] + idx, vmul_n_f32(vcvt_f32_s32(v2), (float)scale));
+#else
+			vst1q_f64(dst[rx] + idx, vmulq_n_f64(vcvtq_f64_s64(vmovl_s32(v2)), scale));
+#endif
+			NEXT_PAIR(rx, idx, num_rx);
+		}
+		unpack_pairs(p, k, num_rx, dst, &rx, &idx, scale);
+	}
+}
+
+#endif
+
+void iq_unpack_init() {
+	/* Select the best kernel for this CPU
+	 *
+	 * Arguments:
+	 *
+	 */
+
+	unpack_fn = iq_unpack_scalar;
+	unpack_name = "scalar";
+#ifdef IQ_UNPACK_X86
+	if (cpu_has_avx2()) {
+		unpack_fn = iq_unpack_avx2;
+		unpack_name = "avx2";
+	} else if (cpu_has_ssse3()) {
+		unpack_fn = iq_unpack_ssse3;
+		unpack_name = "ssse3";
+	}
+#endif
+#ifdef IQ_UNPACK_NEON
+	unpack_fn = iq_unpack_neon;
+	unpack_name = "neon";
+#endif
+}
+
+const char *iq_unpack_name() {
+	return unpack_name;
+}
+
+void iq_unpack(const unsigned char *src, int stride, int n_smpls, int num_rx, dsp_t **dst, int dst_index, double scale) {
+	/* Unpack and deinterleave IQ data using the selected kernel
+	 *
+	 * Arguments:
+	 * 	src			--	24 bit big endian I/Q data for num_rx receivers
+	 * 	stride		--	bytes from the start of one sample set to the next
+	 * 	n_smpls		--	number of sample sets (num_rx * 6 bytes each)
+	 * 	num_rx		--	number of receivers
+	 * 	dst			--	per receiver output buffers of interleaved I/Q dsp_t
+	 * 	dst_index	--	index in each output buffer to start at
+	 * 	scale		--	scale factor applied to each value
+	 *
+	 */
+
+	if (n_smpls > 0) {
+		unpack_fn(src, stride, n_smpls, num_rx, dst, dst_index, scale);
+	}
+}
@@ -0,0 +1,42 @@
+/*
+iq_unpack.h
+
+Vectorised 24 bit big endian IQ unpacking for the SDRLibE library
+
+Copyright (C) 2018 by G3UKB Bob Cowdery
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+The authors can be reached by email at:
+
+	bob@bobcowdery.plus.com
+
+*/
+
+#ifndef _iq_unpack_h
+#define _iq_unpack_h
+
+// Unpack n_smpls sample sets of interleaved 24 bit big endian I/Q for num_rx receivers.
+// Sample sets start stride bytes apart, stride is num_rx * 6 when they are contiguous.
+// Receiver rx I/Q is written as interleaved dsp_t (double or float) to dst[rx] starting at dst_index.
+typedef void (*IQUnpackFn)(const unsigned char *src, int stride, int n_smpls, int num_rx, dsp_t **dst, int dst_index, double scale);
+
+// Prototypes
+void iq_unpack_init();
+const char *iq_unpack_name();
+void iq_unpack(const unsigned char *src, int stride, int n_smpls, int num_rx, dsp_t **dst, int dst_index, double scale);
+void iq_unpack_scalar(const unsigned char *src, int stride, int n_smpls, int num_rx, dsp_t **dst, int dst_index, double scale);
+
+#endif
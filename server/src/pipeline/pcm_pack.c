@@ -0,0 +1,261 @@
+/*
+pcm_pack.c
+
+Vectorised double to 16 bit PCM packing for the SDRLibE library
+
+Copyright (C) 2018 by G3UKB Bob Cowdery
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+The authors can be reached by email at:
+
+	bob@bobcowdery.plus.com
+
+*/
+
+/*
+The pipeline outputs are interleaved dsp_t, L/R audio or I/Q, nominally +-1.0.
+Each output sample is a pair of 16 bit values, the first taken from the even
+(L or I) element of one buffer and the second from the odd (R or Q) element of
+another so different receivers can be routed to left and right.
+
+The values are scaled and clamped to the 16 bit range before conversion so a value
+outside +-1.0 saturates rather than wrapping. This means the DSP stages do not need
+their own clip loops. Conversion truncates toward zero as a C cast does.
+
+The pairs are written stride bytes apart so two calls can build the interleaved
+L/R/I/Q HPSDR format in place. The vector kernels do 2 samples per step for double
+and 4 (SSE2) or 2 (NEON) for float. SSE2 is always present on x86-64 and NEON on
+aarch64 so there is no run time selection.
+*/
+
+// Includes
+#include "../common/include.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define PCM_PACK_SSE2
+	#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+	#define PCM_PACK_NEON
+	#include <arm_neon.h>
+#endif
+
+// Limits of the scaled value
+#define PCM_MAX 32767.0
+#define PCM_MIN -32768.0
+
+// Store one 16 bit value in the requested byte order
+#define PUT16(p, v, order) if ((order) == PCM_BE) { (p)[0] = (unsigned char)(((v) >> 8) & 0xff); (p)[1] = (unsigned char)((v) & 0xff); } \
+	else { (p)[0] = (unsigned char)((v) & 0xff); (p)[1] = (unsigned char)(((v) >> 8) & 0xff); }
+
+static short to_pcm(dsp_t x, dsp_t scale) {
+	// Scale, clamp and truncate
+	x = x * scale;
+	if (x > PCM_MAX) x = PCM_MAX;
+	if (x < PCM_MIN) x = PCM_MIN;
+	return (short)x;
+}
+
+void pcm_pack_scalar(const dsp_t *a, const dsp_t *b, double scale, int n_smpls, unsigned char *dst, int stride, int order) {
+	int i;
+	short v0, v1;
+
+	for (i = 0; i < n_smpls; i++, dst += stride) {
+		v0 = to_pcm(a[2 * i], (dsp_t)scale);
+		v1 = to_pcm(b[2 * i + 1], (dsp_t)scale);
+		PUT16(dst, v0, order);
+		PUT16(dst + 2, v1, order);
+	}
+}
+
+#if defined(PCM_PACK_SSE2) && defined(DSP_FLOAT)
+
+static void pcm_pack_sse2(const float *a, const float *b, double scale, int n_smpls, unsigned char *dst, int stride, int order) {
+	int i;
+	const __m128 vscale = _mm_set1_ps((float)scale);
+	const __m128 vmax = _mm_set1_ps((float)PCM_MAX);
+	const __m128 vmin = _mm_set1_ps((float)PCM_MIN);
+	__m128 s0, s1;
+	__m128i v;
+	int pair;
+
+	for (i = 0; i + 4 <= n_smpls; i += 4) {
+		// Even elements from a and odd elements from b, a0 a2 b1 b3 reordered to a0 b1 a2 b3
+		s0 = _mm_shuffle_ps(_mm_loadu_ps(a + 2 * i), _mm_loadu_ps(b + 2 * i), _MM_SHUFFLE(3, 1, 2, 0));
+		s0 = _mm_shuffle_ps(s0, s0, _MM_SHUFFLE(3, 1, 2, 0));
+		s1 = _mm_shuffle_ps(_mm_loadu_ps(a + 2 * i + 4), _mm_loadu_ps(b + 2 * i + 4), _MM_SHUFFLE(3, 1, 2, 0));
+		s1 = _mm_shuffle_ps(s1, s1, _MM_SHUFFLE(3, 1, 2, 0));
+		s0 = _mm_min_ps(_mm_max_ps(_mm_mul_ps(s0, vscale), vmin), vmax);
+		s1 = _mm_min_ps(_mm_max_ps(_mm_mul_ps(s1, vscale), vmin), vmax);
+		// 8 x int16 for 4 samples
+		v = _mm_packs_epi32(_mm_cvttps_epi32(s0), _mm_cvttps_epi32(s1));
+		if (order == PCM_BE) {
+			v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+		}
+		if (stride == 4) {
+			_mm_storeu_si128((__m128i *)dst, v);
+		} else {
+			pair = _mm_cvtsi128_si32(v);
+			memcpy(dst, &pair, 4);
+			pair = _mm_cvtsi128_si32(_mm_srli_si128(v, 4));
+			memcpy(dst + stride, &pair, 4);
+			pair = _mm_cvtsi128_si32(_mm_srli_si128(v, 8));
+			memcpy(dst + 2 * stride, &pair, 4);
+			pair = _mm_cvtsi128_si32(_mm_srli_si128(v, 12));
+			memcpy(dst + 3 * stride, &pair, 4);
+		}
+		dst += 4 * stride;
+	}
+	pcm_pack_scalar(a + 2 * i, b + 2 * i, scale, n_smpls - i, dst, stride, order);
+}
+
+#elif defined(PCM_PACK_SSE2)
+
+static void pcm_pack_sse2(const dsp_t *a, const dsp_t *b, double scale, int n_smpls, unsigned char *dst, int stride, int order) {
+	int i;
+	const __m128d vscale = _mm_set1_pd(scale);
+	const __m128d vmax = _mm_set1_pd(PCM_MAX);
+	const __m128d vmin = _mm_set1_pd(PCM_MIN);
+	__m128d s0, s1;
+	__m128i v;
+	int pair;
+
+	for (i = 0; i + 2 <= n_smpls; i += 2) {
+		// Even element from a and odd element from b for each sample
+		s0 = _mm_move_sd(_mm_loadu_pd(b + 2 * i), _mm_loadu_pd(a + 2 * i));
+		s1 = _mm_move_sd(_mm_loadu_pd(b + 2 * i + 2), _mm_loadu_pd(a + 2 * i + 2));
+		s0 = _mm_min_pd(_mm_max_pd(_mm_mul_pd(s0, vscale), vmin), vmax);
+		s1 = _mm_min_pd(_mm_max_pd(_mm_mul_pd(s1, vscale), vmin), vmax);
+		// 4 x int32 then 4 x int16 in the low 64 bits
+		v = _mm_unpacklo_epi64(_mm_cvttpd_epi32(s0), _mm_cvttpd_epi32(s1));
+		v = _mm_packs_epi32(v, v);
+		if (order == PCM_BE) {
+			v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+		}
+		if (stride == 4) {
+			_mm_storel_epi64((__m128i *)dst, v);
+		} else {
+			pair = _mm_cvtsi128_si32(v);
+			memcpy(dst, &pair, 4);
+			pair = _mm_cvtsi128_si32(_mm_srli_si128(v, 4));
+			memcpy(dst + stride, &pair, 4);
+		}
+		dst += 2 * stride;
+	}
+	pcm_pack_scalar(a + 2 * i, b + 2 * i, scale, n_smpls - i, dst, stride, order);
+}
+
+#endif
+
+#if defined(PCM_PACK_NEON) && defined(DSP_FLOAT)
+
+static void pcm_pack_neon(const float *a, const float *b, double scale, int n_smpls, unsigned char *dst, int stride, int order) {
+	int i;
+	static const uint32_t even_tbl[4] = { 0xffffffff, 0, 0xffffffff, 0 };
+	const uint32x4_t even = vld1q_u32(even_tbl);
+	const float32x4_t vmax = vdupq_n_f32((float)PCM_MAX);
+	const float32x4_t vmin = vdupq_n_f32((float)PCM_MIN);
+	float32x4_t s;
+	int16x4_t v;
+	int32x2_t w;
+
+	for (i = 0; i + 2 <= n_smpls; i += 2) {
+		// Even elements from a and odd elements from b
+		s = vbslq_f32(even, vld1q_f32(a + 2 * i), vld1q_f32(b + 2 * i));
+		s = vminq_f32(vmaxq_f32(vmulq_n_f32(s, (float)scale), vmin), vmax);
+		// Truncating conversion, the values are already in range
+		v = vmovn_s32(vcvtq_s32_f32(s));
+		if (order == PCM_BE) {
+			v = vreinterpret_s16_u8(vrev16_u8(vreinterpret_u8_s16(v)));
+		}
+		if (stride == 4) {
+			vst1_s16((int16_t *)dst, v);
+		} else {
+			w = vreinterpret_s32_s16(v);
+			vst1_lane_s32((int32_t *)dst, w, 0);
+			vst1_lane_s32((int32_t *)(dst + stride), w, 1);
+		}
+		dst += 2 * stride;
+	}
+	pcm_pack_scalar(a + 2 * i, b + 2 * i, scale, n_smpls - i, dst, stride, order);
+}
+
+#elif defined(PCM_PACK_NEON)
+
+static void pcm_pack_neon(const dsp_t *a, const dsp_t *b, double scale, int n_smpls, unsigned char *dst, int stride, int order) {
+	int i;
+	const float64x2_t vmax = vdupq_n_f64(PCM_MAX);
+	const float64x2_t vmin = vdupq_n_f64(PCM_MIN);
+	float64x2_t s0, s1;
+	int16x4_t v;
+	int32x2_t w;
+
+	for (i = 0; i + 2 <= n_smpls; i += 2) {
+		// Even element from a and odd element from b for each sample
+		s0 = vcopyq_laneq_f64(vld1q_f64(b + 2 * i), 0, vld1q_f64(a + 2 * i), 0);
+		s1 = vcopyq_laneq_f64(vld1q_f64(b + 2 * i + 2), 0, vld1q_f64(a + 2 * i + 2), 0);
+		s0 = vminq_f64(vmaxq_f64(vmulq_n_f64(s0, scale), vmin), vmax);
+		s1 = vminq_f64(vmaxq_f64(vmulq_n_f64(s1, scale), vmin), vmax);
+		// Truncating conversion, the values are already in range
+		v = vmovn_s32(vcombine_s32(vmovn_s64(vcvtq_s64_f64(s0)), vmovn_s64(vcvtq_s64_f64(s1))));
+		if (order == PCM_BE) {
+			v = vreinterpret_s16_u8(vrev16_u8(vreinterpret_u8_s16(v)));
+		}
+		if (stride == 4) {
+			vst1_s16((int16_t *)dst, v);
+		} else {
+			w = vreinterpret_s32_s16(v);
+			vst1_lane_s32((int32_t *)dst, w, 0);
+			vst1_lane_s32((int32_t *)(dst + stride), w, 1);
+		}
+		dst += 2 * stride;
+	}
+	pcm_pack_scalar(a + 2 * i, b + 2 * i, scale, n_smpls - i, dst, stride, order);
+}
+
+#endif
+
+const char *pcm_pack_name() {
+#if defined(PCM_PACK_SSE2)
+	return "sse2";
+#elif defined(PCM_PACK_NEON)
+	return "neon";
+#else
+	return "scalar";
+#endif
+}
+
+void pcm_pack(const dsp_t *a, const dsp_t *b, double scale, int n_smpls, unsigned char *dst, int stride, int order) {
+	/* Scale, saturate and pack interleaved dsp_t to 16 bit pairs
+	 *
+	 * Arguments:
+	 * 	a			--	interleaved buffer supplying the first value of each pair from the even elements
+	 * 	b			--	interleaved buffer supplying the second value of each pair from the odd elements
+	 * 	scale		--	scale factor applied before saturating to 16 bits
+	 * 	n_smpls		--	number of pairs
+	 * 	dst			--	output, each pair is 4 bytes
+	 * 	stride		--	bytes from one output pair to the next, 4 when contiguous
+	 * 	order		--	PCM_BE or PCM_LE
+	 *
+	 */
+
+#if defined(PCM_PACK_SSE2)
+	pcm_pack_sse2(a, b, scale, n_smpls, dst, stride, order);
+#elif defined(PCM_PACK_NEON)
+	pcm_pack_neon(a, b, scale, n_smpls, dst, stride, order);
+#else
+	pcm_pack_scalar(a, b, scale, n_smpls, dst, stride, order);
+#endif
+}
@@ -0,0 +1,40 @@
+/*
+pcm_pack.h
+
+Vectorised double to 16 bit PCM packing for the SDRLibE library
+
+Copyright (C) 2018 by G3UKB Bob Cowdery
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+The authors can be reached by email at:
+
+	bob@bobcowdery.plus.com
+
+*/
+
+#ifndef _pcm_pack_h
+#define _pcm_pack_h
+
+// Byte order of the packed output
+#define PCM_LE 0
+#define PCM_BE 1
+
+// Prototypes
+const char *pcm_pack_name();
+void pcm_pack(const dsp_t *a, const dsp_t *b, double scale, int n_smpls, unsigned char *dst, int stride, int order);
+void pcm_pack_scalar(const dsp_t *a, const dsp_t *b, double scale, int n_smpls, unsigned char *dst, int stride, int order);
+
+#endif
@@ -37,11 +37,13 @@ Pipeline processing called from the Cython layer to implement:
 
 // Local functions
 static void *pipeline_imp(void *data);
+static int run_block(Pipeline *ppl, Transforms *ptr);
 static void init_transform(Pipeline *td);
 static void uninit_transform(Pipeline *td);
-static void do_decode(Pipeline *td, Transforms *ptr);
+static dsp_t *block_data(ringb_data_t *vec, unsigned int sz, dsp_t *buff);
 static void do_display(Pipeline *ppl, Transforms *ptr);
 static void do_dsp(Pipeline *td, Transforms *ptr);
+static void dsp_exchange(Transforms *ptr, int ch_id, dsp_t *in, int in_smpls, dsp_t *out, int out_smpls, int *error);
 static void do_local_audio(Pipeline *ppl, Transforms *ptr);
 static void do_encode(Pipeline *td, Transforms *ptr);
 
@@ -52,6 +54,9 @@ pthread_t pipeline_thd;
 Transforms *ptr = NULL;
 ThreadData *td = NULL;
 
+// Batching statistics, written only by the pipeline thread
+PipelineStats ppl_stats;
+
 // Temp buffers
 char *f_local_audio;
 float *f_display;
@@ -70,6 +75,8 @@ int pipeline_init(Pipeline *ppl) {
 
 	int rc;
 
+	printf("c.pipeline: DSP path in %s, PCM encoder using %s\n", DSP_PRECISION, pcm_pack_name());
+
 	// Allocate Transforms structure
 	ptr = (Transforms *)safealloc(sizeof(Transforms), sizeof(char), "TRANSFORMS_STRUCT");
 	// Initialise our Transform structure
@@ -156,8 +163,7 @@ int pipeline_terminate() {
 	// Signal the thread to ensure it sees the terminate
 	counter = 10;
 	while (!td->ppl->terminating) {
-		pthread_cond_signal(td->ppl->pipeline_con);
-		pthread_mutex_unlock(td->ppl->pipeline_mutex);
+		pipeline_signal();
 		if (counter-- <= 0) {
 			return FALSE;
 		} else {
@@ -179,6 +185,44 @@ int pipeline_terminate() {
 	return TRUE;
 }
 
+void pipeline_signal() {
+	/* Signal the pipeline that data is available
+	 *
+	 * Arguments:
+	 *
+	 * The pending flag is the wait predicate so a signal that arrives while
+	 * the pipeline is busy is not lost, it will find the flag set and go round again.
+	 */
+
+	pthread_mutex_lock(&pipeline_mutex);
+	if (ppl != NULL) {
+		ppl->data_pending = TRUE;
+	}
+	pthread_cond_signal(&pipeline_con);
+	pthread_mutex_unlock(&pipeline_mutex);
+}
+
+void pipeline_get_stats(PipelineStats *stats) {
+	/* Get a snapshot of the batching statistics
+	 *
+	 * Arguments:
+	 * 	stats	--	receives the statistics
+	 *
+	 */
+
+	*stats = ppl_stats;
+}
+
+void pipeline_reset_stats() {
+	/* Reset the batching statistics
+	 *
+	 * Arguments:
+	 *
+	 */
+
+	memset(&ppl_stats, 0, sizeof(PipelineStats));
+}
+
 // ===========================================================================
 // Pipeline implementation
 // Runs on a separate thread
@@ -195,57 +239,103 @@ static void *pipeline_imp(void *data) {
 	ThreadData* td = (ThreadData*)data;
 	Pipeline *ppl = (Pipeline *)td->ppl;
 	Transforms *ptr = (Transforms *)td->ptr;
-	int data_available;
+	unsigned int blocks;
+
+#ifdef UNIVERSAL
+	// Decaying gain and DSP output values must not drop into slow denormals
+	SetThreadFlushDenormals(ppl->args->general.flush_denormals);
+#endif
 
 	// Run until terminated
 	while (!ppl->terminate) {
 		// Wait for work
+		// The mutex is only held to test and clear the predicate, never while processing
 		pthread_mutex_lock(ppl->pipeline_mutex);
-		pthread_cond_wait(ppl->pipeline_con, ppl->pipeline_mutex);
-		
+		while (!ppl->data_pending && !ppl->terminate) {
+			pthread_cond_wait(ppl->pipeline_con, ppl->pipeline_mutex);
+		}
+		ppl->data_pending = FALSE;
+		pthread_mutex_unlock(ppl->pipeline_mutex);
+
 		// Check if we were woken for a termination
 		if (ppl->terminate) {
 			break;
 		}
-		data_available = FALSE;
-		// Sync up on data to make sure we read both IQ and Mic data
-		if ((ringb_read_space (ppl->rb_iq_in) >= ptr->in_iq_sz) && (ringb_read_space (ppl->rb_mic_in) >= ptr->in_mic_sz)) {
-			ringb_read (ppl->rb_iq_in, (char *)ptr->rd_iq_buff, ptr->in_iq_sz);
-			ringb_read (ppl->rb_mic_in, (char *)ptr->rd_mic_buff, ptr->in_mic_sz);
-			data_available = TRUE;
+		// Drain every complete block so latency is bounded by one block and not by the next frame
+		blocks = 0;
+		while (!ppl->terminate && run_block(ppl, ptr)) {
+			blocks++;
 		}
-		// Run the pipeline
-		if (data_available) {
-            //printf("Data available\n");
-			do_decode(ppl, ptr);
-            //printf("do_decode\n");
-			if (ppl->display_run) {
-				do_display(ppl, ptr);
-				//printf("do_display\n");
-			}
-			do_dsp(ppl, ptr);
-			//printf("do_dsp\n");
-			if (ppl->local_audio_run) {
-				do_local_audio(ppl, ptr);
-			}
-			//printf("do_local_audio\n");
-			do_encode(ppl, ptr);
-			//printf("do_encode\n");
-			// Write bytes to the output ring
-			if (ringb_write_space (ppl->rb_out) >= ptr->out_sz) {
-				ringb_write (ppl->rb_out, (char *)ptr->out_buff, ptr->out_sz);
-			}
-			else {
-				send_message("c.pipeline", "No space in output ring buffer");
+		// Batching statistics
+		if (blocks > 0) {
+			ppl_stats.wakeups++;
+			ppl_stats.blocks += blocks;
+			ppl_stats.last_batch = blocks;
+			if (blocks > ppl_stats.max_batch) {
+				ppl_stats.max_batch = blocks;
 			}
+		} else {
+			ppl_stats.empty_wakeups++;
 		}
-		pthread_mutex_unlock(&pipeline_mutex);
 	}
-	pthread_mutex_unlock(&pipeline_mutex);
 	ppl->terminating = TRUE;
 	return (void*)0;
 }
 
+static int run_block(Pipeline *ppl, Transforms *ptr) {
+	/* Run one block through the pipeline
+	 *
+	 * Arguments:
+	 * 	ppl		--	pointer to the Pipeline data structure
+	 * 	ptr		--	pointer to the Transform data structure
+	 *
+	 * Returns TRUE if a block was processed, FALSE if there is not a complete block available.
+	 */
+
+	int i;
+	int num_rx = ppl->args->num_rx;
+	size_t len, iq_avail = ptr->in_iq_sz;
+
+	// Sync up on data to make sure we read both IQ and Mic data
+	// The read vectors describe the data in place in the rings
+	// The reader advances the receiver rings one after another so take the least data of them all
+	for (i = 0; i < num_rx; i++) {
+		ringb_get_read_vector (ppl->rb_iq_in[i], ptr->iq_vec[i]);
+		len = ptr->iq_vec[i][0].len + ptr->iq_vec[i][1].len;
+		if (len < iq_avail) {
+			iq_avail = len;
+		}
+	}
+	ringb_get_read_vector (ppl->rb_mic_in, ptr->mic_vec);
+	if ((iq_avail < ptr->in_iq_sz) || (ptr->mic_vec[0].len + ptr->mic_vec[1].len < ptr->in_mic_sz)) {
+		return FALSE;
+	}
+
+	// The data was decoded by the reader so use it where it lies
+	for (i = 0; i < num_rx; i++) {
+		ptr->dec_iq_data[i] = block_data(ptr->iq_vec[i], ptr->in_iq_sz, ptr->dec_iq_buff[i]);
+	}
+	ptr->dec_mic_data = block_data(ptr->mic_vec, ptr->in_mic_sz, ptr->dec_mic_buff);
+
+	// Run the pipeline
+	if (ppl->display_run) {
+		do_display(ppl, ptr);
+	}
+	do_dsp(ppl, ptr);
+	if (ppl->local_audio_run) {
+		do_local_audio(ppl, ptr);
+	}
+	// Encode directly into the output ring
+	do_encode(ppl, ptr);
+
+	// Finished with the input so release the ring space
+	for (i = 0; i < num_rx; i++) {
+		ringb_read_advance (ppl->rb_iq_in[i], ptr->in_iq_sz);
+	}
+	ringb_read_advance (ppl->rb_mic_in, ptr->in_mic_sz);
+	return TRUE;
+}
+
 static void init_transform(Pipeline *ppl) {
 	/* Initialise the Transform structure
 	 *
@@ -261,9 +351,9 @@ static void init_transform(Pipeline *ppl) {
 	// Data in
 	// Note there are two ring buffers -
 	// IQ
-	// Contiguous samples interleaved for 1-n receivers
+	// One per receiver of contiguous complex dsp_t samples
 	// Mic
-	// Contiguous samples for mono mic input
+	// Contiguous complex dsp_t samples for mono mic input
 	//
 	// We must arrange for the output data from the pipeline to be the same
 	// number of samples for all channels so it can be combined into the output ring buffer.
@@ -274,27 +364,25 @@ static void init_transform(Pipeline *ppl) {
 	// by configuration.
 
 	// Set sizes and allocate buffers in the transform structure
-	// There are 6 bytes per IQ sample per receiver
-	ptr->in_iq_sz = ppl->args->general.iq_blk_sz*ppl->args->num_rx * 6;
-	ptr->rd_iq_buff = (unsigned char *)safealloc(ptr->in_iq_sz, sizeof(char), "IN_IQ_BUFF");
-	// Only 1 mic channel with 2 bytes per sample
-	ptr->in_mic_sz = ppl->args->general.mic_blk_sz * 2;
-	ptr->rd_mic_buff = (unsigned char *)safealloc(ptr->in_mic_sz, sizeof(char), "IN_MIC_BUFF");
+	// There are 2 dsp_t per IQ sample in each receiver ring
+	ptr->in_iq_sz = ppl->args->general.iq_blk_sz * 2 * sizeof(dsp_t);
+	// Only 1 mic channel with 2 dsp_t per sample
+	ptr->in_mic_sz = ppl->args->general.mic_blk_sz * 2 * sizeof(dsp_t);
 
 	//========================================================================
 	// Decoding
-	// Data is decoded for each receiver (from the 24 bit big endian samples to doubles) into a decode array.
+	// Data was decoded for each receiver (from the 24 bit big endian samples to dsp_t) by the reader.
 	// The DSP can accept any block size and will internally buffer until there are enough samples to process.
 	// When the DSP channels were opened the size was set to be IQ size (RX) or mic size (TX).
-	// Note block size is number of IQ samples so there are 2 doubles per sample.
+	// Note block size is number of IQ samples so there are 2 dsp_t per sample.
 	ptr->dec_iq_sz = ppl->args->general.iq_blk_sz * 2;
-	// Allocate a buffer for each receiver
+	// Allocate a buffer for each receiver for when a block wraps the ring
 	for (i=0 ; i < ppl->args->num_rx ; i++ ) {
-		ptr->dec_iq_data[i] = (double *)safealloc(ppl->args->general.iq_blk_sz * 2, sizeof(double), "DEC_IQ_BUFF");
+		ptr->dec_iq_buff[i] = (dsp_t *)safealloc(ppl->args->general.iq_blk_sz * 2, sizeof(dsp_t), "DEC_IQ_BUFF");
 	}
-	// Allocate a buffer for mic input which is 1 16 bit value converted to a complex double
+	// Allocate a buffer for mic input which is 1 16 bit value converted to a complex dsp_t
 	ptr->dec_mic_sz = ppl->args->general.mic_blk_sz;
-	ptr->dec_mic_data = (double *)safealloc(ppl->args->general.mic_blk_sz * 2, sizeof(double), "DEC_MIC_BUFF");
+	ptr->dec_mic_buff = (dsp_t *)safealloc(ppl->args->general.mic_blk_sz * 2, sizeof(dsp_t), "DEC_MIC_BUFF");
 
 	//========================================================================
 	// DSP
@@ -305,22 +393,33 @@ static void init_transform(Pipeline *ppl) {
 	ptr->dsp_lr_sz = (int)(((float)(ppl->args->general.iq_blk_sz * 2)) * ((float)(ppl->args->general.out_rate/(float)ppl->args->general.in_rate)));
 	// Create for max RX + TX as we index this by DSP ch_id NOT rx_id which could in theory be anywhere in that range
 	for (i=0 ; i < MAX_RX + MAX_TX ; i++ ) {
-		ptr->dsp_lr_data[i] = (double *)safealloc(ptr->dsp_lr_sz, sizeof(double), "DSP_LR_BUFF");
+		ptr->dsp_lr_data[i] = (dsp_t *)safealloc(ptr->dsp_lr_sz, sizeof(dsp_t), "DSP_LR_BUFF");
 	}
 	ptr->dsp_iq_sz = ppl->args->general.mic_blk_sz * 2;
-	ptr->dsp_iq_data = (double *)safealloc(ptr->dsp_iq_sz, sizeof(double), "DSP_IQ_BUFF");
+	ptr->dsp_iq_data = (dsp_t *)safealloc(ptr->dsp_iq_sz, sizeof(dsp_t), "DSP_IQ_BUFF");
+#ifdef DSP_FLOAT
+	// The single precision exchange takes separate I and Q buffers
+	// These are big enough for the largest input or output block
+	ptr->dsp_split_sz = ppl->args->general.iq_blk_sz;
+	if (ppl->args->general.mic_blk_sz > ptr->dsp_split_sz) ptr->dsp_split_sz = ppl->args->general.mic_blk_sz;
+	if (ptr->dsp_lr_sz / 2 > ptr->dsp_split_sz) ptr->dsp_split_sz = ptr->dsp_lr_sz / 2;
+	for (i=0 ; i < 4 ; i++ ) {
+		ptr->dsp_split[i] = (float *)safealloc(ptr->dsp_split_sz, sizeof(float), "DSP_SPLIT_BUFF");
+	}
+#endif
 	// The size must be the same on all outputs so we can combine into an output buffer.
 	// ptr->dsp_lr_sz === ptr->dsp_iq_sz
 
 	//========================================================================
 	// Encoding
-	// Note there is one ring buffer for output which contains Left/Right and IQ outputs
+	// Note there is one EP2 frame queue for output which contains Left/Right and IQ outputs
 	// All data is 16 bit at 48KHz.
 	// A total of 8 bytes per sample, 2x16 bit L/R audio and 2 x 16 bit I/Q TX data
 	// Regardless of the number of RX's only one RX data (or two if we split L/R) can be output to the HPSDR. However
 	// we can output more RX's to local audio hardware.
+	// The data is encoded in place in the output frames so there is no buffer to allocate
 	ptr->out_sz = (int)(((float)(ppl->args->general.iq_blk_sz * 4)* ((float)(ppl->args->general.out_rate/(float)ppl->args->general.in_rate)) + (float)(ppl->args->general.mic_blk_sz * 4)));
-	ptr->out_buff = (unsigned char *)safealloc(ptr->out_sz, sizeof(char), "OUT_BUFF");
+	ptr->out_smpls = ptr->out_sz / EP2_SMPL_SZ;
 }
 
 static void uninit_transform(Pipeline *ppl) {
@@ -332,107 +431,39 @@ static void uninit_transform(Pipeline *ppl) {
 	 */
 
 	int i;
-	safefree((char *)ptr->rd_iq_buff);
-	safefree((char *)ptr->rd_mic_buff);
 	for (i=0 ; i < ppl->args->num_rx ; i++ ) {
-		safefree((char *)ptr->dec_iq_data[i]);
+		safefree((char *)ptr->dec_iq_buff[i]);
 	}
-	safefree((char *)ptr->dec_mic_data);
+	safefree((char *)ptr->dec_mic_buff);
 	for (i=0 ; i < MAX_RX + MAX_TX ; i++ ) {
 		safefree((char *)ptr->dsp_lr_data[i]);
 	}
 	safefree((char *)ptr->dsp_iq_data);
-	safefree((char *)ptr->out_buff);
+#ifdef DSP_FLOAT
+	for (i=0 ; i < 4 ; i++ ) {
+		safefree((char *)ptr->dsp_split[i]);
+	}
+#endif
 	safefree((char*)ptr);
 }
 
-static void do_decode(Pipeline *ppl, Transforms *ptr) {
-	/* Decode data
+static dsp_t *block_data(ringb_data_t *vec, unsigned int sz, dsp_t *buff) {
+	/* Get a block of decoded data from a ring buffer read vector
 	 *
 	 * Arguments:
-	 * 	ppl		--	pointer to the Pipeline data structure
-	 * 	ptr		--	pointer to the Transform data structure
+	 * 	vec		--	the read vector
+	 * 	sz		--	block size in bytes
+	 * 	buff	--	buffer to assemble a block that wraps the end of the ring
 	 *
+	 * Returns a pointer to the block in place or in buff.
 	 */
 
-	/*
-	 *
-	 * Each IQ block is formatted as follows:
-	 *	For 1 receiver:
-	 *	0                        ... in_iq_sz
-	 *	<I2><I1><I0><Q2><Q1><Q0>
-	 *	For 2 receivers:
-	 *	0                        					... in_iq_sz
-	 *    <I12><I11><I10><Q12><Q11><Q10><I22><I21><I20><Q22><Q21><Q20>
-	 *	etc to 8 receivers
-	 *	The output is interleaved IQ per receiver.
-	 *
-	 * Each Mic block is formatted as follows:
-	 *	0                        ... in_mic_sz
-	 *	<M1><M0><M1><M0>
-	 *
-	 *
-	 */
-
-	int num_rx = ppl->args->num_rx;
-	int raw_iq_sz = ptr->in_iq_sz;
-	int raw_mic_sz = ptr->in_mic_sz;
-	int i,j;
-	int raw, rx;
-	int as_int;
-	short as_short;
-	int mic_index;
-	int src_index[8];
-	double input_iq_scale = (double)((double)1.0 / (double)pow(2, 23));
-	double input_mic_scale = (double)((double)1.0 / ((double)pow(2, 15) - (double)1.0));
-
-	// Decode IQ
-	// Clear the source index array
-	for(i=0;i<8;i++) {
-		src_index[i] = 0;
-	}
-
-	// Iterate over each set of sample data
-	// There are 3xI and 3xQ bytes for each receiver interleaved
-	for (raw=0 ; raw <= raw_iq_sz - (num_rx*6) ; raw += num_rx*6) {
-		// Iterate for each receiver
-		for (rx=0 ; rx < num_rx ; rx++) {
-			// This byte and 2 bytes following represent the 24 bit big endian I or Q data for this receiver
-			// big endian stores the most significant byte in the lowest address
-			// Convert and stash the I
-			as_int = ((ptr->rd_iq_buff[raw + 2 + (rx*6)] << 8) | (ptr->rd_iq_buff[raw + 1 + (rx*6)] << 16) | (ptr->rd_iq_buff[raw + (rx*6)] << 24)) >> 8;
-			ptr->dec_iq_data[rx][src_index[rx]] = (double)(input_iq_scale * (double)as_int);
-			src_index[rx] += 1;
-			// Convert and stash the Q
-			as_int = ((ptr->rd_iq_buff[raw + 5 + (rx*6)] << 8) | (ptr->rd_iq_buff[raw + 4 + (rx*6)] << 16) | (ptr->rd_iq_buff[raw + 3 + (rx*6)] << 24)) >> 8;
-			ptr->dec_iq_data[rx][src_index[rx]] = (double)(input_iq_scale * (double)as_int);
-			src_index[rx] += 1;
-		}
-	}
-
-	// Decode Mic
-	// Iterate through each byte in the raw data
-	mic_index = 0;
-	// Correct iteration
-	for (i=0 ; i <= raw_mic_sz - 2 ; i+=2) {
-		// Iterate for Mic data
-		// Add to Real and zero Imag
-		for (j=0 ; j < 2 ; j++) {
-			// This byte and 1 byte following represent the 16 bit big endian Mic data for this transmitter
-			// little endian stores the least significant byte in the lowest address
-			if (j == 0) {
-				// Add to real
-				as_short = (ptr->rd_mic_buff[i+1]) | (ptr->rd_mic_buff[i] << 8);
-				ptr->dec_mic_data[mic_index] = (double)(input_mic_scale * (double)as_short);
-			}
-			else {
-				// Zero imag
-				ptr->dec_mic_data[mic_index] = 0.0;
-			}
-			// Bump the mic index
-			mic_index ++;
-		}
+	if (vec[0].len >= sz) {
+		return (dsp_t *)vec[0].buf;
 	}
+	memcpy((char *)buff, vec[0].buf, vec[0].len);
+	memcpy((char *)buff + vec[0].len, vec[1].buf, sz - vec[0].len);
+	return buff;
 }
 
 static void do_display(Pipeline *ppl, Transforms *ptr) {
@@ -445,16 +476,24 @@ static void do_display(Pipeline *ppl, Transforms *ptr) {
 	 *
 	 */
 
-	int i, j, disp_id;
+	int i, disp_id;
+#ifndef DSP_FLOAT
+	int j;
+#endif
 	int num_rx = ppl->args->num_rx;
 
 	// For each receiver push the raw IQ data to the spectrum function
 	for (i=0 ; i < num_rx ; i++) {
 		disp_id = ppl->args->disp[i].ch_id;
+#ifdef DSP_FLOAT
+		// Already single precision
+		memcpy((char *)f_display, (char *)ptr->dec_iq_data[i], ppl->args->general.iq_blk_sz * 2 * sizeof(float));
+#else
 		for (j=0 ; j < ppl->args->general.iq_blk_sz*2 ; j++) {
 			f_display[j] = (float)ptr->dec_iq_data[i][j];
 		}
-		
+#endif
+
 #ifdef UNIVERSAL
 		// RAC - Universal version
 		// Added run param at start, set to 1?
@@ -487,31 +526,30 @@ static void do_dsp(Pipeline *ppl, Transforms *ptr) {
 		// Do the data exchange
 		// Note that decoded data is indexed by RX id and DSP data is indexed by DSP channel id
 		ch_id = ppl->args->rx[i].ch_id;
-		memset((char *)ptr->dsp_lr_data[ch_id], 0, ptr->dsp_lr_sz * sizeof(double));
-		fexchange0(ch_id, ptr->dec_iq_data[i], ptr->dsp_lr_data[ch_id], &error);
+		memset((char *)ptr->dsp_lr_data[ch_id], 0, ptr->dsp_lr_sz * sizeof(dsp_t));
+		dsp_exchange(ptr, ch_id, ptr->dec_iq_data[i], ppl->args->general.iq_blk_sz, ptr->dsp_lr_data[ch_id], ptr->dsp_lr_sz / 2, &error);
 		if (error != 0) {
 			sprintf(message, "DSP error %d\n", error);
 			send_message("c.pipeline", message);
 		}
-		// Limit and apply gain factor
+		// Apply gain factor
+		// The output is limited when it is packed to 16 bit
 		for (j=0 ; j < ptr->dsp_lr_sz ; j++) {
 			ptr->dsp_lr_data[ch_id][j] = ptr->dsp_lr_data[ch_id][j] * ppl->gain[i];
-			if (ptr->dsp_lr_data[ch_id][j] > 1.0) ptr->dsp_lr_data[ch_id][j] = 1.0;
-			if (ptr->dsp_lr_data[ch_id][j] < -1.0) ptr->dsp_lr_data[ch_id][j] = -1.0;
 		}
 	}
 
 	// Do TX DSP
 	if (ppl->args->num_tx > 0) {
-		//fexchange0(ppl->args->tx[0].ch_id, ptr->dec_mic_data, ptr->dsp_iq_data, &error);
-		// Limit and apply rf drive factor
+		//dsp_exchange(ptr, ppl->args->tx[0].ch_id, ptr->dec_mic_data, ppl->args->general.mic_blk_sz, ptr->dsp_iq_data, ptr->dsp_iq_sz / 2, &error);
+		// Apply rf drive factor
+		// The output is limited when it is packed to 16 bit
 		for (j=0 ; j < ptr->dsp_iq_sz ; j++) {
 			ptr->dsp_iq_data[j] = ptr->dsp_iq_data[j] * ppl->drive;
-			if (ptr->dsp_iq_data[j] > 1.0) ptr->dsp_iq_data[j] = 1.0;
-			if (ptr->dsp_iq_data[j] < -1.0) ptr->dsp_iq_data[j] = -1.0;
 		}
 		// Limit and apply mic gain factor
-		// This is a complex double with the imaginary part zero
+		// This is a complex dsp_t with the imaginary part zero
+		// The mic goes to the TX DSP rather than the 16 bit packing so it is clipped here
 		for (j=0 ; j < ppl->args->general.mic_blk_sz * 2 ; j+=2) {
 			ptr->dec_mic_data[j] = ptr->dec_mic_data[j] * ppl->mic_gain;
 			if (ptr->dec_mic_data[j] > 1.0) ptr->dec_mic_data[j] = 1.0;
@@ -519,10 +557,53 @@ static void do_dsp(Pipeline *ppl, Transforms *ptr) {
 		}
 	} else {
 		// Zero the IQ data
-		memset((char *)ptr->dsp_iq_data, 0, ptr->dsp_iq_sz * sizeof(double));
+		memset((char *)ptr->dsp_iq_data, 0, ptr->dsp_iq_sz * sizeof(dsp_t));
 	}
 }
 
+static void dsp_exchange(Transforms *ptr, int ch_id, dsp_t *in, int in_smpls, dsp_t *out, int out_smpls, int *error) {
+
+	/* Exchange a block with a DSP channel
+	 *
+	 * Arguments:
+	 * 	ptr			--	the Transform data structure
+	 * 	ch_id		--	the DSP channel
+	 * 	in			--	interleaved complex input
+	 * 	in_smpls	--	number of complex samples in
+	 * 	out			--	interleaved complex output
+	 * 	out_smpls	--	number of complex samples out
+	 * 	error		--	receives the exchange error
+	 *
+	 * The double path exchanges interleaved data directly. The single precision
+	 * exchange uses separate real and imaginary buffers so we split on the way in
+	 * and merge on the way out.
+	 */
+
+#ifdef DSP_FLOAT
+	int j;
+	float *i_in = ptr->dsp_split[0];
+	float *q_in = ptr->dsp_split[1];
+	float *i_out = ptr->dsp_split[2];
+	float *q_out = ptr->dsp_split[3];
+
+	for (j=0 ; j < in_smpls ; j++) {
+		i_in[j] = in[2*j];
+		q_in[j] = in[2*j+1];
+	}
+	fexchange2(ch_id, i_in, q_in, i_out, q_out, error);
+	for (j=0 ; j < out_smpls ; j++) {
+		out[2*j] = i_out[j];
+		out[2*j+1] = q_out[j];
+	}
+#else
+	// The channel knows its own block sizes and the split buffers are not needed
+	(void)ptr;
+	(void)in_smpls;
+	(void)out_smpls;
+	fexchange0(ch_id, in, out, error);
+#endif
+}
+
 static void do_local_audio(Pipeline *ppl, Transforms *ptr) {
 	/* Write to any local audio outputs
 	 *
@@ -535,34 +616,25 @@ static void do_local_audio(Pipeline *ppl, Transforms *ptr) {
 	 * output to the stream.
 	 */
 
-	unsigned int i, j, k, ret;
-	short LorI, RorQ;
+	unsigned int i, ret;
+	LocalOutput *out;
+	dsp_t **src;
 	double output_scale = (double)pow(2, 15);
 	// We have local output defined
 	for (i=0 ; i < ppl->local_audio.num_outputs ; i++) {
+		out = &ppl->local_audio.local_output[i];
 		// We need a <short> buffer for the local audio to be compatible with VAC
 		// However, our ring buffer only supports char or float so we pack into a char buffer
-		// The output is interleaved so take the correct left or right output and copy to the temp buffer.
-		// This was stopping 1 short of completion.
-		for (j=0,k=0 ; j <= ptr->dsp_lr_sz - 2 ; j+=2,k+=4) {
-			// First convert and scale to short
-			if 	(strcmp(ppl->local_audio.local_output[i].srctype, LOCAL_IQ) == 0) {
-				// CWSkimmer and WSPR requires/can take - IQ data
-				LorI = (short)(ptr->dec_iq_data[ppl->local_audio.local_output[i].dsp_ch_left][j] * output_scale);
-				RorQ = (short)(ptr->dec_iq_data[ppl->local_audio.local_output[i].dsp_ch_right][j+1] * output_scale);
-			} else {
-				// All the rest require demodulated data
-				LorI = (short)(ptr->dsp_lr_data[ppl->local_audio.local_output[i].dsp_ch_left][j] * output_scale);
-				RorQ = (short)(ptr->dsp_lr_data[ppl->local_audio.local_output[i].dsp_ch_right][j+1] * output_scale);
-				//LorI = (short)(ptr->dsp_lr_data[0][j] * output_scale);
-				//RorQ = (short)(ptr->dsp_lr_data[0][j+1] * output_scale);
-			}
-			// then pack into the char buffer, little endian order
-			f_local_audio[k] = (unsigned char)(LorI & 0xff);
-			f_local_audio[k+1] = (unsigned char)((LorI >> 8) & 0xff);
-			f_local_audio[k+2] = (unsigned char)(RorQ & 0xff);
-			f_local_audio[k+3] = (unsigned char)((RorQ >> 8) & 0xff);
+		// The output is interleaved so take the correct left or right output and pack to the temp buffer.
+		if 	(strcmp(out->srctype, LOCAL_IQ) == 0) {
+			// CWSkimmer and WSPR requires/can take - IQ data
+			src = ptr->dec_iq_data;
+		} else {
+			// All the rest require demodulated data
+			src = ptr->dsp_lr_data;
 		}
+		// Convert, scale and pack into the char buffer, little endian order
+		pcm_pack(src[out->dsp_ch_left], src[out->dsp_ch_right], output_scale, ptr->dsp_lr_sz / 2, (unsigned char *)f_local_audio, 4, PCM_LE);
 		// Take the output from DSP dsp_ch_left and dsp_ch_right and write it to the ring buffer
 		//printf("Ring buffer: %d, %d\n", ringb_write_space(ppl->local_audio.local_output[i].rb_la_out), ptr->dsp_lr_sz * 2);
 		if (ringb_write_space (ppl->local_audio.local_output[i].rb_la_out) >= ptr->dsp_lr_sz*2) {
@@ -602,10 +674,16 @@ static void do_encode(Pipeline *ppl, Transforms *ptr) {
 	int audio_sz = ptr->dsp_lr_sz;
 	int iq_sz = ptr->dsp_iq_sz;
 	Route *routes;
-	int i, src, dest, left, right;
-	short L, R, I, Q;
+	int i, n, remaining, src, left, right;
+	unsigned char *buf;
 	double output_scale = (double)pow(2, 15);
 
+	// We encode in place so there must be space for the whole block in the output frames
+	if (ep2_queue_write_space(eq_out) < ptr->out_smpls) {
+		send_message("c.pipeline", "No space in EP2 output frame queue");
+		return;
+	}
+
 	// Sanity check as we must have both with the same number of samples in order to combine them in the output
 	if(audio_sz == iq_sz) {
 		// Get the audio routing
@@ -626,25 +704,23 @@ static void do_encode(Pipeline *ppl, Transforms *ptr) {
 		}
 
 		// Copy and encode the samples
-		// dsp_lr[n] contains interleaved L/R double samples
-		// dsp_iq contains interleaved I/Q double samples
-		// wr_buff is the output buffer to receive byte data in 16 bit big endian format
+		// dsp_lr[n] contains interleaved L/R dsp_t samples
+		// dsp_iq contains interleaved I/Q dsp_t samples
+		// The output ring write vector receives byte data in 16 bit big endian format
 		// Both audio and IQ data are 16 bit values making 8 bytes in all
-
-		for (dest=0, src=0 ; dest <= ptr->out_sz - 8 ; dest+=8, src+=2) {
-			L = (short)(ptr->dsp_lr_data[left][src] * output_scale);
-			R = (short)(ptr->dsp_lr_data[right][src+1] * output_scale);
-			I = (short)(ptr->dsp_iq_data[src] * output_scale);
-			Q = (short)(ptr->dsp_iq_data[src+1] * output_scale);
-			ptr->out_buff[dest] = (unsigned char)((L >> 8) & 0xff);
-			ptr->out_buff[dest+1] = (unsigned char)(L & 0xff);
-			ptr->out_buff[dest+2] = (unsigned char)((R >> 8) & 0xff);
-			ptr->out_buff[dest+3] = (unsigned char)(R & 0xff);
-
-			ptr->out_buff[dest+4] = (unsigned char)((I >> 8) & 0xff);
-			ptr->out_buff[dest+5] = (unsigned char)(I & 0xff);
-			ptr->out_buff[dest+6] = (unsigned char)((Q >> 8) & 0xff);
-			ptr->out_buff[dest+7] = (unsigned char)(Q & 0xff);
+		// The samples go straight into the payload of the output frames, a run at a time
+		src = 0;
+		remaining = ptr->out_smpls;
+		while (remaining > 0) {
+			buf = ep2_queue_get_write_run(eq_out, &n);
+			if (n > remaining) n = remaining;
+			// L/R then I/Q into each 8 byte sample
+			pcm_pack(ptr->dsp_lr_data[left] + src, ptr->dsp_lr_data[right] + src, output_scale, n, buf, EP2_SMPL_SZ, PCM_BE);
+			pcm_pack(ptr->dsp_iq_data + src, ptr->dsp_iq_data + src, output_scale, n, buf + 4, EP2_SMPL_SZ, PCM_BE);
+			src += n * 2;
+			// Complete frames are published to the writer
+			ep2_queue_write_advance(eq_out, n);
+			remaining -= n;
 		}
 	} else {
 		sprintf(message, "Error, audio_sz %d, iq_sz %d\n", audio_sz, iq_sz);
@@ -29,31 +29,31 @@ The authors can be reached by email at:
 #define _pipeline_h
 
 // Transforms data structure maintains the data transforms between the input and output ring buffers
-// The read size must be divisable by 8 to maintain proper boundaries for decoding as the data is organised
-// as 2x24 bit (I/Q) and 1x16 bit (Mic).
-// Samples are pre-processed so we only have valid samples to process. The in-sz is 1024 bytes which allows
-// for 128 samples which is the minimum DSP block size.
-// All other sizes are calculated as they vary depending on number of receivers and sample rate.
+// The input rings are already decoded by the reader so the pipeline starts with complex dsp_t.
+// dsp_t is double, or float when built with DSP_FLOAT.
+// All sizes are calculated as they vary depending on number of receivers and sample rate.
 typedef struct Transforms {
 
 	// ====================================================================================
-	// Data from the input ring buffers rb_iq_in and rb_mic_in for processing
-	// Format as above 2x24 bit (I/Q), 1x16 bit (Mic)
+	// Data from the input ring buffers rb_iq_in[n] and rb_mic_in for processing
+	// Each receiver has its own ring of interleaved I/Q dsp_t scaled +-1.0.
+	// The mic ring holds complex dsp_t with the imaginary part zero, always at 48K as
+	// the extra samples at higher IQ rates are discarded by the reader.
 	unsigned int in_iq_sz;
-	unsigned char *rd_iq_buff;
+	ringb_data_t iq_vec[MAX_RX][2];
 	unsigned int in_mic_sz;
-	unsigned char *rd_mic_buff;
+	ringb_data_t mic_vec[2];
 
 	// ====================================================================================
 	// Decoded IQ data can be up to 8 receivers
-	// The outputs are scaled as double with a range of +-1.0
-	// Decoded size will depend on the number of receivers
+	// The data pointers point into the rings when the block is contiguous, there is no copy.
+	// Only a block that wraps the end of a ring is copied to the buffer for that receiver.
 	unsigned int dec_iq_sz;
-	double *dec_iq_data[MAX_RX];
-	// Decoded Mic data size is irrespective of number of receivers and is always 48K
-	// However, at IQ sample rates > 48K the extra samples must be discarded.
+	dsp_t *dec_iq_data[MAX_RX];
+	dsp_t *dec_iq_buff[MAX_RX];
 	unsigned int dec_mic_sz;
-	double *dec_mic_data;
+	dsp_t *dec_mic_data;
+	dsp_t *dec_mic_buff;
 
 	// ====================================================================================
 	// Decoded data is fed into the appropriate DSP channel. The DSP operates at blk_sz samples.
@@ -62,10 +62,15 @@ typedef struct Transforms {
 	// equal the input rate as samples are output at 48K
 	// The output samples are left/right channels
 	unsigned int dsp_lr_sz;
-	double *dsp_lr_data[MAX_RX + MAX_TX];
+	dsp_t *dsp_lr_data[MAX_RX + MAX_TX];
 	unsigned int dsp_iq_sz;
-	double *dsp_iq_data;
+	dsp_t *dsp_iq_data;
 	// Note the L/R DSP data is taken directly from these buffers for audio output when using local audio
+#ifdef DSP_FLOAT
+	// Separate I in, Q in, I out, Q out for the single precision exchange
+	int dsp_split_sz;
+	float *dsp_split[4];
+#endif
 
 	// ====================================================================================
 	// Encoding is performed on the appropriate buffer(s) according to the HPSDR audio routing. This may be
@@ -73,9 +78,9 @@ typedef struct Transforms {
 	// The IQ output data is added to give the final format
 	// 16 bit Left, 16 bit Right, 16 bit I, 16 bit Q. A total of 8 bytes being the same size as the input but
 	// a different format
-	// The data is written directly to the output ring buffer rb_out from this buffer.
+	// The data is encoded directly into the payload of the EP2 frames in the output queue eq_out.
 	unsigned int out_sz;
-	unsigned char *out_buff;
+	int out_smpls;
 }Transforms;
 
 // Passed to the pipeline thread
@@ -93,5 +98,8 @@ int pipeline_run_display(int run_state);
 int pipeline_run_local_audio(int run_state);
 int pipeline_stop();
 int pipeline_terminate();
+void pipeline_signal();
+void pipeline_get_stats(PipelineStats *stats);
+void pipeline_reset_stats();
 
 #endif
@@ -27,57 +27,59 @@ bob@bobcowdery.plus.com
 // Includes
 #include "../common/include.h"
 
-void frame_decode(int n_smpls, int n_rx, int rate, int in_sz, char *ptr_in_bytes) {
+// Each complex sample in the input rings is a pair of dsp_t
+#define PAIR_SZ (2 * sizeof(dsp_t))
 
-	/* Perform data exchange
+// Local funcs
+static void write_mic(ringb_data_t *vec, int index, dsp_t value);
+static int local_mic_decode(int n_mic, ringb_data_t *vec);
+
+// Module vars
+// Mic decimation phase, carried between frames
+static int mic_phase = 0;
+
+void frame_decode(int n_smpls, int n_rx, int rate, unsigned char *frame) {
+
+	/* Decode a radio frame directly into the input ring buffers
 	*
 	* Arguments:
 	*  n_smpls			--	number of I/Q samples per frame per receiver
 	*  n_rx				--	number of receivers
 	*  rate				-- 	48000/96000/192000/384000
-	* in_sz				--	size of input data buffer
-	*  ptr_in_bytes   	--  ptr to the input data
+	*  frame			--	the complete EP6 frame as received
 	*/
 
-	// Data exchange operates on the ring buffers.
-	// 	if there is room to add the data the data is written, else the block is skipped
+	// The frame has two sub-frames of n_smpls/2 sample sets. Each set is
+	//	<I2><I1><I0><Q2><Q1><Q0> for each receiver followed by <M1><M0>
+	// For 3 receivers there are 4 padding bytes at the end of each sub-frame which are never reached.
 	//
-	// The data is pre-processed such that only contiguous data is written to the ring buffers
-	// separated into IQ and Mic data.
+	// In one pass over each sub-frame the IQ is converted to complex dsp_t and written to the
+	// ring for its receiver and the mic is converted and written to the mic ring.
+	// The receiver rings are always written and read by the same amount so they stay in step
+	// and share the same write position.
 
 	// The Mic data is repeated at higher sampling rates
 	// 48K = 1, 96K = 2, 192K = 4, 384K = 8
-	// At 1 we take all blocks,
-	// at 2 we take every 2nd block
-	// at 4 we take every 4th block
-	// at 8 we take every 8th block
+	// so we take every mic_blk_sel'th sample set.
 	int mic_blk_sel = rate / 48000;
-	// This is a count of blocks to skip and must be static
-	static int skip_mic_data = 0;
-	int nskip = 0;
-	unsigned int total_iq_bytes;
-	unsigned int total_mic_bytes;
-	unsigned int total_iq_bytes_ct;
-	unsigned int total_mic_bytes_ct;
-	int iq_bytes;
-	int iq_ct;
-	int mic_bytes;
-	int mic_ct;
-	int iq_index;
-	int mic_index;
-	int state;
-	int signal;
-	short sample_input_level;
-	short peak_input_inst;
-	int i, local, ret, write_space, read_space, xfer_sz;
-
-	// Reset the peak input level
-	sample_input_level = 0;
-	peak_input_inst = 0;
-
-	// The total number of IQ bytes to be concatenated
-	total_iq_bytes = n_smpls * n_rx * 6;	// 6 bytes per sample (2 x 24 bit)
-	total_iq_bytes_ct = total_iq_bytes - 1;
+	int stride = n_rx * 6 + 2;
+	int sub_smpls = n_smpls / 2;
+	unsigned int iq_sz = n_smpls * PAIR_SZ;
+	unsigned char *sub_frame[2];
+	ringb_data_t iq_vec[MAX_RX][2];
+	ringb_data_t mic_vec[2];
+	dsp_t *dst_1[MAX_RX];
+	dsp_t *dst_2[MAX_RX];
+	int first_smpls, out, n, f, i, rx, local, ret;
+	size_t len, iq_free = iq_sz;
+	int n_mic;
+	unsigned char *set;
+	short as_short;
+	double input_iq_scale = (double)((double)1.0 / (double)pow(2, 23));
+	double input_mic_scale = (double)((double)1.0 / ((double)pow(2, 15) - (double)1.0));
+
+	sub_frame[0] = frame + START_FRAME_1;
+	sub_frame[1] = frame + START_FRAME_2;
 
 	// Determine if we are using HPSDR or local mic input
 	// Note that for local we let the normal processing run through except when it comes to
@@ -91,89 +93,65 @@ void frame_decode(int n_smpls, int n_rx, int rate, int in_sz, char *ptr_in_bytes
 		}
 	}
 
-	// The total number of Mic bytes to be moved
-	if (mic_blk_sel == 1) {
-		// Take every byte in every frame
-		total_mic_bytes = n_smpls * 2;	// 2 bytes per sample (1 x 16 bit)
-	}
-	else {
-		// Take one frame and leave the other frame
-		// We then skip frames if necessary
-		total_mic_bytes = n_smpls;
-	}
-	total_mic_bytes_ct = total_mic_bytes - 1;
-
 	// First time through allocate buffers
 	if (!allocated) {
-		// Buffer for IQ data
-		iq = (unsigned char *)safealloc(total_iq_bytes, sizeof(char), "IQ_BYTES");
-		// Buffer for mono input data from HPSDR mic (16 bit so 2*char per sample)
-		mic = (unsigned char *)safealloc(ppl->args->general.mic_blk_sz * 2, sizeof(char), "MIC_BYTES");
-		// Buffer for local mic data to overwrite HPSDR mic data (16 bit so 2*char per sample)
-		local_mic = safealloc(ppl->args->general.mic_blk_sz * 2, sizeof(char), "LOCAL_MIC");
+		// Buffer for local mic data (16 bit so 2*char per sample), never more than one sample per set
+		local_mic = safealloc(NUM_SMPLS_1_RADIO * 2, sizeof(char), "LOCAL_MIC");
 		allocated = TRUE;
 	}
 
-	// The number of IQ bytes for each receiver(s) sample
-	iq_bytes = n_rx * 6; //2x24 bit samples per rx
-						 // IQ byte counter
-	iq_ct = iq_bytes;
-	// The number of Mic bytes following receiver sample
-	mic_bytes = 2;
-	// Mic byte counter
-	mic_ct = mic_bytes;
-
-	// Initial state is reading IQ bytes as we always align at the start of IQ data
-	state = IQ;
-
-	// Iterate through every input byte
-	iq_index = 0;
-	mic_index = 0;
-	for (i = 0; i < in_sz; i++) {
-		if (state == IQ) {
-			// Processing IQ bytes
-			if (total_iq_bytes_ct >= 0) {
-				// Still some IQ bytes to process
-				// Pack the byte into iq at the next index
-				iq[iq_index++] = ptr_in_bytes[i];
-				// Dec counter
-				total_iq_bytes_ct--;
-			}
-			if (--iq_ct == 0) {
-				// Exhausted bytes for receiver(s) sample
-				// Set the Mic count and change state
-				mic_ct = mic_bytes;
-				state = MIC;
-			}
+	// IQ
+	// The write vectors describe the free space in place in the rings
+	// The pipeline frees the receiver rings one after another so take the least space of them all
+	for (rx = 0; rx < n_rx; rx++) {
+		ringb_get_write_vector(rb_iq_in[rx], iq_vec[rx]);
+		len = iq_vec[rx][0].len + iq_vec[rx][1].len;
+		if (len < iq_free) {
+			iq_free = len;
+		}
+	}
+	if (iq_free >= iq_sz) {
+		// The free space may wrap the end of the ring, whole samples always fit either side
+		// The rings are written together so the wrap falls at the same sample in each
+		first_smpls = iq_vec[0][0].len / PAIR_SZ;
+		for (rx = 0; rx < n_rx; rx++) {
+			dst_1[rx] = (dsp_t *)iq_vec[rx][0].buf;
+			dst_2[rx] = (dsp_t *)iq_vec[rx][1].buf;
 		}
-		else if (state == MIC) {
-			if (!skip_mic_data) {
-				if (total_mic_bytes_ct >= 0) {
-					// Still some Mic bytes to process
-					// Pack the byte into mic at the next index
-					mic[mic_index++] = ptr_in_bytes[i];
-					// Dec counter
-					total_mic_bytes_ct--;
-				}
+		out = 0;
+		for (f = 0; f < 2; f++) {
+			set = sub_frame[f];
+			n = sub_smpls;
+			if (out < first_smpls) {
+				// Up to the end of the ring
+				i = (n < first_smpls - out) ? n : first_smpls - out;
+				iq_unpack(set, stride, i, n_rx, dst_1, out * 2, input_iq_scale);
+				set += i * stride;
+				n -= i;
+				out += i;
 			}
-			if (--mic_ct == 0) {
-				// Exhausted bytes for Mic sample
-				// Set the IQ count and change state
-				iq_ct = iq_bytes;
-				state = IQ;
+			if (n > 0) {
+				// From the start of the ring
+				iq_unpack(set, stride, n, n_rx, dst_2, (out - first_smpls) * 2, input_iq_scale);
+				out += n;
 			}
 		}
-	}
-
-	// We have now extracted contiguous IQ and Mic samples into separate buffers
-	// Copy the temp buffers into the appropriate ring buffer
-	if (ringb_write_space(rb_iq_in) >= total_iq_bytes) {
-		ringb_write(rb_iq_in, (const char *)iq, total_iq_bytes);
-		signal = TRUE;
+		for (rx = 0; rx < n_rx; rx++) {
+			ringb_write_advance(rb_iq_in[rx], iq_sz);
+		}
 	}
 	else {
 		send_message("c.server", "No write space in IQ ring buffer");
+		return;
+	}
+
+	// Mic
+	// Count the samples this frame contributes, the phase carries over to the next frame
+	n_mic = 0;
+	for (i = mic_phase; i < n_smpls; i += mic_blk_sel) {
+		n_mic++;
 	}
+	ringb_get_write_vector(rb_mic_in, mic_vec);
 	if (local) {
 		// Using local mic input
 		// See if we need to start the stream
@@ -184,66 +162,84 @@ void frame_decode(int n_smpls, int n_rx, int rate, int in_sz, char *ptr_in_bytes
 			}
 			local_input_running = TRUE;
 		}
-		else {
+		else if (mic_vec[0].len + mic_vec[1].len > n_mic * PAIR_SZ) {
 			// Do a transfer from audio input rb to mic rb
-			write_space = ringb_write_space(rb_mic_in);
-			//read_space = ringb_float_read_space (ppl->local_audio.local_input.rb_la_in);
-			read_space = ringb_read_space(ppl->local_audio.local_input.rb_la_in);
-			// The audio data is 16 bit little endian in a character buffer and the required format is 16 bit big endian packed as bytes
-			if (write_space > total_mic_bytes && read_space > total_mic_bytes) {
-				xfer_sz = total_mic_bytes;
-				// Read xfer_sz audio ints to local buffer local_mic
-				ringb_read(ppl->local_audio.local_input.rb_la_in, local_mic, (unsigned int)xfer_sz);
-				// Pack into a big endian byte array
-				for (i = 0; i < xfer_sz; i += 2) {
-					mic[i] = local_mic[i + 1];
-					mic[i + 1] = local_mic[i];
-					// Stash the peak input level for VOX
-					sample_input_level = ((short)local_mic[i + 1] & 0xFF) << 8;
-					sample_input_level = sample_input_level | (((short)local_mic[i]) & 0xFF);
-					if (sample_input_level > peak_input_inst) {
-						peak_input_inst = sample_input_level;
-					}
-					peak_input_level = peak_input_inst;
-				}
-				// Write the data to the ring buffer
-				ringb_write(rb_mic_in, (const char *)mic, xfer_sz);
+			if (local_mic_decode(n_mic, mic_vec)) {
+				ringb_write_advance(rb_mic_in, n_mic * PAIR_SZ);
 			}
 		}
 	}
-	else {
+	else if (mic_vec[0].len + mic_vec[1].len >= n_mic * PAIR_SZ) {
 		// Using the HPSDR mic input
-		if (skip_mic_data == 0) {
-			if (ringb_write_space(rb_mic_in) >= total_mic_bytes) {
-				ringb_write(rb_mic_in, (const char *)mic, total_mic_bytes);
-			}
+		// This 16 bit big endian value follows the IQ bytes in the set
+		// Each sample is added to Real and the Imag is zeroed
+		for (i = mic_phase, n = 0; i < n_smpls; i += mic_blk_sel, n++) {
+			set = sub_frame[i / sub_smpls] + (i % sub_smpls) * stride + n_rx * 6;
+			as_short = (set[1]) | (set[0] << 8);
+			write_mic(mic_vec, n, (dsp_t)(input_mic_scale * (double)as_short));
 		}
+		ringb_write_advance(rb_mic_in, n_mic * PAIR_SZ);
 	}
+	mic_phase = (mic_phase + n_mic * mic_blk_sel) - n_smpls;
 
-	// Set the Mic data skip count
-	switch (mic_blk_sel) {
-	case 4:
-		nskip = 1;
-		break;
-	case 8:
-		nskip = 3;
-		break;
-	default:
-		nskip = 0;
-		break;
-	}
+	// Data was written so signal the pipeline
+	pipeline_signal();
+}
+
+static void write_mic(ringb_data_t *vec, int index, dsp_t value) {
+	/* Write a mic sample as a complex dsp_t with the imaginary part zero
+	*
+	* Arguments:
+	*  vec			--	the write vector of the mic ring
+	*  index		--	sample index from the start of the write vector
+	*  value		--	the real part
+	*/
 
-	if (skip_mic_data == 0) {
-		// This will skip 1 or 3 blocks (block = 2 frames)
-		// Giving 1 in 4 or 1 in 8 frames of data
-		skip_mic_data = nskip;
+	dsp_t *dst;
+	int first_smpls = vec[0].len / PAIR_SZ;
+
+	if (index < first_smpls) {
+		dst = (dsp_t *)vec[0].buf + index * 2;
 	}
 	else {
-		skip_mic_data--;
+		dst = (dsp_t *)vec[1].buf + (index - first_smpls) * 2;
 	}
+	dst[0] = value;
+	dst[1] = 0.0;
+}
+
+static int local_mic_decode(int n_mic, ringb_data_t *vec) {
+	/* Decode local mic input into the mic ring
+	*
+	* Arguments:
+	*  n_mic		--	number of samples to transfer
+	*  vec			--	the write vector of the mic ring
+	*
+	* Returns TRUE if the samples were written.
+	*/
+
+	int i, xfer_sz;
+	short sample_input_level;
+	short peak_input_inst;
+	double input_mic_scale = (double)((double)1.0 / ((double)pow(2, 15) - (double)1.0));
 
-	// If data was copied then signal the pipeline
-	if (signal) {
-		pthread_cond_signal(&pipeline_con);
+	// The audio data is 16 bit little endian in a character buffer
+	xfer_sz = n_mic * 2;
+	if (ringb_read_space(ppl->local_audio.local_input.rb_la_in) <= xfer_sz) {
+		return FALSE;
+	}
+	// Read xfer_sz audio bytes to local buffer local_mic
+	ringb_read(ppl->local_audio.local_input.rb_la_in, local_mic, (unsigned int)xfer_sz);
+	peak_input_inst = 0;
+	for (i = 0; i < n_mic; i++) {
+		sample_input_level = ((short)local_mic[i * 2 + 1] & 0xFF) << 8;
+		sample_input_level = sample_input_level | (((short)local_mic[i * 2]) & 0xFF);
+		// Stash the peak input level for VOX
+		if (sample_input_level > peak_input_inst) {
+			peak_input_inst = sample_input_level;
+		}
+		peak_input_level = peak_input_inst;
+		write_mic(vec, i, (dsp_t)(input_mic_scale * (double)sample_input_level));
 	}
-}
\ No newline at end of file
+	return TRUE;
+}
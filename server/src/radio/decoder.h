@@ -28,4 +28,4 @@ bob@bobcowdery.plus.com
 #include "../common/include.h"
 
 // Prototypes
-void frame_decode(int n_smpls, int n_rx, int rate, int in_sz, char *ptr_in_bytes);
+void frame_decode(int n_smpls, int n_rx, int rate, unsigned char *frame);
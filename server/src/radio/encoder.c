@@ -27,64 +27,206 @@ bob@bobcowdery.plus.com
 // Includes
 #include "../common/include.h"
 
-void encode_output_data(char *data_frame, char *packet_buffer) {
+// Module vars
+// The static parts of an EP2 frame
+static unsigned char ep2_template[FRAME_SZ];
+
+void encoder_init() {
 
 	/*
 	*	<0xEFFE><0x01><End Point><Sequence Number>< 2 x HPSDR frames>
 	*	Where:
-	*		End point = 1 byte[0x02  representing USB EP2]
+	*		End point = 1 byte[0x02 - representing USB EP2]
 	*		Sequence Number = 4 bytes[32 bit unsigned]
 	*		HPSDR data = 1024 bytes[2 x 512 byte USB format frames]
 	*
+	*	Build the frame template with the header and sync bytes.
+	*	The sequence number and CC bytes are patched per frame by encode_output_frame()
+	*	and the payload is written by the pipeline.
+	*/
+
+	memset(ep2_template, 0, FRAME_SZ);
+	// Header
+	ep2_template[0] = 0xef;
+	ep2_template[1] = 0xfe;
+	ep2_template[2] = DATA_PKT;
+	ep2_template[3] = EP2;
+	// First USB frame header
+	memset(ep2_template + FRAME_SYNC_1_OFFSET, 0x7f, 3);
+	// Second USB frame header
+	memset(ep2_template + FRAME_SYNC_2_OFFSET, 0x7f, 3);
+}
+
+void encode_frame_init(unsigned char *packet) {
+
+	/* Initialise a frame buffer from the template
+	*
+	* Arguments:
+	*  packet	--	frame buffer of FRAME_SZ bytes
+	*
+	*	The payload is silent.
+	*/
+
+	memcpy(packet, ep2_template, FRAME_SZ);
+}
+
+void encode_output_frame(unsigned char *packet) {
+
+	/* Patch the per frame fields of a frame in place
+	*
+	* Arguments:
+	*  packet	--	frame buffer initialised from the template with the payload in place
+	*
 	*	The following fields are merged :
-	*		metis_header
 	*		out_seq		-- next output sequence number to use
-	*		cc_out 		-- round robin control bytes
-	*		usb_header +
-	*		proc_data	-- 2 frames worth of USB format frames
+	*		cc_out 		-- round robin control bytes for each USB frame
+	*/
+
+	// Sequence number
+	memcpy(packet + FRAME_SEQ_OFFSET, next_ep2_seq(), 4);
+	// First USB frame CC bytes
+	memcpy(packet + FRAME_CC_1_OFFSET, cc_out_next_seq(), 5);
+	// Second USB frame CC bytes
+	memcpy(packet + FRAME_CC_2_OFFSET, cc_out_next_seq(), 5);
+}
+
+// ===========================================================================
+// EP2 frame queue
+ep2_queue_t *ep2_queue_create(size_t n_frames) {
+
+	/* Create a queue of n_frames frames
+	*
+	* Arguments:
+	*  n_frames	--	queue size, must be a power of 2
 	*
-	*	Data is encoded into the packet buffer
+	*	One frame is always left free so n_frames - 1 can be queued.
 	*/
 
-	int i,j;
-	char *cc;
+	ep2_queue_t *eq;
+	size_t i;
 
-	// Header
-	packet_buffer[0] = 0xef;
-	packet_buffer[1] = 0xfe;
-	packet_buffer[2] = DATA_PKT;
-	packet_buffer[3] = EP2;
-	// Sequence number
-	char *seq = next_ep2_seq();
-	for( i = FRAME_SEQ_OFFSET, j=0 ; i < FRAME_SEQ_OFFSET+4 ; i++,j++ ) {
-		packet_buffer[i] = seq[j];
+	eq = (ep2_queue_t *)safealloc(sizeof(ep2_queue_t), sizeof(char), "EP2_QUEUE_STRUCT");
+	eq->n_frames = n_frames;
+	eq->mask = n_frames - 1;
+	eq->frames = (unsigned char *)safealloc(n_frames * FRAME_SZ, sizeof(char), "EP2_QUEUE_FRAMES");
+	for (i = 0; i < n_frames; i++) {
+		encode_frame_init(eq->frames + i * FRAME_SZ);
 	}
-	// First USB frame
-	// Frame header
-	for( i = FRAME_SYNC_1_OFFSET ; i < FRAME_SYNC_1_OFFSET+3 ; i++ ) {
-		packet_buffer[i] = 0x7f;
-	}
-	// CC bytes
-	cc = cc_out_next_seq();
-	for (i = FRAME_CC_1_OFFSET, j=0 ; i < FRAME_CC_1_OFFSET + 5; i++,j++) {
-		packet_buffer[i] = cc[j];
-	}
-	// Frame data
-	for (i = START_FRAME_1, j = 0; i < END_FRAME_1; i++, j++) {
-		packet_buffer[i] = data_frame[j];
-	}
-	// Second USB frame
-	// Frame header
-	for (i = FRAME_SYNC_2_OFFSET ; i < FRAME_SYNC_2_OFFSET + 3 ; i++) {
-		packet_buffer[i] = 0x7f;
-	}
-	// CC bytes
-	cc = cc_out_next_seq();
-	for (i = FRAME_CC_2_OFFSET, j = 0 ; i < FRAME_CC_2_OFFSET + 5 ; i++, j++) {
-		packet_buffer[i] = cc[j];
+	ep2_queue_reset(eq);
+	return eq;
+}
+
+void ep2_queue_free(ep2_queue_t *eq) {
+	safefree((char *)eq->frames);
+	safefree((char *)eq);
+}
+
+void ep2_queue_reset(ep2_queue_t *eq) {
+	// Not thread safe
+	eq->offset = 0;
+	ringb_store_release(&eq->wptr, 0);
+	ringb_store_release(&eq->rptr, 0);
+}
+
+int ep2_queue_write_space(ep2_queue_t *eq) {
+
+	/* Samples that can be written
+	*
+	* Arguments:
+	*  eq	--	the queue
+	*
+	*	Producer side.
+	*/
+
+	size_t w = ringb_load_relaxed(&eq->wptr);
+	size_t r = ringb_load_acquire(&eq->rptr);
+	size_t used = (w - r + eq->n_frames) & eq->mask;
+
+	// Whole frames free including the one being filled, less what is already in it
+	return (int)(((eq->n_frames - 1 - used) * EP2_PAYLOAD_SZ - eq->offset) / EP2_SMPL_SZ);
+}
+
+unsigned char *ep2_queue_get_write_run(ep2_queue_t *eq, int *n_smpls) {
+
+	/* Get the next contiguous run of sample space
+	*
+	* Arguments:
+	*  eq		--	the queue
+	*  n_smpls	--	receives the number of samples in the run
+	*
+	*	A run ends at the end of a USB frame payload. Check ep2_queue_write_space() first.
+	*	Producer side.
+	*/
+
+	unsigned char *packet = eq->frames + ringb_load_relaxed(&eq->wptr) * FRAME_SZ;
+
+	if (eq->offset < DATA_SZ) {
+		*n_smpls = (DATA_SZ - eq->offset) / EP2_SMPL_SZ;
+		return packet + START_FRAME_1 + eq->offset;
 	}
-	// Frame data
-	for (i = START_FRAME_2, j = DATA_SZ ; i < END_FRAME_2 ; i++, j++) {
-		packet_buffer[i] = data_frame[j];
+	*n_smpls = (EP2_PAYLOAD_SZ - eq->offset) / EP2_SMPL_SZ;
+	return packet + START_FRAME_2 + (eq->offset - DATA_SZ);
+}
+
+void ep2_queue_write_advance(ep2_queue_t *eq, int n_smpls) {
+
+	/* Mark samples written and publish the frame when it is full
+	*
+	* Arguments:
+	*  eq		--	the queue
+	*  n_smpls	--	samples written, no more than the last run
+	*
+	*	Producer side.
+	*/
+
+	eq->offset += n_smpls * EP2_SMPL_SZ;
+	if (eq->offset >= EP2_PAYLOAD_SZ) {
+		eq->offset = 0;
+		// The payload must be visible before the frame is
+		ringb_store_release(&eq->wptr, (ringb_load_relaxed(&eq->wptr) + 1) & eq->mask);
 	}
 }
+
+int ep2_queue_read_space(ep2_queue_t *eq) {
+
+	/* Complete frames ready to send
+	*
+	* Arguments:
+	*  eq	--	the queue
+	*
+	*	Consumer side.
+	*/
+
+	size_t w = ringb_load_acquire(&eq->wptr);
+	size_t r = ringb_load_relaxed(&eq->rptr);
+
+	return (int)((w - r + eq->n_frames) & eq->mask);
+}
+
+unsigned char *ep2_queue_get_frame(ep2_queue_t *eq, int index) {
+
+	/* Get a ready frame in place
+	*
+	* Arguments:
+	*  eq		--	the queue
+	*  index	--	frame index from the read position, less than ep2_queue_read_space()
+	*
+	*	Consumer side.
+	*/
+
+	return eq->frames + ((ringb_load_relaxed(&eq->rptr) + index) & eq->mask) * FRAME_SZ;
+}
+
+void ep2_queue_read_advance(ep2_queue_t *eq, int n_frames) {
+
+	/* Release sent frames back to the producer
+	*
+	* Arguments:
+	*  eq		--	the queue
+	*  n_frames	--	frames sent
+	*
+	*	Consumer side.
+	*/
+
+	ringb_store_release(&eq->rptr, (ringb_load_relaxed(&eq->rptr) + n_frames) & eq->mask);
+}
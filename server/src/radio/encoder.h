@@ -27,5 +27,39 @@ bob@bobcowdery.plus.com
 // Includes
 #include "../common/include.h"
 
+// Bytes of output per sample, 16 bit L/R audio and 16 bit I/Q
+#define EP2_SMPL_SZ 8
+// Payload bytes per frame, 2 USB frames
+#define EP2_PAYLOAD_SZ (DATA_SZ * 2)
+
+// A single producer, single consumer queue of complete EP2 frames.
+// The producer writes samples straight into the payload of the frame at wptr and
+// publishes it when full. The consumer patches the sequence and CC bytes in place and
+// sends the frame from where it lies. The static bytes are written once when the queue
+// is created and never touched again.
+typedef struct ep2_queue {
+	unsigned char *frames;
+	size_t n_frames;
+	size_t mask;
+	// Producer byte offset into the payload of the frame at wptr
+	int offset;
+	char pad0[RINGB_CACHE_LINE];
+	ringb_index_t wptr;
+	char pad1[RINGB_CACHE_LINE];
+	ringb_index_t rptr;
+	char pad2[RINGB_CACHE_LINE];
+} ep2_queue_t;
+
 // Prototypes
-void encode_output_data(char *data_frame, char *packet_buffer);
\ No newline at end of file
+void encoder_init();
+void encode_frame_init(unsigned char *packet);
+void encode_output_frame(unsigned char *packet);
+ep2_queue_t *ep2_queue_create(size_t n_frames);
+void ep2_queue_free(ep2_queue_t *eq);
+void ep2_queue_reset(ep2_queue_t *eq);
+int ep2_queue_write_space(ep2_queue_t *eq);
+unsigned char *ep2_queue_get_write_run(ep2_queue_t *eq, int *n_smpls);
+void ep2_queue_write_advance(ep2_queue_t *eq, int n_smpls);
+int ep2_queue_read_space(ep2_queue_t *eq);
+unsigned char *ep2_queue_get_frame(ep2_queue_t *eq, int index);
+void ep2_queue_read_advance(ep2_queue_t *eq, int n_frames);
\ No newline at end of file
@@ -32,8 +32,6 @@ int input_samplerate = 48000;
 int output_samplerate = 48000;
 
 // Temporary buffers
-unsigned char *iq = NULL;
-unsigned char *mic = NULL;
 char *local_mic = NULL;
 float *pan = NULL;
 int pan_sz_r1;
@@ -53,9 +51,10 @@ Pipeline *ppl = NULL;
 AudioDefault audioDefault;
 
 // Ring buffers
-ringb_t *rb_iq_in;
+ringb_t *rb_iq_in[MAX_RX];
 ringb_t *rb_mic_in;
-ringb_t *rb_out;
+// Output frames
+ep2_queue_t *eq_out;
 
 // Condition variable
 pthread_mutex_t pipeline_mutex = PTHREAD_MUTEX_INITIALIZER;
@@ -25,28 +25,56 @@ The authors can be reached by email at:
 */
 
 // Includes
+#if defined(linux)
+	// For recvmmsg()
+	#define _GNU_SOURCE
+#endif
 #include "../common/include.h"
 
 // Local funcs
 static void udprecvdata(UDPReaderThreadData* td);
+static void process_frame(UDPReaderThreadData* td, unsigned char *frame, int n);
+#ifdef linux
+static void record_timestamp(UDPReaderThreadData* td, struct msghdr *hdr);
+#endif
 
 // Module vars
-unsigned char frame[FRAME_SZ];
-unsigned char frame_data[DATA_SZ * 2];
+// Receive buffers, one frame per slot of the batch
+static unsigned char frames[MAX_RX_BATCH][FRAME_SZ];
+#ifdef linux
+static struct mmsghdr msgs[MAX_RX_BATCH];
+static struct iovec iovecs[MAX_RX_BATCH];
+static char ctrl[MAX_RX_BATCH][CMSG_SPACE(sizeof(struct timespec))];
+#endif
+// Receive statistics, written only by the reader thread
+ReaderStats rdr_stats;
+// Last kernel timestamp
+static struct timespec last_ts;
 // Threads
 pthread_t reader_thd;
 // Structure pointers
 UDPReaderThreadData *udp_reader_td = NULL;
 
 // Initialise reader thread
-void reader_init(int sd, struct sockaddr_in *srv_addr, int num_rx, int rate) {
+void reader_init(int sd, int num_rx, int rate, int batch_sz) {
 	/* Initialise reader
 	*
 	* Arguments:
+	*  sd			--	the radio socket
+	*  num_rx		--	number of receivers
+	*  rate			--	IQ sample rate
+	*  batch_sz		--	maximum frames to take per receive call
 	*
 	*/
 
 	int rc;
+#ifdef linux
+	int on = 1;
+#endif
+
+	// Select the IQ decoder for this CPU
+	iq_unpack_init();
+	printf("c.server: IQ decoder using %s\n", iq_unpack_name());
 
 	// Allocate thread data structure
 	udp_reader_td = (ThreadData *)safealloc(sizeof(UDPReaderThreadData), sizeof(char), "READER_TD_STRUCT");
@@ -56,7 +84,26 @@ void reader_init(int sd, struct sockaddr_in *srv_addr, int num_rx, int rate) {
 	udp_reader_td->socket= sd;
 	udp_reader_td->num_rx = num_rx;
 	udp_reader_td->rate = rate;
-	udp_reader_td->srv_addr = srv_addr;
+	if (batch_sz < 1)
+		batch_sz = 1;
+	else if (batch_sz > MAX_RX_BATCH)
+		batch_sz = MAX_RX_BATCH;
+	udp_reader_td->batch_sz = batch_sz;
+	// Nominal time between frames, each frame carries num_smpls sample sets
+	if (num_rx == 2)
+		udp_reader_td->frame_ns = (long long)NUM_SMPLS_2_RADIO * 1000000000LL / rate;
+	else if (num_rx == 3)
+		udp_reader_td->frame_ns = (long long)NUM_SMPLS_3_RADIO * 1000000000LL / rate;
+	else
+		udp_reader_td->frame_ns = (long long)NUM_SMPLS_1_RADIO * 1000000000LL / rate;
+	reader_reset_stats();
+
+#ifdef linux
+	// Ask the kernel to timestamp each frame on arrival
+	if (setsockopt(sd, SOL_SOCKET, SO_TIMESTAMPNS, (const char*)&on, sizeof(on)) == -1) {
+		printf("Failed to set option SO_TIMESTAMPNS!\n");
+	}
+#endif
 	
 	// Create the reader thread
 	rc = pthread_create(&reader_thd, NULL, udp_reader_imp, (void *)udp_reader_td);
@@ -120,104 +167,213 @@ void *udp_reader_imp(void* data){
     return NULL;
 }
 
+void reader_get_stats(ReaderStats *stats) {
+	/* Get a snapshot of the receive statistics
+	*
+	* Arguments:
+	*  stats	--	receives the statistics
+	*
+	*/
+
+	*stats = rdr_stats;
+}
+
+void reader_reset_stats() {
+	/* Reset the receive statistics
+	*
+	* Arguments:
+	*
+	*/
+
+	memset(&rdr_stats, 0, sizeof(ReaderStats));
+	last_ts.tv_sec = 0;
+	last_ts.tv_nsec = 0;
+}
+
+#ifdef linux
 static void udprecvdata(UDPReaderThreadData* td) {
 
-    int i,j,n;
-    unsigned char acc[DATA_SZ*2];
+	/* Receive loop
+	*
+	* Arguments:
+	*  td	--	the thread data
+	*
+	* Frames are taken in batches of up to batch_sz per call. The call blocks until
+	* at least one frame has arrived and then returns with whatever else is queued so
+	* the batch fills up when we fall behind and costs nothing extra when we keep up.
+	* The socket receive timeout lets us see a stop or terminate.
+	*/
+
+	int i, n;
+	int sd = td->socket;
+	int batch_sz = td->batch_sz;
 
-	int num_rx = td->num_rx;
-	int rate = td->rate;
+	// Loop receiving stream from radio
+	while (td->run && !td->terminate) {
+		// The kernel updates the lengths so reset them for every call
+		for (i = 0; i < batch_sz; i++) {
+			iovecs[i].iov_base = frames[i];
+			iovecs[i].iov_len = FRAME_SZ;
+			msgs[i].msg_hdr.msg_iov = &iovecs[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+			msgs[i].msg_hdr.msg_name = &td->from_addr;
+			msgs[i].msg_hdr.msg_namelen = sizeof(td->from_addr);
+			msgs[i].msg_hdr.msg_control = ctrl[i];
+			msgs[i].msg_hdr.msg_controllen = sizeof(ctrl[i]);
+			msgs[i].msg_hdr.msg_flags = 0;
+			msgs[i].msg_len = 0;
+		}
+		n = recvmmsg(sd, msgs, batch_sz, MSG_WAITFORONE, NULL);
+		if (n == -1) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+				// Timeout
+				rdr_stats.timeouts++;
+			}
+			else {
+				// Problem
+				printf("udp_reader: Error %d\n", errno);
+				sleep(1);
+			}
+			continue;
+		}
+		// Batching statistics
+		rdr_stats.syscalls++;
+		rdr_stats.frames += n;
+		rdr_stats.last_batch = n;
+		if (n > rdr_stats.max_batch) {
+			rdr_stats.max_batch = n;
+		}
+		for (i = 0; i < n; i++) {
+			record_timestamp(td, &msgs[i].msg_hdr);
+			process_frame(td, frames[i], msgs[i].msg_len);
+		}
+	}
+}
+
+static void record_timestamp(UDPReaderThreadData* td, struct msghdr *hdr) {
+
+	/* Track the arrival jitter from the kernel timestamp of a frame
+	*
+	* Arguments:
+	*  td	--	the thread data
+	*  hdr	--	the received message header
+	*
+	*/
+
+	struct cmsghdr *cmsg;
+	struct timespec ts;
+	long long gap, dev;
+
+	for (cmsg = CMSG_FIRSTHDR(hdr); cmsg != NULL; cmsg = CMSG_NXTHDR(hdr, cmsg)) {
+		if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+			memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+			if (last_ts.tv_sec != 0 || last_ts.tv_nsec != 0) {
+				gap = (long long)(ts.tv_sec - last_ts.tv_sec) * 1000000000LL + (ts.tv_nsec - last_ts.tv_nsec);
+				dev = gap - td->frame_ns;
+				if (dev < 0)
+					dev = -dev;
+				rdr_stats.ts_frames++;
+				rdr_stats.jitter_sum_ns += dev;
+				if (dev > rdr_stats.max_jitter_ns) {
+					rdr_stats.max_jitter_ns = dev;
+				}
+			}
+			last_ts = ts;
+			break;
+		}
+	}
+}
+#else
+static void udprecvdata(UDPReaderThreadData* td) {
+
+	/* Receive loop
+	*
+	* Arguments:
+	*  td	--	the thread data
+	*
+	* One frame per call.
+	*/
+
+	int n;
 	int sd = td->socket;
-	struct sockaddr_in *srv_addr = td->srv_addr;
-	int addr_sz = sizeof(*srv_addr);
-	char seq[4];
+	int addr_sz = sizeof(td->from_addr);
 	fd_set read_fd;
-	FD_ZERO(&read_fd);
-	FD_CLR(0, &read_fd);
-	FD_SET(sd, &read_fd);
 	struct timeval tv;
-	tv.tv_sec = 2;
-	tv.tv_usec = 0;
 	int sel_result;
 
 	// Loop receiving stream from radio
 	while (td->run && !td->terminate) {
 		// Wait for data available
-		sel_result = select(0, &read_fd, NULL, NULL, &tv);
-#ifdef linux
-		if (sel_result == -1) {
-			// Error
-			printf("udp_reader: Error\n");
-			continue;
-		}
-#else
+		// select() modifies the set and timeout so set them up every time
+		FD_ZERO(&read_fd);
+		FD_SET(sd, &read_fd);
+		tv.tv_sec = 2;
+		tv.tv_usec = 0;
+		sel_result = select(sd + 1, &read_fd, NULL, NULL, &tv);
 		if (sel_result == 0) {
 			// Timeout
+			rdr_stats.timeouts++;
 			printf("udp_reader: Timeout\n");
 			continue;
 		}
-#endif
-#ifdef linux
-		else if (sel_result == SO_ERROR) {
-			// Problem
-			sleep(1);
-			//send_message("c.server", "Error in read:"); 
-		}
-#else
 		else if (sel_result == SOCKET_ERROR) {
 			// Problem
 			Sleep(5);
 			//send_message("c.server", "Error in read:"); 
 		}
-#endif
 		else {
 			// Read a frame size data packet
-			n = recvfrom(sd, (char*)frame, FRAME_SZ, 0, (struct sockaddr*)srv_addr, &addr_sz);
-			if (n == FRAME_SZ) {
-				if (frame[3] == EP6) {
-					// We have a frame
-					// First 8 bytes are the header, then 2x512 bytes of data
-					// The sync and cc bytes are the start of each data frame
-					//
-					// Extract and check the sequence number
-					//  2    1   1   4
-					// Sync Cmd End Seq
-					check_ep6_seq(frame + 4);
-					// Extract data
-					// For 1,2 radios the entire dataframe is used
-					// For 3 radios there are 4 padding bytes in each frame
-					int end_frame_1 = END_FRAME_1;
-					int end_frame_2 = END_FRAME_2;
-					int data_sz = DATA_SZ * 2;
-					int num_smpls = NUM_SMPLS_1_RADIO;
-					if (num_rx == 2) {
-						num_smpls = NUM_SMPLS_2_RADIO;
-					}
-					else if (num_rx == 3) {
-						end_frame_1 -= 4;
-						end_frame_2 -= 4;
-						data_sz -= 8;
-						num_smpls = NUM_SMPLS_3_RADIO;
-					}
-					for (i = START_FRAME_1, j = 0; i <= end_frame_1; i++, j++) {
-						frame_data[j] = frame[i];
-					}
-					for (i = START_FRAME_2, j = data_sz/2; i <= end_frame_2; i++, j++) {
-						frame_data[j] = frame[i];
-					}
-					// Decode the frame and dispatch for processing 
-					frame_decode(num_smpls, num_rx, rate, data_sz, frame_data);
-					// Write direct in same thread
-					write_data(sd, srv_addr);
-				}
-				else if (frame[3] == EP4) {
-					// Wideband data
-				}
+			n = recvfrom(sd, (char*)frames[0], FRAME_SZ, 0, (struct sockaddr*)&td->from_addr, &addr_sz);
+			rdr_stats.syscalls++;
+			rdr_stats.frames++;
+			rdr_stats.last_batch = rdr_stats.max_batch = 1;
+			process_frame(td, frames[0], n);
+		}
+	}
+}
+#endif
+
+static void process_frame(UDPReaderThreadData* td, unsigned char *frame, int n) {
+
+	/* Process one received frame
+	*
+	* Arguments:
+	*  td		--	the thread data
+	*  frame	--	the frame data
+	*  n		--	bytes received
+	*
+	*/
+
+	int num_rx = td->num_rx;
+	int num_smpls;
+
+	if (n == FRAME_SZ) {
+		if (frame[3] == EP6) {
+			// We have a frame
+			// First 8 bytes are the header, then 2x512 bytes of data
+			// The sync and cc bytes are the start of each data frame
+			//
+			// Extract and check the sequence number
+			//  2    1   1   4
+			// Sync Cmd End Seq
+			check_ep6_seq(frame + 4);
+			// Decode the frame in place and dispatch for processing
+			// For 3 radios there are 4 padding bytes in each sub-frame which the decoder skips
+			num_smpls = NUM_SMPLS_1_RADIO;
+			if (num_rx == 2) {
+				num_smpls = NUM_SMPLS_2_RADIO;
 			}
-			else {
-				printf("Small frame %d\n", n);
-				Sleep(50);
+			else if (num_rx == 3) {
+				num_smpls = NUM_SMPLS_3_RADIO;
 			}
+			frame_decode(num_smpls, num_rx, td->rate, frame);
+		}
+		else if (frame[3] == EP4) {
+			// Wideband data
 		}
 	}
+	else {
+		printf("Small frame %d\n", n);
+		Sleep(50);
+	}
 }
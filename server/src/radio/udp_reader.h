@@ -38,14 +38,18 @@ typedef struct UDPReaderThreadData {
 	int num_rx;
 	int rate;
 	int socket;
-	struct sockaddr_in *srv_addr;
+	struct sockaddr_in from_addr;	// Sender of each received frame, the radio address is never written here
+	int batch_sz;			// Most frames to take per receive call
+	long long frame_ns;		// Nominal time between frames
 }UDPReaderThreadData;
 
 // Prototypes
-void reader_init(int sd, struct sockaddr_in *srv_addr, int num_rx, int rate);
+void reader_init(int sd, int num_rx, int rate, int batch_sz);
 void *udp_reader_imp(void* data);
 void reader_start();
 void reader_stop();
 void reader_terminate();
+void reader_get_stats(ReaderStats *stats);
+void reader_reset_stats();
 
 #endif
@@ -25,54 +25,371 @@ The authors can be reached by email at:
 */
 
 // Includes
+#if defined(linux)
+	// For sendmmsg()
+	#define _GNU_SOURCE
+#endif
 #include "../common/include.h"
 
+// Local funcs
+static void udpsenddata(UDPWriterThreadData* td);
+static unsigned char *next_frame(int index, int ready);
+static int send_frames(UDPWriterThreadData* td, int n);
+static long long now_ns();
+static void sleep_until(long long deadline);
+
 // Module vars
-unsigned char frame[FRAME_SZ];
-unsigned char frame_data[DATA_SZ * 2];
+// Silent frame for priming and underruns
+static unsigned char silent_frame[FRAME_SZ];
+#ifdef linux
+static struct mmsghdr tx_msgs[MAX_TX_BURST];
+static struct iovec tx_iovecs[MAX_TX_BURST];
+#endif
+// The writer thread's own copy of the radio address
+static struct sockaddr_in tx_addr;
+// Set when output data has been seen so the start up is not counted as underruns
+static int tx_primed = FALSE;
+// Silent frames still to send once output first appears
+static int tx_prime_left = TX_PRIME_FRAMES;
+// Threads
+pthread_t writer_thd;
+pthread_mutex_t writer_mutex = PTHREAD_MUTEX_INITIALIZER;
+// Structure pointers
+UDPWriterThreadData *udp_writer_td = NULL;
+// Transmit statistics, written only by the writer thread
+WriterStats wtr_stats;
 
 // Initialise writer thread
-void writer_init(int sd, struct sockaddr_in *srv_addr) {
+int writer_init(int sd, int rate, int blk_smpls) {
 	/* Initialise writer
 	*
 	* Arguments:
+	*  sd			--	the radio socket
+	*  rate			--	output sample rate
+	*  blk_smpls	--	samples the pipeline outputs per block
 	*
+	* Returns FALSE if the writer thread cannot be created
 	*/
 
 	int rc;
 
-	// Clear data arrays
-	memset(frame, 0, sizeof(frame));
-	memset(frame_data, 0, sizeof(frame_data));
+	// Silent frame from the template
+	encode_frame_init(silent_frame);
+
+	// Allocate thread data structure
+	udp_writer_td = (UDPWriterThreadData *)safealloc(sizeof(UDPWriterThreadData), sizeof(char), "WRITER_TD_STRUCT");
+	// Init the thread data
+	udp_writer_td->run = FALSE;
+	udp_writer_td->terminate = FALSE;
+	udp_writer_td->socket = sd;
+	// Each frame carries 2 x 63 samples for the radio to play out at the output rate
+	udp_writer_td->period_ns = (long long)NUM_SMPLS_1_RADIO * 1000000000LL / rate;
+	// The pipeline adds its output a block at a time
+	udp_writer_td->block_frames = (blk_smpls + NUM_SMPLS_1_RADIO - 1) / NUM_SMPLS_1_RADIO;
+	writer_reset_stats();
+
+	// Create the writer thread
+	rc = pthread_create(&writer_thd, NULL, udp_writer_imp, (void *)udp_writer_td);
+	if (rc) {
+		return FALSE;
+	}
 
 	return TRUE;
 }
 
+// Start writer thread
+void writer_start(struct sockaddr_in *srv_addr) {
+	/* Start sending to the radio
+	*
+	* Arguments:
+	*  srv_addr		--	the radio address, copied as the writer must not share it
+	*
+	*/
+
+	pthread_mutex_lock(&writer_mutex);
+	tx_primed = FALSE;
+	tx_prime_left = TX_PRIME_FRAMES;
+	udp_writer_td->srv_addr = *srv_addr;
+	udp_writer_td->run = TRUE;
+	pthread_mutex_unlock(&writer_mutex);
+}
+
+// Stop writer thread
+void writer_stop() {
+	udp_writer_td->run = FALSE;
+}
+
+// Terminate the writer
+void writer_terminate() {
+	/* Terminate writer thread
+	*
+	* Arguments:
+	*
+	*/
+
+	udp_writer_td->run = FALSE;
+	udp_writer_td->terminate = TRUE;
+
+	// Wait for the thread to exit
+	pthread_join(writer_thd, NULL);
+
+	// Free thread data
+	safefree((char *)udp_writer_td);
+	udp_writer_td = NULL;
+}
+
+void writer_get_stats(WriterStats *stats) {
+	/* Get a snapshot of the transmit statistics
+	*
+	* Arguments:
+	*  stats	--	receives the statistics
+	*
+	*/
+
+	*stats = wtr_stats;
+}
+
+void writer_reset_stats() {
+	/* Reset the transmit statistics
+	*
+	* Arguments:
+	*
+	*/
+
+	memset(&wtr_stats, 0, sizeof(WriterStats));
+}
+
 // Prime radio
 void prime_radio(int sd, struct sockaddr_in *srv_addr) {
 	// Send a few data frames with cc data to initialise the radio
 	for (int i = 0; i < 4; i++) {
-		// Encode into a frame
-		encode_output_data(frame_data, frame);
+		// Patch the frame
+		encode_output_frame(silent_frame);
 		// Dispatch to radio
-		if (sendto(sd, (const char*)frame, FRAME_SZ, 0, (struct sockaddr*) srv_addr, sizeof(*srv_addr)) == -1) {
+		if (sendto(sd, (const char*)silent_frame, FRAME_SZ, 0, (struct sockaddr*) srv_addr, sizeof(*srv_addr)) == -1) {
 			printf("UDP prime failed!\n");
 		}
 	}
 }
 
-// Send next packet to radio
-void write_data(int sd, struct sockaddr_in *srv_addr) {
-	if (ringb_read_space(rb_out) >= DATA_SZ * 2) {
-		// Enough to satisfy the required output block
-		ringb_read(rb_out, frame_data, DATA_SZ * 2);
-		// Encode into a frame
-		encode_output_data(frame_data, frame);
-		// Dispatch to radio
-		if (sendto(sd, (const char*)frame, FRAME_SZ, 0, (struct sockaddr*) srv_addr, sizeof(*srv_addr)) == -1) {
+// Thread entry point for processing
+void *udp_writer_imp(void* data) {
+	// Get our thread parameters
+	UDPWriterThreadData* td = (UDPWriterThreadData*)data;
+
+	printf("c.server: Started UDP writer thread\n");
+
+	while (!td->terminate) {
+		if (td->run && !td->terminate) {
+			// While running we stay in the transmit loop
+			udpsenddata(td);
+		}
+		else {
+			Sleep(100);
+		}
+	}
+
+	printf("c.server: UDP Writer thread exiting...\n");
+	return NULL;
+}
+
+static void udpsenddata(UDPWriterThreadData* td) {
+
+	/* Transmit loop
+	*
+	* Arguments:
+	*  td	--	the thread data
+	*
+	* Frames are sent on a schedule of absolute deadlines one frame period apart
+	* so the radio is fed at the rate it plays out regardless of receive jitter.
+	* If we wake late every frame that fell due is sent in one burst. If the output
+	* ring runs dry a silent frame is sent so the radio and the CC bytes keep going.
+	* The host and radio clocks differ slightly so if output builds up beyond
+	* TX_MAX_BACKLOG frames an extra frame is sent to hold the latency down.
+	* The pipeline adds a block of frames at once so the backlog is judged at its
+	* low point over a block period, just after a block it is always high.
+	* Frames the socket did not take stay queued and are owed to the next tick.
+	*/
+
+	long long deadline, now, late;
+	int due, owed = 0, slip = 0;
+	int backlog, min_backlog = 0, ticks = 0;
+
+	// Take the address writer_start() left for us
+	pthread_mutex_lock(&writer_mutex);
+	tx_addr = td->srv_addr;
+	pthread_mutex_unlock(&writer_mutex);
+	deadline = now_ns();
+	while (td->run && !td->terminate) {
+		sleep_until(deadline);
+		now = now_ns();
+		// Frames due including any we slept through
+		late = now - deadline;
+		due = 1 + (int)(late / td->period_ns);
+		if (due > MAX_TX_BURST) {
+			// Too far behind to catch up, start the schedule again from now
+			wtr_stats.resyncs++;
+			due = MAX_TX_BURST;
+			deadline = now;
+		}
+		else {
+			deadline += due * td->period_ns;
+		}
+		// Frames that failed to go last tick and any slip for drift
+		due += owed + slip;
+		slip = 0;
+		if (due > MAX_TX_BURST) {
+			due = MAX_TX_BURST;
+		}
+		if (late > wtr_stats.max_late_ns) {
+			wtr_stats.max_late_ns = late;
+		}
+		owed = send_frames(td, due);
+		// Drift correction, one frame early when the low point of the last block period stayed high
+		backlog = ep2_queue_read_space(eq_out);
+		if (ticks == 0 || backlog < min_backlog) {
+			min_backlog = backlog;
+		}
+		if (++ticks > td->block_frames) {
+			if (tx_primed && min_backlog >= TX_MAX_BACKLOG) {
+				wtr_stats.slips++;
+				slip = 1;
+			}
+			ticks = 0;
+		}
+	}
+}
+
+static unsigned char *next_frame(int index, int ready) {
+
+	/* Get the next frame to send in place
+	*
+	* Arguments:
+	*  index	--	index of the frame from the read position
+	*  ready	--	number of frames ready
+	*
+	* Returns the frame or the silent frame if the output has run dry.
+	*/
+
+	unsigned char *packet;
+
+	if (index < ready) {
+		packet = ep2_queue_get_frame(eq_out, index);
+		tx_primed = TRUE;
+	}
+	else {
+		packet = silent_frame;
+		if (tx_primed) {
+			wtr_stats.underruns++;
+		}
+	}
+	// Patch the sequence number and CC bytes
+	encode_output_frame(packet);
+	return packet;
+}
+
+static int send_frames(UDPWriterThreadData* td, int n) {
+
+	/* Send a burst of frames
+	*
+	* Arguments:
+	*  td	--	the thread data
+	*  n	--	number of frames
+	*
+	* The silent frame is patched per send so if the output runs dry part way
+	* through the burst it ends with one silent frame.
+	* Returns the number of frames the socket did not take. Only the frames
+	* that were sent are released from the output queue.
+	*/
+
+	int i, sent, ready;
+	unsigned char *packet;
+
+	// Frames are sent from where they lie in the output queue
+	ready = ep2_queue_read_space(eq_out);
+	if (ready > 0 && !tx_primed && tx_prime_left > 0) {
+		// Output has just appeared, give it a little standing room first
+		tx_prime_left--;
+		ready = 0;
+	}
+	if (ready > n)
+		ready = n;
+#ifdef linux
+	for (i = 0; i < n; i++) {
+		packet = next_frame(i, ready);
+		if (packet == silent_frame) {
+			n = i + 1;
+		}
+		tx_iovecs[i].iov_base = packet;
+		tx_iovecs[i].iov_len = FRAME_SZ;
+		tx_msgs[i].msg_hdr.msg_iov = &tx_iovecs[i];
+		tx_msgs[i].msg_hdr.msg_iovlen = 1;
+		tx_msgs[i].msg_hdr.msg_name = &tx_addr;
+		tx_msgs[i].msg_hdr.msg_namelen = sizeof(tx_addr);
+		tx_msgs[i].msg_hdr.msg_control = NULL;
+		tx_msgs[i].msg_hdr.msg_controllen = 0;
+		tx_msgs[i].msg_hdr.msg_flags = 0;
+	}
+	// Dispatch to radio
+	sent = sendmmsg(td->socket, tx_msgs, n, 0);
+	if (sent == -1) {
+		printf("UDP dispatch failed!\n");
+		sent = 0;
+	}
+#else
+	// Dispatch to radio, stop at a failure so the frames stay in order
+	for (i = 0, sent = 0; i < n; i++) {
+		packet = next_frame(i, ready);
+		if (packet == silent_frame) {
+			n = i + 1;
+		}
+		if (sendto(td->socket, (const char*)packet, FRAME_SZ, 0, (struct sockaddr*)&tx_addr, sizeof(tx_addr)) == -1) {
 			printf("UDP dispatch failed!\n");
+			break;
 		}
+		sent++;
+	}
+#endif
+	// Release the frames that were sent, any the socket did not take go first next tick
+	ep2_queue_read_advance(eq_out, sent < ready ? sent : ready);
+	wtr_stats.bursts++;
+	wtr_stats.frames += sent;
+	wtr_stats.failed += n - sent;
+	if ((unsigned int)sent > wtr_stats.max_burst) {
+		wtr_stats.max_burst = sent;
 	}
+	return n - sent;
 }
 
+static long long now_ns() {
+	// Monotonic time in ns
+#ifdef linux
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+#else
+	LARGE_INTEGER count, freq;
+	QueryPerformanceCounter(&count);
+	QueryPerformanceFrequency(&freq);
+	return (long long)((double)count.QuadPart * 1.0e9 / (double)freq.QuadPart);
+#endif
+}
 
+static void sleep_until(long long deadline) {
+	// Sleep until the monotonic time deadline in ns
+#ifdef linux
+	struct timespec ts;
+	ts.tv_sec = deadline / 1000000000LL;
+	ts.tv_nsec = deadline % 1000000000LL;
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR);
+#else
+	long long remaining;
+	while ((remaining = deadline - now_ns()) > 0) {
+		// Sleep while there is more than the timer resolution to go then yield
+		if (remaining > 2000000LL)
+			Sleep(1);
+		else
+			Sleep(0);
+	}
+#endif
+}
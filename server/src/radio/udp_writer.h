@@ -28,10 +28,26 @@ The authors can be reached by email at:
 #define _udp_writer_h
 
 //==================================================================
+// Writer thread
+
+// Thread data structure for UDP writer
+typedef struct UDPWriterThreadData {
+	int run;
+	int terminate;
+	int socket;
+	struct sockaddr_in srv_addr;	// The radio address, set by writer_start() under writer_mutex
+	long long period_ns;	// Time between frames at the output rate
+	int block_frames;		// Frames the pipeline adds per block, rounded up
+}UDPWriterThreadData;
 
 // Prototypes
-void writer_init(int sd, struct sockaddr_in *srv_addr);
+int writer_init(int sd, int rate, int blk_smpls);
+void *udp_writer_imp(void* data);
+void writer_start(struct sockaddr_in *srv_addr);
+void writer_stop();
+void writer_terminate();
+void writer_get_stats(WriterStats *stats);
+void writer_reset_stats();
 void prime_radio(int sd, struct sockaddr_in *srv_addr);
-void write_data(int sd, struct sockaddr_in *srv_addr);
 
 #endif
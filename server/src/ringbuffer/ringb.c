@@ -60,7 +60,7 @@ ringb_create (size_t sz2)
   rb->buf = safealloc (1, sz2, "Ring buffer buf");
   rb->size = sz2;		// power-of-2-sized
   rb->mask = rb->size - 1;
-  rb->wptr = rb->rptr = 0;
+  ringb_reset (rb);
   return rb;
 }
 
@@ -73,7 +73,7 @@ ringb_float_create (size_t sz2)
     (float *) safealloc (1, sz2 * sizeof (float), "Ring buffer float buf");
   rb->size = sz2;		// power-of-2-sized
   rb->mask = rb->size - 1;
-  rb->wptr = rb->rptr = 0;
+  ringb_float_reset (rb);
   return rb;
 }
 
@@ -84,7 +84,7 @@ ringb_create_usemem (char *usemem, size_t sz2)
   rb->buf = usemem + sizeof (ringb_t);
   rb->size = sz2;		// power-of-2-sized
   rb->mask = rb->size - 1;
-  rb->wptr = rb->rptr = 0;
+  ringb_reset (rb);
   return rb;
 }
 
@@ -107,16 +107,20 @@ void
 ringb_reset (ringb_t * rb)
 {
   // NB not thread-safe
-  rb->rptr = 0;
-  rb->wptr = 0;
+  ringb_store_release (&rb->rptr, 0);
+  ringb_store_release (&rb->wptr, 0);
+  rb->rptr_cache = 0;
+  rb->wptr_cache = 0;
 }
 
 void
 ringb_float_reset (ringb_float_t * rb)
 {
   // NB not thread-safe
-  rb->rptr = 0;
-  rb->wptr = 0;
+  ringb_store_release (&rb->rptr, 0);
+  ringb_store_release (&rb->wptr, 0);
+  rb->rptr_cache = 0;
+  rb->wptr_cache = 0;
 }
 
 void
@@ -151,68 +155,104 @@ ringb_float_restart (ringb_float_t * rb, size_t nfloats)
   ringb_float_clear (rb, nfloats);
 }
 
+/*------------------------------------------------------------------------*/
+/* Space calculations on a pair of pointers */
+
+static inline size_t
+read_avail (size_t w, size_t r, size_t size, size_t mask)
+{
+  return (w - r + size) & mask;
+}
+
+static inline size_t
+write_avail (size_t w, size_t r, size_t size, size_t mask)
+{
+  return (r - w + size - 1) & mask;
+}
+
+/* Consumer side.
+ * Return what can be read using the cached write pointer, refreshing the
+ * cache from the producer only if that is less than wanted. */
+
+static inline size_t
+consumer_avail (ringb_index_t * wptr, size_t * wptr_cache, size_t r,
+		size_t size, size_t mask, size_t wanted)
+{
+  size_t avail = read_avail (*wptr_cache, r, size, mask);
+  if (avail < wanted)
+    {
+      *wptr_cache = ringb_load_acquire (wptr);
+      avail = read_avail (*wptr_cache, r, size, mask);
+    }
+  return avail;
+}
+
+/* Producer side.
+ * Return what can be written using the cached read pointer, refreshing the
+ * cache from the consumer only if that is less than wanted. */
+
+static inline size_t
+producer_avail (ringb_index_t * rptr, size_t * rptr_cache, size_t w,
+		size_t size, size_t mask, size_t wanted)
+{
+  size_t avail = write_avail (w, *rptr_cache, size, mask);
+  if (avail < wanted)
+    {
+      *rptr_cache = ringb_load_acquire (rptr);
+      avail = write_avail (w, *rptr_cache, size, mask);
+    }
+  return avail;
+}
+
 size_t
 ringb_read_space (const ringb_t * rb)
 {
-  size_t w = rb->wptr, r = rb->rptr;
-  if (w > r)
-    return w - r;
-  else
-    return (w - r + rb->size) & rb->mask;
+  ringb_t *prb = (ringb_t *) rb;
+  return read_avail (ringb_load_acquire (&prb->wptr),
+		     ringb_load_acquire (&prb->rptr), rb->size, rb->mask);
 }
 
 size_t
 ringb_float_read_space (const ringb_float_t * rb)
 {
-  size_t w = rb->wptr, r = rb->rptr;
-  if (w > r)
-    return w - r;
-  else
-    return (w - r + rb->size) & rb->mask;
+  ringb_float_t *prb = (ringb_float_t *) rb;
+  return read_avail (ringb_load_acquire (&prb->wptr),
+		     ringb_load_acquire (&prb->rptr), rb->size, rb->mask);
 }
 
 size_t
 ringb_write_space (const ringb_t * rb)
 {
-  size_t w = rb->wptr, r = rb->rptr;
-  if (w > r)
-    return ((r - w + rb->size) & rb->mask) - 1;
-  else if (w < r)
-    return r - w - 1;
-  else
-    return rb->size - 1;
+  ringb_t *prb = (ringb_t *) rb;
+  return write_avail (ringb_load_acquire (&prb->wptr),
+		      ringb_load_acquire (&prb->rptr), rb->size, rb->mask);
 }
 
 size_t
 ringb_float_write_space (const ringb_float_t * rb)
 {
-  size_t w = rb->wptr, r = rb->rptr;
-  if (w > r)
-    return ((r - w + rb->size) & rb->mask) - 1;
-  else if (w < r)
-    return r - w - 1;
-  else
-    return rb->size - 1;
+  ringb_float_t *prb = (ringb_float_t *) rb;
+  return write_avail (ringb_load_acquire (&prb->wptr),
+		      ringb_load_acquire (&prb->rptr), rb->size, rb->mask);
 }
 
 size_t
 ringb_read (ringb_t * rb, char *dest, size_t cnt)
 {
   size_t free_cnt, cnt2, to_read, n1, n2;
-  if ((free_cnt = ringb_read_space (rb)) == 0)
+  size_t r = ringb_load_relaxed (&rb->rptr);
+  if ((free_cnt = consumer_avail (&rb->wptr, &rb->wptr_cache, r,
+				  rb->size, rb->mask, cnt)) == 0)
     return 0;
   to_read = cnt > free_cnt ? free_cnt : cnt;
-  if ((cnt2 = rb->rptr + to_read) > rb->size)
-    n1 = rb->size - rb->rptr, n2 = cnt2 & rb->mask;
+  if ((cnt2 = r + to_read) > rb->size)
+    n1 = rb->size - r, n2 = cnt2 & rb->mask;
   else
     n1 = to_read, n2 = 0;
-  memcpy (dest, &(rb->buf[rb->rptr]), n1);
-  rb->rptr = (rb->rptr + n1) & rb->mask;
+  memcpy (dest, &(rb->buf[r]), n1);
   if (n2)
-    {
-      memcpy (dest + n1, &(rb->buf[rb->rptr]), n2);
-      rb->rptr = (rb->rptr + n2) & rb->mask;
-    }
+    memcpy (dest + n1, rb->buf, n2);
+  ringb_store_release (&rb->rptr, (r + to_read) & rb->mask);
   return to_read;
 }
 
@@ -220,39 +260,38 @@ size_t
 ringb_float_read (ringb_float_t * rb, float *dest, size_t cnt)
 {
   size_t free_cnt, cnt2, to_read, n1, n2;
-  if ((free_cnt = ringb_float_read_space (rb)) == 0)
+  size_t r = ringb_load_relaxed (&rb->rptr);
+  if ((free_cnt = consumer_avail (&rb->wptr, &rb->wptr_cache, r,
+				  rb->size, rb->mask, cnt)) == 0)
     return 0;
   to_read = cnt > free_cnt ? free_cnt : cnt;
-  if ((cnt2 = rb->rptr + to_read) > rb->size)
-    n1 = rb->size - rb->rptr, n2 = cnt2 & rb->mask;
+  if ((cnt2 = r + to_read) > rb->size)
+    n1 = rb->size - r, n2 = cnt2 & rb->mask;
   else
     n1 = to_read, n2 = 0;
-  memcpy (dest, &(rb->buf[rb->rptr]), n1 * sizeof (float));
-  rb->rptr = (rb->rptr + n1) & rb->mask;
+  memcpy (dest, &(rb->buf[r]), n1 * sizeof (float));
   if (n2)
-    {
-      memcpy (dest + n1, &(rb->buf[rb->rptr]), n2 * sizeof (float));
-      rb->rptr = (rb->rptr + n2) & rb->mask;
-    }
+    memcpy (dest + n1, rb->buf, n2 * sizeof (float));
+  ringb_store_release (&rb->rptr, (r + to_read) & rb->mask);
   return to_read;
 }
 
 size_t
 ringb_peek (ringb_t * rb, char *dest, size_t cnt)
 {
-  size_t free_cnt, cnt2, to_read, n1, n2, tmp_rptr;
-  tmp_rptr = rb->rptr;
-  if ((free_cnt = ringb_read_space (rb)) == 0)
+  size_t free_cnt, cnt2, to_read, n1, n2;
+  size_t r = ringb_load_relaxed (&rb->rptr);
+  if ((free_cnt = consumer_avail (&rb->wptr, &rb->wptr_cache, r,
+				  rb->size, rb->mask, cnt)) == 0)
     return 0;
   to_read = cnt > free_cnt ? free_cnt : cnt;
-  if ((cnt2 = tmp_rptr + to_read) > rb->size)
-    n1 = rb->size - tmp_rptr, n2 = cnt2 & rb->mask;
+  if ((cnt2 = r + to_read) > rb->size)
+    n1 = rb->size - r, n2 = cnt2 & rb->mask;
   else
     n1 = to_read, n2 = 0;
-  memcpy (dest, &(rb->buf[tmp_rptr]), n1);
-  tmp_rptr = (tmp_rptr + n1) & rb->mask;
+  memcpy (dest, &(rb->buf[r]), n1);
   if (n2)
-    memcpy (dest + n1, &(rb->buf[tmp_rptr]), n2);
+    memcpy (dest + n1, rb->buf, n2);
   return to_read;
 }
 
@@ -260,20 +299,19 @@ size_t
 ringb_write (ringb_t * rb, const char *src, size_t cnt)
 {
   size_t free_cnt, cnt2, to_write, n1, n2;
-  if ((free_cnt = ringb_write_space (rb)) == 0)
+  size_t w = ringb_load_relaxed (&rb->wptr);
+  if ((free_cnt = producer_avail (&rb->rptr, &rb->rptr_cache, w,
+				  rb->size, rb->mask, cnt)) == 0)
     return 0;
   to_write = cnt > free_cnt ? free_cnt : cnt;
-  if ((cnt2 = rb->wptr + to_write) > rb->size)
-    n1 = rb->size - rb->wptr, n2 = cnt2 & rb->mask;
+  if ((cnt2 = w + to_write) > rb->size)
+    n1 = rb->size - w, n2 = cnt2 & rb->mask;
   else
     n1 = to_write, n2 = 0;
-  memcpy (&(rb->buf[rb->wptr]), src, n1);
-  rb->wptr = (rb->wptr + n1) & rb->mask;
+  memcpy (&(rb->buf[w]), src, n1);
   if (n2)
-    {
-      memcpy (&(rb->buf[rb->wptr]), src + n1, n2);
-      rb->wptr = (rb->wptr + n2) & rb->mask;
-    }
+    memcpy (rb->buf, src + n1, n2);
+  ringb_store_release (&rb->wptr, (w + to_write) & rb->mask);
   return to_write;
 }
 
@@ -281,43 +319,44 @@ size_t
 ringb_float_write (ringb_float_t * rb, const float *src, size_t cnt)
 {
   size_t free_cnt, cnt2, to_write, n1, n2;
-  if ((free_cnt = ringb_float_write_space (rb)) == 0)
+  size_t w = ringb_load_relaxed (&rb->wptr);
+  if ((free_cnt = producer_avail (&rb->rptr, &rb->rptr_cache, w,
+				  rb->size, rb->mask, cnt)) == 0)
     return 0;
   to_write = cnt > free_cnt ? free_cnt : cnt;
-  if ((cnt2 = rb->wptr + to_write) > rb->size)
-    n1 = rb->size - rb->wptr, n2 = cnt2 & rb->mask;
+  if ((cnt2 = w + to_write) > rb->size)
+    n1 = rb->size - w, n2 = cnt2 & rb->mask;
   else
     n1 = to_write, n2 = 0;
-  memcpy (&(rb->buf[rb->wptr]), src, n1 * sizeof (float));
-  rb->wptr = (rb->wptr + n1) & rb->mask;
+  memcpy (&(rb->buf[w]), src, n1 * sizeof (float));
   if (n2)
-    {
-      memcpy (&(rb->buf[rb->wptr]), src + n1, n2 * sizeof (float));
-      rb->wptr = (rb->wptr + n2) & rb->mask;
-    }
+    memcpy (rb->buf, src + n1, n2 * sizeof (float));
+  ringb_store_release (&rb->wptr, (w + to_write) & rb->mask);
   return to_write;
 }
 
 void
 ringb_read_advance (ringb_t * rb, size_t cnt)
 {
-  rb->rptr = (rb->rptr + cnt) & rb->mask;
+  size_t r = ringb_load_relaxed (&rb->rptr);
+  ringb_store_release (&rb->rptr, (r + cnt) & rb->mask);
 }
 
 void
 ringb_write_advance (ringb_t * rb, size_t cnt)
 {
-  rb->wptr = (rb->wptr + cnt) & rb->mask;
+  size_t w = ringb_load_relaxed (&rb->wptr);
+  ringb_store_release (&rb->wptr, (w + cnt) & rb->mask);
 }
 
 void
 ringb_get_read_vector (const ringb_t * rb, ringb_data_t * vec)
 {
-  size_t free_cnt, cnt2, w = rb->wptr, r = rb->rptr;
-  if (w > r)
-    free_cnt = w - r;
-  else
-    free_cnt = (w - r + rb->size) & rb->mask;
+  // Consumer side, refreshes the cached write pointer
+  ringb_t *prb = (ringb_t *) rb;
+  size_t free_cnt, cnt2, w, r = ringb_load_relaxed (&prb->rptr);
+  w = prb->wptr_cache = ringb_load_acquire (&prb->wptr);
+  free_cnt = read_avail (w, r, rb->size, rb->mask);
   if ((cnt2 = r + free_cnt) > rb->size)
     {
       vec[0].buf = &(rb->buf[r]), vec[0].len = rb->size - r;
@@ -333,13 +372,11 @@ ringb_get_read_vector (const ringb_t * rb, ringb_data_t * vec)
 void
 ringb_get_write_vector (const ringb_t * rb, ringb_data_t * vec)
 {
-  size_t free_cnt, cnt2, w = rb->wptr, r = rb->rptr;
-  if (w > r)
-    free_cnt = ((r - w + rb->size) & rb->mask) - 1;
-  else if (w < r)
-    free_cnt = r - w - 1;
-  else
-    free_cnt = rb->size - 1;
+  // Producer side, refreshes the cached read pointer
+  ringb_t *prb = (ringb_t *) rb;
+  size_t free_cnt, cnt2, r, w = ringb_load_relaxed (&prb->wptr);
+  r = prb->rptr_cache = ringb_load_acquire (&prb->rptr);
+  free_cnt = write_avail (w, r, rb->size, rb->mask);
   if ((cnt2 = w + free_cnt) > rb->size)
     {
       vec[0].buf = &(rb->buf[w]), vec[0].len = rb->size - w;
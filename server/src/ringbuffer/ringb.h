@@ -28,6 +28,33 @@
 #ifndef _ringb_h
 #define _ringb_h
 
+/* Single producer / single consumer.
+ * The write pointer is only stored by the producer and the read pointer
+ * only by the consumer. Each side publishes its pointer with release
+ * semantics and picks up the other side's pointer with acquire semantics,
+ * so the data written before a pointer update is always visible to the
+ * other thread when it sees the new pointer. No lock is required.
+ *
+ * The producer and consumer fields live on separate cache lines and each
+ * side keeps a private snapshot of the opposite pointer. The shared pointer
+ * is only re-read when the snapshot says there is not enough data/space,
+ * so in the steady state neither thread touches the other's cache line. */
+
+#define RINGB_CACHE_LINE 64
+
+#if defined(linux)
+  typedef atomic_size_t ringb_index_t;
+  #define ringb_load_acquire(p) atomic_load_explicit ((p), memory_order_acquire)
+  #define ringb_load_relaxed(p) atomic_load_explicit ((p), memory_order_relaxed)
+  #define ringb_store_release(p, v) atomic_store_explicit ((p), (v), memory_order_release)
+#else
+  // MSVC volatile has acquire/release semantics on x86/x64 (/volatile:ms)
+  typedef volatile size_t ringb_index_t;
+  #define ringb_load_acquire(p) (*(p))
+  #define ringb_load_relaxed(p) (*(p))
+  #define ringb_store_release(p, v) (*(p) = (v))
+#endif
+
 typedef struct
 {
   char *buf;
@@ -36,8 +63,18 @@ typedef struct
 
 typedef struct
 {
+  // Read-only after creation, shared by both sides
   char *buf;
-  size_t wptr, rptr, size, mask;
+  size_t size, mask;
+  char pad0[RINGB_CACHE_LINE];
+  // Producer side
+  ringb_index_t wptr;
+  size_t rptr_cache;
+  char pad1[RINGB_CACHE_LINE];
+  // Consumer side
+  ringb_index_t rptr;
+  size_t wptr_cache;
+  char pad2[RINGB_CACHE_LINE];
 } ringb_t;
 
 typedef struct
@@ -48,8 +85,18 @@ typedef struct
 
 typedef struct
 {
+  // Read-only after creation, shared by both sides
   float *buf;
-  size_t wptr, rptr, size, mask;
+  size_t size, mask;
+  char pad0[RINGB_CACHE_LINE];
+  // Producer side
+  ringb_index_t wptr;
+  size_t rptr_cache;
+  char pad1[RINGB_CACHE_LINE];
+  // Consumer side
+  ringb_index_t rptr;
+  size_t wptr_cache;
+  char pad2[RINGB_CACHE_LINE];
 } ringb_float_t;
 
 /*
@@ -164,6 +211,7 @@ extern size_t ringb_peek (ringb_t * rb, char *dest, size_t cnt);
 extern void ringb_read_advance (ringb_t * rb, size_t cnt);
 
 /* Return the number of bytes available for reading.
+ * May be called from either side.
  * rb a pointer to the ringbuffer structure.
  * return the number of bytes available to read. */
 
@@ -197,6 +245,7 @@ extern size_t ringb_float_write (ringb_float_t * rb, const float *src,
 extern void ringb_write_advance (ringb_t * rb, size_t cnt);
 
 /* Return the number of bytes(floats) available for writing.
+ * May be called from either side.
  * rb a pointer to the ringbuffer structure.
  * return the amount of free space (in bytes) available for writing. */
 
@@ -130,12 +130,20 @@ int c_server_init() {
 	pargs->general.display_width = DISPLAY_WIDTH;
 	pargs->general.av_mode = PAN_TIME_AV_LIN;
 	pargs->general.duplex = 0;
+	pargs->general.rx_batch_sz = RX_BATCH_SZ;
+	pargs->general.flush_denormals = TRUE;
+	pargs->general.dsp_workers = 0;
+	pargs->general.dsp_first_core = -1;
+	pargs->general.dsp_fifo_priority = 0;
+	pargs->general.dsp_tx_core = -1;
 	
 	// Initialise audio structures
 	c_audio_init();
 	
 	// Init the CC bytes with defaults
 	cc_out_init();
+	// Build the output frame template
+	encoder_init();
 	
 	// Done
 	c_server_initialised = TRUE;
@@ -169,6 +177,23 @@ void c_server_set_duplex(int duplex) {
 	if (!c_server_running) pargs->general.duplex = duplex;
 }
 
+void c_server_set_rx_batch_sz(int batch_sz) {
+	if (!c_server_running) pargs->general.rx_batch_sz = batch_sz;
+}
+
+void c_server_set_flush_denormals(int flush) {
+	if (!c_server_running) pargs->general.flush_denormals = flush;
+}
+
+void c_server_set_dsp_scheduler(int workers, int first_core, int fifo_priority, int tx_core) {
+	if (!c_server_running) {
+		pargs->general.dsp_workers = workers;
+		pargs->general.dsp_first_core = first_core;
+		pargs->general.dsp_fifo_priority = fifo_priority;
+		pargs->general.dsp_tx_core = tx_core;
+	}
+}
+
 void c_server_set_fft_size(int size) {
 	if (!c_server_running) pargs->general.fft_size = size;
 }
@@ -219,13 +244,25 @@ int c_server_start() {
 	}
 	init_gains();
 	init_wbs();
+#ifdef UNIVERSAL
+	// Denormal flushing for the DSP threads, must precede the channels
+	SetFlushDenormals(pargs->general.flush_denormals);
+	// Worker pool for the DSP channels, 0 workers leaves each channel a thread of its own
+	SetChannelScheduler(pargs->general.dsp_workers, pargs->general.dsp_first_core,
+		pargs->general.dsp_fifo_priority, pargs->general.dsp_tx_core);
+#endif
 	create_dsp_channels();
 	create_display_channels();
 	set_cc_data();
 	// Revert to a normal socket with larger buffers
 	revert_sd(sd);
 	// Init the UDP reader
-	reader_init(sd, &srv_addr, pargs->num_rx, pargs->general.in_rate);
+	reader_init(sd, pargs->num_rx, pargs->general.in_rate, pargs->general.rx_batch_sz);
+	// Init the UDP writer
+	if (!writer_init(sd, pargs->general.out_rate, pargs->general.iq_blk_sz * pargs->general.out_rate / pargs->general.in_rate)) {
+		printf("c.server: Failed to create the UDP writer thread!\n");
+		return FALSE;
+	}
 	// Init sequence processing
 	seq_init();
 
@@ -248,8 +285,10 @@ int c_server_terminate() {
 	* Arguments:
 	*
 	*/
+	int i;
+
 	// Close all channels
-	for (int i = 0; i < pargs->num_rx; i++) {
+	for (i = 0; i < pargs->num_rx; i++) {
 		c_server_close_display(pargs->disp[i].ch_id);
 		c_server_close_channel(pargs->rx[i].ch_id);
 	}
@@ -257,6 +296,8 @@ int c_server_terminate() {
 	// Stop and terminate the pipeline
 	reader_stop();
 	reader_terminate();
+	writer_stop();
+	writer_terminate();
 	pipeline_stop();
 	pipeline_terminate();
 	// Free memory
@@ -264,27 +305,26 @@ int c_server_terminate() {
 		safefree((char*)pargs);
 	if (ppl != NULL)
 		safefree((char*)ppl);
-	if (iq != NULL)
-		safefree((char*)iq);
-	if (mic != NULL)
-		safefree((char*)mic);
 	if (local_mic != NULL)
 		safefree((char*)local_mic);
 	if (pan != NULL)
 		safefree((char*)pan);
 	pargs = NULL;
 	ppl = NULL;
-	iq = NULL;
-	mic = NULL;
 	local_mic = NULL;
 	pan = NULL;
 	// WBS
 	fftw_destroy_plan(wbs_plan);
 	fftw_free(wbs_in); fftw_free(wbs_out);
 	// Free ring buffers
-	ringb_free(rb_iq_in);
+	for (i = 0; i < MAX_RX; i++) {
+		if (rb_iq_in[i] != NULL) {
+			ringb_free(rb_iq_in[i]);
+			rb_iq_in[i] = NULL;
+		}
+	}
 	ringb_free(rb_mic_in);
-	ringb_free(rb_out);
+	ep2_queue_free(eq_out);
 #ifdef linux
 	close(sd);
 #else
@@ -348,6 +388,7 @@ int c_radio_start(int wbs) {
 		// Before starting the reader we need to prime the radio
 		prime_radio( sd, &srv_addr );
 		reader_start();
+		writer_start(&srv_addr);
 		c_radio_running = TRUE;
 	} else {
 		printf("c.server: Failed to start radio hardware!\n");
@@ -379,6 +420,7 @@ int c_radio_stop() {
 
 	// Stop services
 	reader_stop();
+	writer_stop();
 	// Stop radio hardware
 	if (!do_stop(sd, &srv_addr)) {
 		printf("c.server: Failed to stop radio hardware!\n");
@@ -500,6 +542,42 @@ void c_server_set_agc_mode(int channel, int mode) {
 	SetRXAAGCMode(channel, mode);
 }
 
+void c_server_set_rx_nr(int channel, int run) {
+	/*
+	** Set the receiver spectral noise reduction (EMNR) run mode on the given channel
+	**
+	** Arguments:
+	** 	channel	-- the channel id as returned by open_channel()
+	** 	run  	-- 0 = off, 1 = on
+	**
+	** Note: Only the universal WDSP has EMNR.
+	**
+	*/
+
+#ifdef UNIVERSAL
+	SetRXAEMNRRun(channel, run);
+#endif
+}
+
+void c_server_set_rx_pipeline(int channel, int segments, int first_core) {
+	/*
+	** Split the receiver DSP chain of the given channel over worker threads
+	**
+	** Arguments:
+	** 	channel		-- the channel id as returned by open_channel()
+	** 	segments	-- 1 = run the chain on the channel thread, 2..4 = pipeline segments,
+	** 				   each extra segment adds one DSP block of latency
+	** 	first_core	-- core of the first worker, the others follow on, -1 = not pinned
+	**
+	** Note: Only the universal WDSP has the pipelined chain.
+	**
+	*/
+
+#ifdef UNIVERSAL
+	SetRXAPipeline(channel, segments, first_core);
+#endif
+}
+
 double c_server_get_rx_meter_data(int channel, int which) {
 	/*
 	** Get the requested meter data for the given channel
@@ -638,6 +716,52 @@ short c_server_get_peak_input_level() {
 	return peak_input_level;
 }
 
+//============================================================================================
+// Statistics
+
+void c_server_get_pipeline_stats(PipelineStats *stats) {
+	/*
+	** Get the pipeline batching statistics
+	**
+	** Arguments:
+	** 	stats	-- receives the statistics
+	**
+	** Note: blocks/wakeups is the mean number of blocks processed per wakeup
+	**
+	*/
+
+	pipeline_get_stats(stats);
+}
+
+void c_server_get_reader_stats(ReaderStats *stats) {
+	/*
+	** Get the UDP receive statistics
+	**
+	** Arguments:
+	** 	stats	-- receives the statistics
+	**
+	** Note: frames/syscalls is the mean number of frames per receive call
+	** and jitter_sum_ns/ts_frames the mean arrival jitter
+	**
+	*/
+
+	reader_get_stats(stats);
+}
+
+void c_server_get_writer_stats(WriterStats *stats) {
+	/*
+	** Get the UDP transmit statistics
+	**
+	** Arguments:
+	** 	stats	-- receives the statistics
+	**
+	** Note: frames/bursts is the mean number of frames per send call
+	**
+	*/
+
+	writer_get_stats(stats);
+}
+
 // =========================================================================================================
 // Display Processing
 
@@ -1148,32 +1272,38 @@ static void c_ppl_audio_init() {
 // Create ring buffers for the IQ and Mic data streams
 static void create_ring_buffers() {
 
-	int num_tx;
+	int i, num_tx;
 	size_t iq_ring_sz;
 	size_t mic_ring_sz;
-
-	// Create the input ring which accommodates enough samples for 8x DSP block size per receiver
-	// at 6 bytes per sample. The size must then be rounded up to the next power of 2 as required
-	// by the ring buffer.
-	iq_ring_sz = powf(2, ceilf(log(pargs->num_rx * pargs->general.iq_blk_sz * 6 * 8) / log(2)));
-	rb_iq_in = ringb_create(iq_ring_sz);
-	// Mic input is similar except 2 bytes per sample
+	size_t out_ring_sz;
+
+	// Create an input ring per receiver which accommodates enough samples for 8x DSP block size
+	// at 2 dsp_t per sample as the reader decodes directly into the rings. The size must then
+	// be rounded up to the next power of 2 as required by the ring buffer.
+	iq_ring_sz = powf(2, ceilf(log(pargs->general.iq_blk_sz * 2 * sizeof(dsp_t) * 8) / log(2)));
+	for (i = 0; i < pargs->num_rx; i++) {
+		rb_iq_in[i] = ringb_create(iq_ring_sz);
+	}
+	// Mic input is similar, the mono mic is also 2 dsp_t per sample
 	// Note, even if there are no TX channels we still need to allocate a ring buffer as the input data
 	// is still piped through (maybe not necessary!)
 	if (pargs->num_tx == 0)
 		num_tx = 1;
 	else
 		num_tx = pargs->num_tx;
-	mic_ring_sz = powf(2, ceilf(log(num_tx * pargs->general.mic_blk_sz * 2 * 8) / log(2)));
+	mic_ring_sz = powf(2, ceilf(log(num_tx * pargs->general.mic_blk_sz * 2 * sizeof(dsp_t) * 8) / log(2)));
 	rb_mic_in = ringb_create(mic_ring_sz);
 
 	// At worst (48K) output rate == input rate, otherwise the output rate is lower
-	// Allow the same buffer size so we can never run out.
-	rb_out = ringb_create(iq_ring_sz);
+	// Allow the size of the received data, 6 bytes per sample per receiver, so we can never run out.
+	// The output is a queue of EP2 frames so this is rounded up to a power of 2 frames.
+	out_ring_sz = powf(2, ceilf(log((pargs->num_rx * pargs->general.iq_blk_sz * 6 * 8) / EP2_PAYLOAD_SZ + 1) / log(2)));
+	eq_out = ep2_queue_create(out_ring_sz);
 }
 
 // Initialise the Pipeline structure
 static void init_pipeline_structure() {
+	int i;
 	
 	ppl = (Pipeline *)safealloc(sizeof(Pipeline), sizeof(char), "PIPELINE_STRUCT");
 	ppl->run = FALSE;
@@ -1181,9 +1311,11 @@ static void init_pipeline_structure() {
 	ppl->local_audio_run = TRUE;
 	ppl->terminate = FALSE;
 	ppl->terminating = FALSE;
-	ppl->rb_iq_in = rb_iq_in;
+	ppl->data_pending = FALSE;
+	for (i = 0; i < MAX_RX; i++) {
+		ppl->rb_iq_in[i] = rb_iq_in[i];
+	}
 	ppl->rb_mic_in = rb_mic_in;
-	ppl->rb_out = rb_out;
 	ppl->pipeline_mutex = &pipeline_mutex;
 	ppl->pipeline_con = &pipeline_con;
 	ppl->args = pargs;
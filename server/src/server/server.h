@@ -43,6 +43,12 @@ typedef struct General {
 	int display_width;
 	int av_mode;
 	int duplex;
+	int rx_batch_sz;
+	int flush_denormals;
+	int dsp_workers;
+	int dsp_first_core;
+	int dsp_fifo_priority;
+	int dsp_tx_core;
 }General;
 typedef struct Route {
 	int rx;
@@ -105,9 +111,9 @@ typedef struct Pipeline {
 	int local_audio_run;
 	int terminate;
 	int terminating;
-	ringb_t *rb_iq_in;
+	int data_pending;		// Wait predicate, protected by pipeline_mutex
+	ringb_t *rb_iq_in[MAX_RX];
 	ringb_t *rb_mic_in;
-	ringb_t *rb_out;
 	pthread_mutex_t *pipeline_mutex;
 	pthread_cond_t *pipeline_con;
 	Args *args;
@@ -117,6 +123,39 @@ typedef struct Pipeline {
 	float drive;
 }Pipeline;
 
+// Pipeline batching statistics
+typedef struct PipelineStats {
+	unsigned int wakeups;		// Wakeups that found at least one block
+	unsigned int empty_wakeups;	// Wakeups that found no complete block
+	unsigned int blocks;		// Total blocks processed
+	unsigned int last_batch;	// Blocks processed on the last wakeup
+	unsigned int max_batch;		// Most blocks processed on a single wakeup
+}PipelineStats;
+
+// UDP reader statistics
+typedef struct ReaderStats {
+	unsigned int syscalls;			// Receive calls that returned frames
+	unsigned int frames;			// Total frames received
+	unsigned int last_batch;		// Frames returned by the last call
+	unsigned int max_batch;			// Most frames returned by a single call
+	unsigned int timeouts;			// Receive calls that timed out
+	unsigned int ts_frames;			// Frames with a kernel timestamp after the first
+	long long jitter_sum_ns;		// Sum of deviations of arrival gap from nominal
+	long long max_jitter_ns;		// Largest deviation of arrival gap from nominal
+}ReaderStats;
+
+// UDP writer statistics
+typedef struct WriterStats {
+	unsigned int frames;			// Total frames sent
+	unsigned int bursts;			// Send calls
+	unsigned int max_burst;			// Most frames sent in one call
+	unsigned int underruns;			// Frames sent silent as the output ring was empty
+	unsigned int slips;				// Extra frames sent to bound the output backlog
+	unsigned int resyncs;			// Times the schedule was restarted after falling too far behind
+	unsigned int failed;			// Frames the socket did not take, sent again on the next tick
+	long long max_late_ns;			// Latest wakeup after a deadline
+}WriterStats;
+
 typedef struct AudioDefault {
     int rx_left;
     int rx_right;
@@ -131,6 +170,9 @@ void c_server_set_out_rate(int rate);
 void c_server_set_iq_blk_sz(int blk_sz);
 void c_server_set_mic_blk_sz(int blk_sz);
 void c_server_set_duplex(int duplex);
+void c_server_set_rx_batch_sz(int batch_sz);
+void c_server_set_flush_denormals(int flush);
+void c_server_set_dsp_scheduler(int workers, int first_core, int fifo_priority, int tx_core);
 void c_server_set_fft_size(int size);
 void c_server_set_window_type(int window_type);
 void c_server_set_av_mode(int mode);
@@ -147,6 +189,8 @@ void c_server_set_rx_filter_run(int channel, int run);
 void c_server_set_rx_filter_freq(int channel, int low, int high);
 void c_server_set_rx_filter_window(int channel, int window);
 void c_server_set_agc_mode(int channel, int mode);
+void c_server_set_rx_nr(int channel, int run);
+void c_server_set_rx_pipeline(int channel, int segments, int first_core);
 void c_server_set_rx_gain(int rx, float gain);
 double c_server_get_rx_meter_data(int channel, int which);
 void c_server_set_tx_mode(int channel, int mode);
@@ -157,6 +201,10 @@ double c_server_get_tx_meter_data(int channel, int which);
 void c_server_set_mic_gain(float gain);
 void c_server_set_rf_drive(float drive);
 short c_server_get_peak_input_level();
+// Statistics
+void c_server_get_pipeline_stats(PipelineStats *stats);
+void c_server_get_reader_stats(ReaderStats *stats);
+void c_server_get_writer_stats(WriterStats *stats);
 // Displays
 void c_server_set_display(int ch_id, int display_width);
 int c_server_get_display_data(int display_id, void *display_data);
@@ -0,0 +1,221 @@
+/*
+bench_encode.c
+
+Speed of the EP2 frame queue against the old output ring and frame encoder
+
+Copyright (C) 2018 by G3UKB Bob Cowdery
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+The authors can be reached by email at:
+
+	bob@bobcowdery.plus.com
+
+*/
+
+/*
+Run by 'make bench'. Blocks of IQ_BLK_SZ samples of L/R and I/Q are encoded into EP2
+frames as the pipeline and the writer do it on one thread, and the frames per second
+are given for the whole path and for the writer's per frame part alone.
+
+The old path packs each block into a staging buffer and writes it to a byte ring.
+The writer reads each frame's 2 * DATA_SZ payload bytes out of the ring and builds
+the packet with encode_output_data(), copied here as it was. The new path packs
+each block straight into the payloads of the queued frames, and the writer patches
+the sequence and CC bytes in place with encode_output_frame().
+
+Every new frame must hold the header and sync bytes and the samples in order,
+otherwise it fails.
+*/
+
+// Includes
+#include "../common/include.h"
+
+#define N_SMPLS IQ_BLK_SZ
+#define QUEUE_FRAMES 64
+#define RING_SZ 65536
+#define MIN_NS 300000000LL
+
+static dsp_t lr[2 * N_SMPLS], iq[2 * N_SMPLS];
+static unsigned char stage[N_SMPLS * EP2_SMPL_SZ];
+static unsigned char packet[FRAME_SZ];
+static unsigned char frame_data[EP2_PAYLOAD_SZ];
+
+static long long now_ns() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// encode_output_data() as it was before the frame queue
+static void old_encode_output_data(char *data_frame, char *packet_buffer) {
+	int i,j;
+	char *cc;
+
+	// Header
+	packet_buffer[0] = 0xef;
+	packet_buffer[1] = 0xfe;
+	packet_buffer[2] = DATA_PKT;
+	packet_buffer[3] = EP2;
+	// Sequence number
+	char *seq = (char *)next_ep2_seq();
+	for( i = FRAME_SEQ_OFFSET, j=0 ; i < FRAME_SEQ_OFFSET+4 ; i++,j++ ) {
+		packet_buffer[i] = seq[j];
+	}
+	// First USB frame
+	for( i = FRAME_SYNC_1_OFFSET ; i < FRAME_SYNC_1_OFFSET+3 ; i++ ) {
+		packet_buffer[i] = 0x7f;
+	}
+	cc = (char *)cc_out_next_seq();
+	for (i = FRAME_CC_1_OFFSET, j=0 ; i < FRAME_CC_1_OFFSET + 5; i++,j++) {
+		packet_buffer[i] = cc[j];
+	}
+	for (i = START_FRAME_1, j = 0; i < END_FRAME_1; i++, j++) {
+		packet_buffer[i] = data_frame[j];
+	}
+	// Second USB frame
+	for (i = FRAME_SYNC_2_OFFSET ; i < FRAME_SYNC_2_OFFSET + 3 ; i++) {
+		packet_buffer[i] = 0x7f;
+	}
+	cc = (char *)cc_out_next_seq();
+	for (i = FRAME_CC_2_OFFSET, j = 0 ; i < FRAME_CC_2_OFFSET + 5 ; i++, j++) {
+		packet_buffer[i] = cc[j];
+	}
+	for (i = START_FRAME_2, j = DATA_SZ ; i < END_FRAME_2 ; i++, j++) {
+		packet_buffer[i] = data_frame[j];
+	}
+}
+
+// The pipeline's pack, into the staging buffer then the ring
+static void old_block(ringb_t *rb, long *frames, long long *writer_ns) {
+	long long t0;
+
+	pcm_pack(lr, lr + 1, 32768.0, N_SMPLS, stage, EP2_SMPL_SZ, PCM_BE);
+	pcm_pack(iq, iq + 1, 32768.0, N_SMPLS, stage + 4, EP2_SMPL_SZ, PCM_BE);
+	ringb_write(rb, (char *)stage, sizeof(stage));
+	// The writer's part
+	t0 = now_ns();
+	while (ringb_read_space(rb) >= EP2_PAYLOAD_SZ) {
+		ringb_read(rb, (char *)frame_data, EP2_PAYLOAD_SZ);
+		old_encode_output_data((char *)frame_data, (char *)packet);
+		(*frames)++;
+	}
+	*writer_ns += now_ns() - t0;
+}
+
+// The pipeline's pack straight into the frames, as do_encode()
+static void pack_block() {
+	int n, src = 0, remaining = N_SMPLS;
+	unsigned char *buf;
+
+	while (remaining > 0) {
+		buf = ep2_queue_get_write_run(eq_out, &n);
+		if (n > remaining) n = remaining;
+		pcm_pack(lr + src, lr + src + 1, 32768.0, n, buf, EP2_SMPL_SZ, PCM_BE);
+		pcm_pack(iq + src, iq + src + 1, 32768.0, n, buf + 4, EP2_SMPL_SZ, PCM_BE);
+		src += n * 2;
+		ep2_queue_write_advance(eq_out, n);
+		remaining -= n;
+	}
+}
+
+static void new_block(long *frames, long long *writer_ns) {
+	long long t0;
+
+	pack_block();
+	// The writer's part
+	t0 = now_ns();
+	while (ep2_queue_read_space(eq_out) > 0) {
+		encode_output_frame(ep2_queue_get_frame(eq_out, 0));
+		ep2_queue_read_advance(eq_out, 1);
+		(*frames)++;
+	}
+	*writer_ns += now_ns() - t0;
+}
+
+// A ramp so each sample's place can be checked, the L value counts up from 0 by 1 LSB
+static void fill() {
+	int i;
+
+	for (i = 0; i < N_SMPLS; i++) {
+		lr[2 * i] = (dsp_t)i / (dsp_t)32768.0;
+		lr[2 * i + 1] = -lr[2 * i];
+		iq[2 * i] = iq[2 * i + 1] = (dsp_t)0.25;
+	}
+}
+
+// Header, sync and sample order of the frames one block makes
+static int check_new() {
+	int f, k, frames, expect = 0, ok = TRUE;
+	unsigned char *frame, *smpl;
+
+	ep2_queue_reset(eq_out);
+	pack_block();
+	frames = ep2_queue_read_space(eq_out);
+	for (f = 0; f < frames; f++) {
+		frame = ep2_queue_get_frame(eq_out, f);
+		encode_output_frame(frame);
+		ok = ok && frame[0] == 0xef && frame[1] == 0xfe && frame[2] == DATA_PKT && frame[3] == EP2;
+		ok = ok && memcmp(frame + FRAME_SYNC_1_OFFSET, "\x7f\x7f\x7f", 3) == 0 && memcmp(frame + FRAME_SYNC_2_OFFSET, "\x7f\x7f\x7f", 3) == 0;
+		for (k = 0; k < NUM_SMPLS_1_RADIO; k++, expect++) {
+			if (k < NUM_SMPLS_1_RADIO / 2)
+				smpl = frame + START_FRAME_1 + k * EP2_SMPL_SZ;
+			else
+				smpl = frame + START_FRAME_2 + (k - NUM_SMPLS_1_RADIO / 2) * EP2_SMPL_SZ;
+			ok = ok && ((smpl[0] << 8) | smpl[1]) == expect;
+		}
+	}
+	ep2_queue_reset(eq_out);
+	return ok && frames == N_SMPLS / NUM_SMPLS_1_RADIO;
+}
+
+int main() {
+	ringb_t *rb = ringb_create(RING_SZ);
+	long frames;
+	long long t0, t, writer_ns;
+	double old_fps, old_writer_fps, new_fps, new_writer_fps;
+	int ok;
+
+	encoder_init();
+	eq_out = ep2_queue_create(QUEUE_FRAMES);
+	fill();
+	ok = check_new();
+
+	frames = 0; writer_ns = 0;
+	t0 = now_ns();
+	do {
+		old_block(rb, &frames, &writer_ns);
+		t = now_ns();
+	} while (t - t0 < MIN_NS);
+	old_fps = frames * 1.0e9 / (t - t0);
+	old_writer_fps = frames * 1.0e9 / writer_ns;
+
+	frames = 0; writer_ns = 0;
+	t0 = now_ns();
+	do {
+		new_block(&frames, &writer_ns);
+		t = now_ns();
+	} while (t - t0 < MIN_NS);
+	new_fps = frames * 1.0e9 / (t - t0);
+	new_writer_fps = frames * 1.0e9 / writer_ns;
+
+	printf("bench_encode: %s/%s, frames/s encoded from %d sample blocks\n", DSP_PRECISION, pcm_pack_name(), N_SMPLS);
+	printf("bench_encode: old ring and encode_output_data %.2fM, writer part %.2fM\n", old_fps * 1.0e-6, old_writer_fps * 1.0e-6);
+	printf("bench_encode: frame queue %.2fM, writer part %.2fM\n", new_fps * 1.0e-6, new_writer_fps * 1.0e-6);
+	printf("bench_encode: frame layout: %s\n", ok ? "PASS" : "FAIL");
+	ringb_free(rb);
+	ep2_queue_free(eq_out);
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,140 @@
+/*
+bench_iq_unpack.c
+
+Speed of the IQ unpack kernels against the old decode loop
+
+Copyright (C) 2018 by G3UKB Bob Cowdery
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+The authors can be reached by email at:
+
+	bob@bobcowdery.plus.com
+
+*/
+
+/*
+Run by 'make bench'. Blocks of IQ_BLK_SZ sample sets of 24 bit big endian I/Q are
+unpacked for 1 to 3 receivers by the per receiver loop do_decode() used to have, by
+iq_unpack_scalar() and by the kernel iq_unpack_init() picks for this CPU. The time is
+given in ns per sample per receiver. The radio frame layout, with the 2 mic bytes
+after each sample set, is timed as well as the contiguous layout the old loop took.
+
+The outputs of each kernel must be identical to the old loop, otherwise it fails.
+*/
+
+// Includes
+#include "../common/include.h"
+
+#define N_RX 3
+#define N_SMPLS IQ_BLK_SZ
+#define MIN_NS 200000000LL
+#define SCALE (1.0 / 8388608.0)
+
+static unsigned int seed = 1;
+
+static unsigned int lcg() {
+	seed = seed * 1103515245u + 12345u;
+	return seed >> 8;
+}
+
+static long long now_ns() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// The loop in do_decode() before iq_unpack, contiguous sample sets only
+static void old_decode(const unsigned char *buf, int stride, int n_smpls, int num_rx, dsp_t **dst, int src_index, double scale) {
+	int raw, rx, as_int;
+	int iq_grp = num_rx * 6;
+
+	(void)stride;
+	for (raw = 0; raw <= n_smpls * iq_grp - iq_grp; raw += iq_grp) {
+		for (rx = 0; rx < num_rx; rx++) {
+			as_int = ((buf[raw + 2 + (rx*6)] << 8) | (buf[raw + 1 + (rx*6)] << 16) | (buf[raw + (rx*6)] << 24)) >> 8;
+			dst[rx][src_index] = (dsp_t)(scale * (double)as_int);
+			as_int = ((buf[raw + 5 + (rx*6)] << 8) | (buf[raw + 4 + (rx*6)] << 16) | (buf[raw + 3 + (rx*6)] << 24)) >> 8;
+			dst[rx][src_index + 1] = (dsp_t)(scale * (double)as_int);
+		}
+		src_index += 2;
+	}
+}
+
+// ns per sample per receiver, running the kernel for at least MIN_NS
+static double time_kernel(IQUnpackFn fn, const unsigned char *src, int stride, int num_rx, dsp_t **dst) {
+	long long t0, t;
+	long blocks = 0;
+
+	// Warm the caches and the branch predictors
+	fn(src, stride, N_SMPLS, num_rx, dst, 0, SCALE);
+	t0 = now_ns();
+	do {
+		fn(src, stride, N_SMPLS, num_rx, dst, 0, SCALE);
+		blocks++;
+		t = now_ns();
+	} while (t - t0 < MIN_NS);
+	return (double)(t - t0) / ((double)blocks * N_SMPLS * num_rx);
+}
+
+static int same(dsp_t **a, dsp_t **b, int num_rx) {
+	int rx;
+
+	for (rx = 0; rx < num_rx; rx++) {
+		if (memcmp(a[rx], b[rx], 2 * N_SMPLS * sizeof(dsp_t)) != 0)
+			return FALSE;
+	}
+	return TRUE;
+}
+
+int main() {
+	static unsigned char src[N_SMPLS * (N_RX * 6 + 2)];
+	static dsp_t ref_buf[N_RX][2 * N_SMPLS], out_buf[N_RX][2 * N_SMPLS];
+	dsp_t *ref[N_RX], *out[N_RX];
+	double t_old, t_scalar, t_sel, t_scalar_f, t_sel_f;
+	int i, num_rx, stride, ok = TRUE;
+
+	iq_unpack_init();
+	for (i = 0; i < (int)sizeof(src); i++)
+		src[i] = (unsigned char)lcg();
+	for (i = 0; i < N_RX; i++) {
+		ref[i] = ref_buf[i];
+		out[i] = out_buf[i];
+	}
+	printf("bench_iq_unpack: %s, %d sample sets a block, ns per sample per receiver\n", DSP_PRECISION, N_SMPLS);
+	for (num_rx = 1; num_rx <= N_RX; num_rx++) {
+		// Contiguous sets against the old loop
+		stride = num_rx * 6;
+		old_decode(src, stride, N_SMPLS, num_rx, ref, 0, SCALE);
+		iq_unpack_scalar(src, stride, N_SMPLS, num_rx, out, 0, SCALE);
+		ok = ok && same(ref, out, num_rx);
+		iq_unpack(src, stride, N_SMPLS, num_rx, out, 0, SCALE);
+		ok = ok && same(ref, out, num_rx);
+		t_old = time_kernel(old_decode, src, stride, num_rx, out);
+		t_scalar = time_kernel(iq_unpack_scalar, src, stride, num_rx, out);
+		t_sel = time_kernel(iq_unpack, src, stride, num_rx, out);
+		// Radio frame layout, the mic bytes follow each set
+		stride = num_rx * 6 + 2;
+		iq_unpack_scalar(src, stride, N_SMPLS, num_rx, ref, 0, SCALE);
+		iq_unpack(src, stride, N_SMPLS, num_rx, out, 0, SCALE);
+		ok = ok && same(ref, out, num_rx);
+		t_scalar_f = time_kernel(iq_unpack_scalar, src, stride, num_rx, out);
+		t_sel_f = time_kernel(iq_unpack, src, stride, num_rx, out);
+		printf("bench_iq_unpack: %d RX contiguous old %.2f scalar %.2f %s %.2f, with mic bytes scalar %.2f %s %.2f\n",
+			num_rx, t_old, t_scalar, iq_unpack_name(), t_sel, t_scalar_f, iq_unpack_name(), t_sel_f);
+	}
+	printf("bench_iq_unpack: output against the old loop: %s\n", ok ? "PASS" : "FAIL");
+	return ok ? 0 : 1;
+}
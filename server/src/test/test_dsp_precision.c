@@ -0,0 +1,233 @@
+/*
+test_dsp_precision.c
+
+Single against double precision check of the decode -> DSP -> encode path
+
+Copyright (C) 2018 by G3UKB Bob Cowdery
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+The authors can be reached by email at:
+
+	bob@bobcowdery.plus.com
+
+*/
+
+/*
+Run by 'make check', which builds this file twice, once as it stands and once with
+DSP_FLOAT. The pipeline source is included so its block path can be driven as the
+pipeline thread drives it. run_block() takes the decoded I/Q from the receiver ring,
+exchanges it with a WDSP receiver through dsp_exchange() and encodes the audio into
+the EP2 output queue. With DSP_FLOAT that is the split to float, fexchange2 and the
+merge back, otherwise fexchange0 on interleaved double. WDSP itself runs in double
+either way so the difference is only what the server does around it.
+
+Tones and noise from -10 to -80 dBFS are packed as 24 bit I/Q frames and decoded
+with iq_unpack into the receiver ring as the reader does. The receiver demodulates
+USB with its default AGC. The channel waits for its output on each exchange so the
+run is the same every time.
+
+The double build writes the 16 bit L/R output to the file named on the command line.
+The float build reads it back and fails unless its own output is within 1 LSB of
+it everywhere and the SNR of float against double is at least 90 dB.
+*/
+
+// Includes
+#include "../common/include.h"
+#include "../pipeline/pipeline.c"
+
+#define RATE 48000
+#define CH_ID 0
+#define N_SMPLS IQ_BLK_SZ
+#define BLOCKS 400
+#define N_FRAMES (BLOCKS * N_SMPLS / NUM_SMPLS_1_RADIO)
+#define QUEUE_FRAMES 64
+#define MIN_SNR 90.0
+
+static Args test_args;
+static Pipeline test_ppl;
+static unsigned int seed = 1;
+
+// Local audio is not run, these stand in for audio/local_audio.c and PortAudio
+PaErrorCode audio_uninit() {
+	return paNoError;
+}
+
+const char *audio_get_last_error(int id) {
+	(void)id;
+	return "";
+}
+
+PaErrorCode audio_start_stream(PaStream *stream) {
+	(void)stream;
+	return paNoError;
+}
+
+// Uniform noise in -0.5..0.5, the same sequence on every platform
+static double noise() {
+	seed = seed * 1103515245u + 12345u;
+	return (double)((seed >> 8) & 0xffff) / 65535.0 - 0.5;
+}
+
+// Fill a block of 24 bit big endian I/Q frames, tones at 1 and 2 kHz
+static void make_frames(unsigned char *frm, long t) {
+	int i, vi, vq;
+	double w1 = 2.0 * M_PI * 1000.0 / RATE, w2 = 2.0 * M_PI * 2000.0 / RATE;
+	double I, Q;
+	unsigned char *p;
+
+	for (i = 0; i < N_SMPLS; i++, t++) {
+		I = 0.3*cos(w1*t) + 0.001*cos(w2*t) + 1.0e-4*noise();
+		Q = 0.3*sin(w1*t) + 0.001*sin(w2*t) + 1.0e-4*noise();
+		vi = (int)(I * 8388607.0);
+		vq = (int)(Q * 8388607.0);
+		p = frm + 6*i;
+		p[0] = (unsigned char)(vi >> 16); p[1] = (unsigned char)(vi >> 8); p[2] = (unsigned char)vi;
+		p[3] = (unsigned char)(vq >> 16); p[4] = (unsigned char)(vq >> 8); p[5] = (unsigned char)vq;
+	}
+}
+
+// One receiver at 48K with no TX, its audio routed to both output channels
+static void open_path() {
+	test_args.num_rx = 1;
+	test_args.rx[0].ch_id = CH_ID;
+	test_args.num_tx = 0;
+	test_args.general.in_rate = RATE;
+	test_args.general.out_rate = RATE;
+	test_args.general.iq_blk_sz = N_SMPLS;
+	test_args.general.mic_blk_sz = N_SMPLS;
+	test_args.audio.routing.hpsdr[0].rx = 1;
+	strcpy(test_args.audio.routing.hpsdr[0].ch, BOTH);
+	test_args.audio.routing.hpsdr[1].rx = -1;
+	test_ppl.args = &test_args;
+	// The AGC output peaks well above full scale, bring it down to about -3 dBFS
+	test_ppl.gain[0] = 0.2;
+	test_ppl.rb_iq_in[0] = ringb_create(4 * N_SMPLS * 2 * sizeof(dsp_t));
+	test_ppl.rb_mic_in = ringb_create(4 * N_SMPLS * 2 * sizeof(dsp_t));
+	eq_out = ep2_queue_create(QUEUE_FRAMES);
+
+	// The pipeline's own transform structure
+	ptr = (Transforms *)safealloc(sizeof(Transforms), sizeof(char), "TRANSFORMS_STRUCT");
+	init_transform(&test_ppl);
+
+	// The receiver as the server opens it, other than waiting for output on each exchange
+	OpenChannel(CH_ID, N_SMPLS, N_SMPLS, RATE, RATE, RATE, 0, 1, 0.010, 0.025, 0.0, 0.010, 1);
+	SetRXAMode(CH_ID, RXA_USB);
+	SetRXABandpassFreqs(CH_ID, 150.0, 2850.0);
+}
+
+// Run the whole path, N_FRAMES * NUM_SMPLS_1_RADIO 16 bit L/R pairs big endian into pcm
+static int run_path(unsigned char *pcm) {
+	static unsigned char frm[N_SMPLS * 6];
+	static dsp_t iq[2 * N_SMPLS], mic[2 * N_SMPLS];
+	dsp_t *dst[1] = { iq };
+	unsigned char *frame, *smpl;
+	int b, i, frames = 0;
+
+	iq_unpack_init();
+	for (b = 0; b < BLOCKS; b++) {
+		// The reader's part
+		make_frames(frm, (long)b * N_SMPLS);
+		iq_unpack(frm, 6, N_SMPLS, 1, dst, 0, 1.0 / 8388608.0);
+		ringb_write(test_ppl.rb_iq_in[0], (char *)iq, sizeof(iq));
+		ringb_write(test_ppl.rb_mic_in, (char *)mic, sizeof(mic));
+		// The pipeline's part
+		if (!run_block(&test_ppl, ptr)) {
+			fprintf(stderr, "test_dsp_precision: block %d was not run\n", b);
+			return FALSE;
+		}
+		// The writer's part, keep L/R from each 8 byte sample of the complete frames
+		while (ep2_queue_read_space(eq_out) > 0 && frames < N_FRAMES) {
+			frame = ep2_queue_get_frame(eq_out, 0);
+			for (i = 0; i < NUM_SMPLS_1_RADIO; i++) {
+				if (i < NUM_SMPLS_1_RADIO / 2)
+					smpl = frame + START_FRAME_1 + i * EP2_SMPL_SZ;
+				else
+					smpl = frame + START_FRAME_2 + (i - NUM_SMPLS_1_RADIO / 2) * EP2_SMPL_SZ;
+				memcpy(pcm + ((size_t)frames * NUM_SMPLS_1_RADIO + i) * 4, smpl, 4);
+			}
+			ep2_queue_read_advance(eq_out, 1);
+			frames++;
+		}
+	}
+	return frames == N_FRAMES;
+}
+
+#ifndef DSP_FLOAT
+// Double is the reference
+static int check(const unsigned char *pcm, size_t n_bytes, const char *path) {
+	FILE *f;
+
+	if ((f = fopen(path, "wb")) == NULL || fwrite(pcm, 1, n_bytes, f) != n_bytes) {
+		fprintf(stderr, "test_dsp_precision: cannot write %s\n", path);
+		return 2;
+	}
+	fclose(f);
+	printf("test_dsp_precision: %s/%s wrote %s\n", DSP_PRECISION, pcm_pack_name(), path);
+	return 0;
+}
+#else
+static int check(const unsigned char *pcm, size_t n_bytes, const char *path) {
+	unsigned char *ref = (unsigned char *)malloc(n_bytes);
+	size_t i;
+	int v, r, d, max_d = 0, pass;
+	long differ = 0;
+	double sig = 0.0, err = 0.0, snr;
+	FILE *f;
+
+	if ((f = fopen(path, "rb")) == NULL || fread(ref, 1, n_bytes, f) != n_bytes) {
+		fprintf(stderr, "test_dsp_precision: cannot read %s, run the double build first\n", path);
+		return 2;
+	}
+	fclose(f);
+	for (i = 0; i < n_bytes; i += 2) {
+		v = (short)((pcm[i] << 8) | pcm[i + 1]);
+		r = (short)((ref[i] << 8) | ref[i + 1]);
+		d = abs(v - r);
+		if (d > max_d) max_d = d;
+		if (d) differ++;
+		sig += (double)r * r;
+		err += (double)d * d;
+	}
+	free(ref);
+	snr = err > 0.0 ? 10.0 * log10(sig / err) : INFINITY;
+	pass = snr >= MIN_SNR && max_d <= 1;
+	printf("test_dsp_precision: %s/%s against double, SNR %.1f dB, %ld of %ld values differ, max %d LSB: %s\n",
+		DSP_PRECISION, pcm_pack_name(), snr, differ, (long)(n_bytes / 2), max_d, pass ? "PASS" : "FAIL");
+	return pass ? 0 : 1;
+}
+#endif
+
+int main(int argc, char **argv) {
+	size_t n_bytes = (size_t)N_FRAMES * NUM_SMPLS_1_RADIO * 4;
+	unsigned char *pcm;
+	int ret;
+
+	if (argc != 2) {
+		fprintf(stderr, "usage: %s reference.pcm\n", argv[0]);
+		return 2;
+	}
+	pcm = (unsigned char *)malloc(n_bytes);
+	open_path();
+	if (!run_path(pcm)) {
+		printf("test_dsp_precision: %s/%s the pipeline did not produce %d frames: FAIL\n", DSP_PRECISION, pcm_pack_name(), N_FRAMES);
+		free(pcm);
+		return 1;
+	}
+	ret = check(pcm, n_bytes, argv[1]);
+	CloseChannel(CH_ID);
+	free(pcm);
+	return ret;
+}
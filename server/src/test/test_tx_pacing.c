@@ -0,0 +1,224 @@
+/*
+test_tx_pacing.c
+
+Output pacing check for the UDP writer
+
+Copyright (C) 2018 by G3UKB Bob Cowdery
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+The authors can be reached by email at:
+
+	bob@bobcowdery.plus.com
+
+*/
+
+/*
+Run by 'make check'. The real writer loop runs on a simulated clock. clock_gettime,
+clock_nanosleep, sendmmsg and pthread_create are wrapped at link time, so the loop
+runs on this thread and every sleep advances the clock to the deadline plus some
+wake up jitter. While the writer sleeps a simulated pipeline adds IQ_BLK_SZ samples
+to the output queue each block period, up to 1 ms late, just as do_encode() does.
+Each sample carries its index so the sent frames can be checked for order.
+
+With the pipeline at the nominal rate there must be no slips and no underruns. With
+the pipeline clock fast the writer must slip frames and hold the backlog down without
+an underrun. With it slow the underruns are unavoidable but there must be no slips.
+*/
+
+// Includes
+#define _GNU_SOURCE
+#include "../common/include.h"
+
+#define RATE 48000
+#define SECONDS 120
+#define QUEUE_FRAMES 64
+#define BLOCK_JITTER_NS 1000000LL
+#define WAKE_JITTER_NS 300000LL
+#define LONG_WAKE_NS 6000000LL
+
+extern UDPWriterThreadData *udp_writer_td;
+
+typedef struct Scenario {
+	const char *name;
+	double ppm;				// pipeline clock error, positive is fast
+} Scenario;
+
+static const Scenario scenarios[] = {
+	{ "nominal", 0.0 },
+	{ "pipeline 500 ppm fast", 500.0 },
+	{ "pipeline 500 ppm slow", -500.0 }
+};
+
+// Simulation state
+static long long vnow;				// the simulated monotonic clock
+static long long end_ns;
+static double block_ns;
+static long long block_t0;			// when the pipeline started
+static long block_count;
+static long long next_block;
+static unsigned int seed = 1;
+static unsigned int smpl_index;		// index of the next sample the pipeline writes, from 1
+static unsigned int expect;			// index the next data frame should start at
+static long data_frames, silent_after_data, order_errors, overflows;
+static int max_backlog;
+
+static unsigned int lcg() {
+	seed = seed * 1103515245u + 12345u;
+	return (seed >> 8) & 0xffff;
+}
+
+static unsigned int get32(const unsigned char *p) {
+	return ((unsigned int)p[0] << 24) | ((unsigned int)p[1] << 16) | ((unsigned int)p[2] << 8) | p[3];
+}
+
+// One pipeline block into the output queue, as do_encode() writes it
+static void feed_block() {
+	int n, i, remaining = IQ_BLK_SZ;
+	unsigned char *buf;
+
+	if (ep2_queue_write_space(eq_out) < remaining) {
+		overflows++;
+		return;
+	}
+	while (remaining > 0) {
+		buf = ep2_queue_get_write_run(eq_out, &n);
+		if (n > remaining) n = remaining;
+		for (i = 0; i < n; i++, smpl_index++) {
+			memset(buf + i * EP2_SMPL_SZ, 0, EP2_SMPL_SZ);
+			buf[i * EP2_SMPL_SZ + 0] = (unsigned char)(smpl_index >> 24);
+			buf[i * EP2_SMPL_SZ + 1] = (unsigned char)(smpl_index >> 16);
+			buf[i * EP2_SMPL_SZ + 2] = (unsigned char)(smpl_index >> 8);
+			buf[i * EP2_SMPL_SZ + 3] = (unsigned char)smpl_index;
+		}
+		ep2_queue_write_advance(eq_out, n);
+		remaining -= n;
+	}
+}
+
+int __wrap_clock_gettime(clockid_t clk, struct timespec *ts) {
+	(void)clk;
+	ts->tv_sec = vnow / 1000000000LL;
+	ts->tv_nsec = vnow % 1000000000LL;
+	return 0;
+}
+
+int __wrap_clock_nanosleep(clockid_t clk, int flags, const struct timespec *req, struct timespec *rem) {
+	long long deadline = (long long)req->tv_sec * 1000000000LL + req->tv_nsec;
+	long long wake;
+	int backlog;
+
+	(void)clk; (void)flags; (void)rem;
+	// Wake a little late and now and then a lot late
+	wake = (deadline > vnow ? deadline : vnow) + (long long)lcg() * WAKE_JITTER_NS / 65536;
+	if (lcg() % 1000 == 0)
+		wake += LONG_WAKE_NS;
+	// The pipeline runs while the writer sleeps
+	while (next_block <= wake) {
+		vnow = next_block;
+		feed_block();
+		block_count++;
+		next_block = block_t0 + (long long)((block_count + 1) * block_ns) + (long long)lcg() * BLOCK_JITTER_NS / 65536;
+	}
+	vnow = wake;
+	backlog = ep2_queue_read_space(eq_out);
+	if (backlog > max_backlog)
+		max_backlog = backlog;
+	if (vnow >= end_ns) {
+		udp_writer_td->run = FALSE;
+		udp_writer_td->terminate = TRUE;
+	}
+	return 0;
+}
+
+int __wrap_sendmmsg(int sd, struct mmsghdr *msgs, unsigned int n, int flags) {
+	unsigned int i, first;
+	unsigned char *p;
+
+	(void)sd; (void)flags;
+	for (i = 0; i < n; i++) {
+		p = (unsigned char *)msgs[i].msg_hdr.msg_iov[0].iov_base;
+		first = get32(p + START_FRAME_1);
+		if (first == 0) {
+			if (data_frames > 0)
+				silent_after_data++;
+			continue;
+		}
+		if ((data_frames > 0 && first != expect) || get32(p + START_FRAME_2) != first + DATA_SZ / EP2_SMPL_SZ)
+			order_errors++;
+		expect = first + NUM_SMPLS_1_RADIO;
+		data_frames++;
+	}
+	return (int)n;
+}
+
+int __wrap_pthread_create(pthread_t *thread, const pthread_attr_t *attr, void *(*start)(void *), void *arg) {
+	// The writer loop is run on this thread
+	(void)thread; (void)attr; (void)start; (void)arg;
+	return 0;
+}
+
+static int run_scenario(const Scenario *s) {
+	struct sockaddr_in addr;
+	WriterStats stats;
+	double extra;
+	int ok;
+
+	// Fresh queue, statistics and pipeline
+	ep2_queue_reset(eq_out);
+	writer_reset_stats();
+	block_ns = (double)IQ_BLK_SZ * 1.0e9 / RATE / (1.0 + s->ppm * 1.0e-6);
+	block_t0 = vnow;
+	block_count = 0;
+	next_block = block_t0 + (long long)block_ns;
+	end_ns = vnow + SECONDS * 1000000000LL;
+	smpl_index = 1;
+	data_frames = silent_after_data = order_errors = overflows = 0;
+	max_backlog = 0;
+	// Run the writer until the simulated time is up
+	memset(&addr, 0, sizeof(addr));
+	udp_writer_td->terminate = FALSE;
+	writer_start(&addr);
+	udp_writer_imp(udp_writer_td);
+	writer_get_stats(&stats);
+
+	// Frames the pipeline gains over the writer in the run
+	extra = (double)SECONDS * RATE / NUM_SMPLS_1_RADIO * s->ppm * 1.0e-6;
+	ok = order_errors == 0 && overflows == 0 && silent_after_data == stats.underruns && stats.resyncs == 0;
+	if (s->ppm == 0.0)
+		ok = ok && stats.slips == 0 && stats.underruns == 0;
+	else if (s->ppm > 0.0)
+		ok = ok && stats.slips > 0 && stats.slips <= extra + 1 && stats.underruns == 0 && max_backlog <= TX_MAX_BACKLOG + udp_writer_td->block_frames + 2;
+	else
+		ok = ok && stats.slips == 0;
+	printf("test_tx_pacing: %s, %ld data frames, %u slips, %u underruns, max backlog %d, %ld out of order: %s\n",
+		s->name, data_frames, stats.slips, stats.underruns, max_backlog, order_errors, ok ? "PASS" : "FAIL");
+	return ok;
+}
+
+int main() {
+	int i, fails = 0;
+
+	eq_out = ep2_queue_create(QUEUE_FRAMES);
+	if (!writer_init(0, RATE, IQ_BLK_SZ)) {
+		printf("test_tx_pacing: writer_init failed: FAIL\n");
+		return 1;
+	}
+	for (i = 0; i < (int)(sizeof(scenarios) / sizeof(scenarios[0])); i++) {
+		if (!run_scenario(&scenarios[i]))
+			fails++;
+	}
+	return fails ? 1 : 0;
+}
@@ -73,7 +73,7 @@ void create_rxa (int channel)
 		0.100,											// averaging time constant
 		0.100,											// peak decay time constant
 		rxa[channel].meter,								// result vector
-		rxa[channel].pmtupdate,							// locks for meter access
+		rxa[channel].pmtseq,							// sequence counts for meter reads
 		RXA_ADC_AV,										// index for average value
 		RXA_ADC_PK,										// index for peak value
 		-1,												// index for gain value
@@ -145,7 +145,7 @@ void create_rxa (int channel)
 		0.100,											// averaging time constant
 		0.100,											// peak decay time constant
 		rxa[channel].meter,								// result vector
-		rxa[channel].pmtupdate,							// locks for meter access
+		rxa[channel].pmtseq,							// sequence counts for meter reads
 		RXA_S_AV,										// index for average value
 		RXA_S_PK,										// index for peak value
 		-1,												// index for gain value
@@ -310,7 +310,6 @@ void create_rxa (int channel)
 		1.0,											// lincr
 		3.0);											// ldecr
 	// EMNR
-	/* RAC
 	rxa[channel].emnr.p = create_emnr (
 		0,												// run
 		0,												// position
@@ -325,7 +324,6 @@ void create_rxa (int channel)
 		2,												// gain method
 		0,												// npe_method
 		1);												// ae_run
-	*/
 	// AGC
 	rxa[channel].agc.p = create_wcpagc (
 		1,												// run
@@ -361,7 +359,7 @@ void create_rxa (int channel)
 		0.100,											// averaging time constant
 		0.100,											// peak decay time constant
 		rxa[channel].meter,								// result vector
-		rxa[channel].pmtupdate,							// locks for meter access
+		rxa[channel].pmtseq,							// sequence counts for meter reads
 		RXA_AGC_AV,										// index for average value
 		RXA_AGC_PK,										// index for peak value
 		RXA_AGC_GAIN,									// index for gain value
@@ -455,12 +453,21 @@ void create_rxa (int channel)
 		0,												// select ncoef automatically
 		1.0);											// gain
 
+	// stage executor, runs the whole chain in turn until SetRXAPipeline() splits it
+	rxa[channel].pipe.p = create_pipeline (
+		channel,										// channel number
+		RXA_GROUPS,										// number of stage groups
+		xrxa_group,										// runs one stage group
+		ch[channel].dsp_size,							// block size
+		rxa[channel].midbuff);							// buffer of the first segment
+
 	// turn OFF / ON resamplers as needed
 	RXAResCheck (channel);
 }
 
 void destroy_rxa (int channel)
 {
+	destroy_pipeline (rxa[channel].pipe.p);
 	destroy_resample (rxa[channel].rsmpout.p);
 	destroy_panel (rxa[channel].panel.p);
 	destroy_mpeak (rxa[channel].mpeak.p);
@@ -470,8 +477,7 @@ void destroy_rxa (int channel)
 	destroy_bandpass (rxa[channel].bp1.p);
 	destroy_meter (rxa[channel].agcmeter.p);
 	destroy_wcpagc (rxa[channel].agc.p);
-	// *RAC* NR hangs with this universal version!!
-	//destroy_emnr (rxa[channel].emnr.p);
+	destroy_emnr (rxa[channel].emnr.p);
 	destroy_anr (rxa[channel].anr.p);
 	destroy_anf (rxa[channel].anf.p);
 	destroy_eqp (rxa[channel].eqp.p);
@@ -499,6 +505,7 @@ void flush_rxa (int channel)
 	memset (rxa[channel].inbuff,  0, 1 * ch[channel].dsp_insize  * sizeof (complex));
 	memset (rxa[channel].outbuff, 0, 1 * ch[channel].dsp_outsize * sizeof (complex));
 	memset (rxa[channel].midbuff, 0, 2 * ch[channel].dsp_size    * sizeof (complex));
+	flush_pipeline (rxa[channel].pipe.p);
 	flush_shift (rxa[channel].shift.p);
 	flush_resample (rxa[channel].rsmpin.p);
 	flush_gen (rxa[channel].gen0.p);
@@ -527,44 +534,61 @@ void flush_rxa (int channel)
 	flush_resample (rxa[channel].rsmpout.p);
 }
 
+// The chain is cut into groups only where no stage spans the cut: bpsnba and the position 0 / 1 pairs of
+// anf, anr, emnr and bp1 each stay inside one group.  amsq captures its trigger in group 1 and acts in
+// group 3, so its trigger is delayed by as many blocks as separate those groups' segments.
+void xrxa_group (int channel, int group)
+{
+	switch (group)
+	{
+	case 0:		// frequency shift, resample to the dsp rate
+		xshift (rxa[channel].shift.p);
+		xresample (rxa[channel].rsmpin.p);
+		xgen (rxa[channel].gen0.p);
+		xmeter (rxa[channel].adcmeter.p); 
+		break;
+	case 1:		// notched bandpass, demodulators, snba, equalizer
+		xbpsnbain (rxa[channel].bpsnba.p, 0);
+		xnbp (rxa[channel].nbp0.p, 0);
+		xmeter (rxa[channel].smeter.p);
+		xsender (rxa[channel].sender.p);
+		xamsqcap (rxa[channel].amsq.p);
+		xbpsnbaout (rxa[channel].bpsnba.p, 0);
+		xamd (rxa[channel].amd.p);
+		xfmd (rxa[channel].fmd.p);
+		xfmsq (rxa[channel].fmsq.p);
+		xbpsnbain (rxa[channel].bpsnba.p, 1);
+		xbpsnbaout (rxa[channel].bpsnba.p, 1);
+		xsnba (rxa[channel].snba.p);
+		xeqp (rxa[channel].eqp.p);
+		break;
+	case 2:		// noise blanking and reduction, bandpass, agc
+		xanf (rxa[channel].anf.p, 0);
+		xanr (rxa[channel].anr.p, 0);
+		xemnr (rxa[channel].emnr.p, 0);
+		xbandpass (rxa[channel].bp1.p, 0);
+		xwcpagc (rxa[channel].agc.p);
+		xanf (rxa[channel].anf.p, 1);
+		xanr (rxa[channel].anr.p, 1);
+		xemnr (rxa[channel].emnr.p, 1);
+		xbandpass (rxa[channel].bp1.p, 1);
+		xmeter (rxa[channel].agcmeter.p);
+		break;
+	case 3:		// output
+		xsiphon (rxa[channel].sip1.p, 0);
+		xcbl (rxa[channel].cbl.p);
+		xspeak (rxa[channel].speak.p);
+		xmpeak (rxa[channel].mpeak.p);
+		xpanel (rxa[channel].panel.p);
+		xamsq (rxa[channel].amsq.p);
+		xresample (rxa[channel].rsmpout.p);
+		break;
+	}
+}
+
 void xrxa (int channel)
 {
-	xshift (rxa[channel].shift.p);
-	xresample (rxa[channel].rsmpin.p);
-	xgen (rxa[channel].gen0.p);
-	xmeter (rxa[channel].adcmeter.p); 
-	xbpsnbain (rxa[channel].bpsnba.p, 0);
-	xnbp (rxa[channel].nbp0.p, 0);
-	xmeter (rxa[channel].smeter.p);
-	xsender (rxa[channel].sender.p);
-	xamsqcap (rxa[channel].amsq.p);
-	xbpsnbaout (rxa[channel].bpsnba.p, 0);
-	xamd (rxa[channel].amd.p);
-	xfmd (rxa[channel].fmd.p);
-	xfmsq (rxa[channel].fmsq.p);
-	xbpsnbain (rxa[channel].bpsnba.p, 1);
-	xbpsnbaout (rxa[channel].bpsnba.p, 1);
-	xsnba (rxa[channel].snba.p);
-	xeqp (rxa[channel].eqp.p);
-	xanf (rxa[channel].anf.p, 0);
-	xanr (rxa[channel].anr.p, 0);
-	// *RAC* NR hangs with this universal version!!
-	//xemnr (rxa[channel].emnr.p, 0);
-	xbandpass (rxa[channel].bp1.p, 0);
-	xwcpagc (rxa[channel].agc.p);
-	xanf (rxa[channel].anf.p, 1);
-	xanr (rxa[channel].anr.p, 1);
-	// *RAC* NR hangs with this universal version!!
-	//xemnr (rxa[channel].emnr.p, 1);
-	xbandpass (rxa[channel].bp1.p, 1);
-	xmeter (rxa[channel].agcmeter.p);
-	xsiphon (rxa[channel].sip1.p, 0);
-	xcbl (rxa[channel].cbl.p);
-	xspeak (rxa[channel].speak.p);
-	xmpeak (rxa[channel].mpeak.p);
-	xpanel (rxa[channel].panel.p);
-	xamsq (rxa[channel].amsq.p);
-	xresample (rxa[channel].rsmpout.p);
+	xpipeline (rxa[channel].pipe.p);
 }
 
 void setInputSamplerate_rxa (int channel)
@@ -589,7 +613,7 @@ void setOutputSamplerate_rxa (int channel)
 	_aligned_free (rxa[channel].outbuff);
 	rxa[channel].outbuff = (double *)malloc0(1 * ch[channel].dsp_outsize * sizeof(complex));
 	// output resampler
-	setBuffers_resample (rxa[channel].rsmpout.p, rxa[channel].midbuff, rxa[channel].outbuff);
+	setBuffers_resample (rxa[channel].rsmpout.p, groupBuffer_pipeline (rxa[channel].pipe.p, 3), rxa[channel].outbuff);
 	setOutRate_resample (rxa[channel].rsmpout.p, ch[channel].out_rate);
 	RXAResCheck (channel);
 }
@@ -637,6 +661,12 @@ void setDSPSamplerate_rxa (int channel)
 	setBuffers_resample (rxa[channel].rsmpout.p, rxa[channel].midbuff, rxa[channel].outbuff);
 	setInRate_resample (rxa[channel].rsmpout.p, ch[channel].dsp_rate);
 	RXAResCheck (channel);
+	if (rxa[channel].pipe.p->nsegs > 1)
+	{
+		// amsq has restarted its trigger delay
+		flush_pipeline (rxa[channel].pipe.p);
+		RXAPipeSet (channel);
+	}
 }
 
 void setDSPBuffsize_rxa (int channel)
@@ -648,6 +678,9 @@ void setDSPBuffsize_rxa (int channel)
 	rxa[channel].midbuff = (double *)malloc0(2 * ch[channel].dsp_size * sizeof(complex));
 	_aligned_free (rxa[channel].outbuff);
 	rxa[channel].outbuff = (double *)malloc0(1 * ch[channel].dsp_outsize * sizeof(complex));
+	// pipeline
+	setBuffers_pipeline (rxa[channel].pipe.p, rxa[channel].midbuff);
+	setSize_pipeline (rxa[channel].pipe.p, ch[channel].dsp_size);
 	// shift
 	setBuffers_shift (rxa[channel].shift.p, rxa[channel].inbuff, rxa[channel].inbuff);
 	setSize_shift (rxa[channel].shift.p, ch[channel].dsp_insize);
@@ -704,6 +737,8 @@ void setDSPBuffsize_rxa (int channel)
 	// output resampler
 	setBuffers_resample (rxa[channel].rsmpout.p, rxa[channel].midbuff, rxa[channel].outbuff);
 	setSize_resample (rxa[channel].rsmpout.p, ch[channel].dsp_size);
+	if (rxa[channel].pipe.p->nsegs > 1)
+		RXAPipeSet (channel);
 }
 
 /********************************************************************************************************
@@ -771,7 +806,7 @@ void RXAbp1Check (int channel, int amd_run, int snba_run,
 	
 	if (amd_run ||
 		snba_run ||
-		// RAC crashes! emnr_run ||
+		emnr_run ||
 		anf_run ||
 		anr_run) {
 		gain = 2.0;
@@ -796,7 +831,7 @@ void RXAbp1Set (int channel)
 	
 	if ((rxa[channel].amd.p->run == 1) ||
 		(rxa[channel].snba.p->run == 1) ||
-		// RAC crashes! (rxa[channel].emnr.p->run == 1) ||
+		(rxa[channel].emnr.p->run == 1) ||
 		(rxa[channel].anf.p->run == 1) ||
 		(rxa[channel].anr.p->run == 1)) 
 	{
@@ -941,3 +976,77 @@ void RXASetMP (int channel, int mp)
 	SetRXAFMMPde				(channel, mp);
 	SetRXAFMMPaud				(channel, mp);
 }
+
+/********************************************************************************************************
+*																										*
+*											RXA Pipeline												*
+*																										*
+********************************************************************************************************/
+
+void RXAPipeSet (int channel)
+{
+	// point every stage at the buffer of the segment that runs its group
+	PIPELINE p = rxa[channel].pipe.p;
+	double* b1 = groupBuffer_pipeline (p, 1);
+	double* b2 = groupBuffer_pipeline (p, 2);
+	double* b3 = groupBuffer_pipeline (p, 3);
+	// group 1
+	setBuffers_bpsnba (rxa[channel].bpsnba.p, b1, b1);
+	setBuffers_nbp (rxa[channel].nbp0.p, b1, b1);
+	setBuffers_meter (rxa[channel].smeter.p, b1);
+	setBuffers_sender (rxa[channel].sender.p, b1);
+	setBuffers_amd (rxa[channel].amd.p, b1, b1);
+	setBuffers_fmd (rxa[channel].fmd.p, b1, b1);
+	setBuffers_fmsq (rxa[channel].fmsq.p, b1, b1, rxa[channel].fmd.p->audio);
+	setBuffers_snba (rxa[channel].snba.p, b1, b1);
+	setBuffers_eqp (rxa[channel].eqp.p, b1, b1);
+	// group 2
+	setBuffers_anf (rxa[channel].anf.p, b2, b2);
+	setBuffers_anr (rxa[channel].anr.p, b2, b2);
+	setBuffers_emnr (rxa[channel].emnr.p, b2, b2);
+	setBuffers_bandpass (rxa[channel].bp1.p, b2, b2);
+	setBuffers_wcpagc (rxa[channel].agc.p, b2, b2);
+	setBuffers_meter (rxa[channel].agcmeter.p, b2);
+	// group 3
+	setBuffers_siphon (rxa[channel].sip1.p, b3);
+	setBuffers_cbl (rxa[channel].cbl.p, b3, b3);
+	setBuffers_speak (rxa[channel].speak.p, b3, b3);
+	setBuffers_mpeak (rxa[channel].mpeak.p, b3, b3);
+	setBuffers_panel (rxa[channel].panel.p, b3, b3);
+	setBuffers_resample (rxa[channel].rsmpout.p, b3, rxa[channel].outbuff);
+	// amsq captures in group 1 and acts in group 3
+	setBuffers_amsq (rxa[channel].amsq.p, b3, b3, b1);
+	setDelay_amsq (rxa[channel].amsq.p, segment_pipeline (p, 3) - segment_pipeline (p, 1));
+}
+
+PORT
+void SetRXAPipeline (int channel, int segments, int first_core)
+{
+	// segments 1 to MAX_PIPE_SEGS, each extra segment adds one block of latency;
+	// workers are pinned to first_core, first_core + 1, ... unless first_core is -1
+	static const int first[MAX_PIPE_SEGS][MAX_PIPE_SEGS + 1] =
+	{
+		{ 0, 4 },
+		{ 0, 2, 4 },
+		{ 0, 1, 2, 4 },
+		{ 0, 1, 2, 3, 4 }
+	};
+	if (segments < 1) segments = 1;
+	if (segments > MAX_PIPE_SEGS) segments = MAX_PIPE_SEGS;
+	EnterCriticalSection (&ch[channel].csDSP);
+	setSegments_pipeline (rxa[channel].pipe.p, segments, first[segments - 1], first_core);
+	RXAPipeSet (channel);
+	// the last segment sits out the first steps
+	memset (rxa[channel].outbuff, 0, ch[channel].dsp_outsize * sizeof (complex));
+	LeaveCriticalSection (&ch[channel].csDSP);
+}
+
+PORT
+void GetRXAPipelineStats (int channel, int* segments, double* mean_us, double* max_us)
+{
+	// mean_us and max_us hold MAX_PIPE_SEGS entries, the time each segment takes per block
+	EnterCriticalSection (&ch[channel].csDSP);
+	*segments = rxa[channel].pipe.p->nsegs;
+	getStats_pipeline (rxa[channel].pipe.p, mean_us, max_us);
+	LeaveCriticalSection (&ch[channel].csDSP);
+}
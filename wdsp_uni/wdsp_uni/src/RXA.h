@@ -63,7 +63,7 @@ struct _rxa
 	double* midbuff;
 	int mode;
 	double meter[RXA_METERTYPE_LAST];
-	CRITICAL_SECTION* pmtupdate[RXA_METERTYPE_LAST];
+	volatile long* pmtseq[RXA_METERTYPE_LAST];
 	struct
 	{
 		METER p;
@@ -160,15 +160,23 @@ struct _rxa
 	{
 		CBL p;
 	} cbl;
+	struct
+	{
+		PIPELINE p;
+	} pipe;
 
 } rxa[MAX_CHANNELS];
 
+#define RXA_GROUPS		4		// stage groups the chain can be pipelined at
+
 extern void create_rxa (int channel);
 
 extern void destroy_rxa (int channel);
 
 extern void flush_rxa (int channel);
 
+extern void xrxa_group (int channel, int group);
+
 extern void xrxa (int channel);
 
 extern void setInputSamplerate_rxa (int channel);
@@ -193,4 +201,10 @@ extern void RXAbpsnbaCheck (int channel, int mode, int notch_run);
 
 extern void RXAbpsnbaSet (int channel);
 
+extern void RXAPipeSet (int channel);
+
+extern __declspec (dllexport) void SetRXAPipeline (int channel, int segments, int first_core);
+
+extern __declspec (dllexport) void GetRXAPipelineStats (int channel, int* segments, double* mean_us, double* max_us);
+
 #endif
\ No newline at end of file
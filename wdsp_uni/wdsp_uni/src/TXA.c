@@ -84,7 +84,7 @@ void create_txa (int channel)
 		0.100,										// averaging time constant
 		0.100,										// peak decay time constant
 		txa[channel].meter,							// result vector
-		txa[channel].pmtupdate,						// locks for meter access
+		txa[channel].pmtseq,						// sequence counts for meter reads
 		TXA_MIC_AV,									// index for average value
 		TXA_MIC_PK,									// index for peak value
 		-1,											// index for gain value
@@ -134,7 +134,7 @@ void create_txa (int channel)
 		0.100,										// averaging time constant
 		0.100,										// peak decay time constant
 		txa[channel].meter,							// result vector
-		txa[channel].pmtupdate,						// locks for meter access
+		txa[channel].pmtseq,						// sequence counts for meter reads
 		TXA_EQ_AV,									// index for average value
 		TXA_EQ_PK,									// index for peak value
 		-1,											// index for gain value
@@ -187,7 +187,7 @@ void create_txa (int channel)
 		0.100,										// averaging time constant
 		0.100,										// peak decay time constant
 		txa[channel].meter,							// result vector
-		txa[channel].pmtupdate,						// locks for meter access
+		txa[channel].pmtseq,						// sequence counts for meter reads
 		TXA_LVLR_AV,								// index for average value
 		TXA_LVLR_PK,								// index for peak value
 		TXA_LVLR_GAIN,								// index for gain value
@@ -227,7 +227,7 @@ void create_txa (int channel)
 		0.100,										// averaging time constant
 		0.100,										// peak decay time constant
 		txa[channel].meter,							// result vector
-		txa[channel].pmtupdate,						// locks for meter access
+		txa[channel].pmtseq,						// sequence counts for meter reads
 		TXA_CFC_AV,									// index for average value
 		TXA_CFC_PK,									// index for peak value
 		TXA_CFC_GAIN,								// index for gain value
@@ -299,7 +299,7 @@ void create_txa (int channel)
 		0.100,										// averaging time constant
 		0.100,										// peak decay time constant
 		txa[channel].meter,							// result vector
-		txa[channel].pmtupdate,						// locks for meter access
+		txa[channel].pmtseq,						// sequence counts for meter reads
 		TXA_COMP_AV,								// index for average value
 		TXA_COMP_PK,								// index for peak value
 		-1,											// index for gain value
@@ -382,7 +382,7 @@ void create_txa (int channel)
 		0.100,										// averaging time constant
 		0.100,										// peak decay time constant
 		txa[channel].meter,							// result vector
-		txa[channel].pmtupdate,						// locks for meter access
+		txa[channel].pmtseq,						// sequence counts for meter reads
 		TXA_ALC_AV,									// index for average value
 		TXA_ALC_PK,									// index for peak value
 		TXA_ALC_GAIN,								// index for gain value
@@ -465,7 +465,7 @@ void create_txa (int channel)
 		0.100,										// averaging time constant
 		0.100,										// peak decay time constant
 		txa[channel].meter,							// result vector
-		txa[channel].pmtupdate,						// locks for meter access
+		txa[channel].pmtseq,						// sequence counts for meter reads
 		TXA_OUT_AV,									// index for average value
 		TXA_OUT_PK,									// index for peak value
 		-1,											// index for gain value
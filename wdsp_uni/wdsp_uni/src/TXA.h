@@ -77,7 +77,7 @@ struct _txa
 	double f_low;
 	double f_high;
 	double meter[TXA_METERTYPE_LAST];
-	CRITICAL_SECTION* pmtupdate[TXA_METERTYPE_LAST];
+	volatile long* pmtseq[TXA_METERTYPE_LAST];
 	struct
 	{
 		METER p;
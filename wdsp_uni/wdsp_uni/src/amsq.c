@@ -49,7 +49,9 @@ void compute_slews(AMSQ a)
 void calc_amsq(AMSQ a)
 {
 	// signal averaging
-	a->trigsig = (double *)malloc0(a->size * sizeof(complex));
+	a->trigsig = (double *)malloc0((a->delay + 1) * a->size * sizeof(complex));
+	a->capidx = 0;
+	a->useidx = 0;
 	a->avm = exp(-1.0 / (a->rate * a->avtau));
 	a->onem_avm = 1.0 - a->avm;
 	a->avsig = 0.0;
@@ -100,7 +102,9 @@ void destroy_amsq (AMSQ a)
 
 void flush_amsq (AMSQ a)
 {
-	memset (a->trigsig, 0, a->size * sizeof (complex));
+	memset (a->trigsig, 0, (a->delay + 1) * a->size * sizeof (complex));
+	a->capidx = 0;
+	a->useidx = 0;
 	a->avsig = 0.0;
 	a->state = 0;
 }
@@ -120,9 +124,10 @@ void xamsq (AMSQ a)
 	{
 		int i;
 		double sig, siglimit;
+		double* trigsig = a->trigsig + 2 * a->size * a->useidx;
 		for (i = 0; i < a->size; i++)
 		{
-			sig = sqrt (a->trigsig[2 * i + 0] * a->trigsig[2 * i + 0] + a->trigsig[2 * i + 1] * a->trigsig[2 * i + 1]);
+			sig = sqrt (trigsig[2 * i + 0] * trigsig[2 * i + 0] + trigsig[2 * i + 1] * trigsig[2 * i + 1]);
 			a->avsig = a->avm * a->avsig + a->onem_avm * sig;
 			switch (a->state)
 			{
@@ -173,11 +178,15 @@ void xamsq (AMSQ a)
 	}
 	else if (a->in != a->out)
 		memcpy (a->out, a->in, a->size * sizeof (complex));
+	if (++a->useidx > a->delay)
+		a->useidx = 0;
 }
 
 void xamsqcap (AMSQ a)
 {
-	memcpy (a->trigsig, a->trigger, a->size * sizeof (complex));
+	memcpy (a->trigsig + 2 * a->size * a->capidx, a->trigger, a->size * sizeof (complex));
+	if (++a->capidx > a->delay)
+		a->capidx = 0;
 }
 
 void setBuffers_amsq (AMSQ a, double* in, double* out, double* trigger)
@@ -201,6 +210,15 @@ void setSize_amsq (AMSQ a, int size)
 	calc_amsq (a);
 }
 
+void setDelay_amsq (AMSQ a, int delay)
+{
+	// xamsq runs 'delay' blocks behind xamsqcap when they are in different pipeline segments,
+	// and starts 'delay' blocks later after a flush
+	decalc_amsq (a);
+	a->delay = delay;
+	calc_amsq (a);
+}
+
 /********************************************************************************************************
 *																										*
 *											RXA Properties												*
@@ -33,7 +33,10 @@ typedef struct _amsq
 	double* in;							// squelch input signal buffer
 	double* out;						// squelch output signal buffer
 	double* trigger;					// pointer to trigger data source
-	double* trigsig;					// buffer containing trigger signal
+	double* trigsig;					// buffers containing trigger signal, one per block of delay
+	int delay;							// blocks between capture and use of the trigger
+	int capidx;							// trigsig block written by xamsqcap
+	int useidx;							// trigsig block read by xamsq
 	double rate;						// sample rate
 	double avtau;						// time constant for averaging noise
 	double avm;						
@@ -70,6 +73,8 @@ extern void setSamplerate_amsq (AMSQ a, int rate);
 
 extern void setSize_amsq (AMSQ a, int size);
 
+extern void setDelay_amsq (AMSQ a, int delay);
+
 // RXA Properties
 
 extern __declspec (dllexport) void SetRXAAMSQRun (int channel, int run);
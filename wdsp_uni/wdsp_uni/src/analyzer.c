@@ -621,6 +621,7 @@ DWORD WINAPI spectra (void *pargs)
 			for (j = 0; j < dMAX_STITCH; j++)
 				for (i = 0; i < dMAX_NUM_FFT; i++)
 					InterlockedBitTestAndReset(&(a->input_busy[j][i]), 0);
+			SetEvent(a->hDispatchEvent);
 			stitch(disp);
 		}
 		else
@@ -706,6 +707,7 @@ DWORD WINAPI Cspectra (void *pargs)
 			for (j = 0; j < dMAX_STITCH; j++)
 				for (i = 0; i < dMAX_NUM_FFT; i++)
 					InterlockedBitTestAndReset(&(a->input_busy[j][i]), 0);
+			SetEvent(a->hDispatchEvent);
 			stitch(disp);
 		}
 		else
@@ -870,18 +872,11 @@ void __cdecl sendbuf(void *arg)
 					a->IQO_idx[a->ss][a->LO] = a->IQout_index[a->ss][a->LO];
 					
 					InterlockedIncrement(a->pnum_threads);
+					// on Linux the work items go to the pinned pool in linux_port.c so sub-spans run concurrently
 					if (a->type == 0)
-#if defined(linux) || defined(__APPLE__)
-                                                spectra((void *)(((intptr_t)arg << 12) + (a->ss << 4) + a->LO));
-#else
-						QueueUserWorkItem(spectra, (void *)(((int)arg << 12) + (a->ss << 4) + a->LO), 0);
-#endif
+						QueueUserWorkItem(spectra, (void *)(((intptr_t)arg << 12) + (a->ss << 4) + a->LO), 0);
 					else
-#if defined(linux) || defined(__APPLE__)
-                                                Cspectra((void *)(((intptr_t)arg << 12) + (a->ss << 4) + a->LO));
-#else
-						QueueUserWorkItem(Cspectra, (void *)(((int)arg << 12) + (a->ss << 4) + a->LO), 0);
-#endif
+						QueueUserWorkItem(Cspectra, (void *)(((intptr_t)arg << 12) + (a->ss << 4) + a->LO), 0);
 
 					if((a->IQout_index[a->ss][a->LO] += a->incr) >= a->bsize)
 						a->IQout_index[a->ss][a->LO] -= a->bsize;
@@ -892,7 +887,8 @@ void __cdecl sendbuf(void *arg)
 					LeaveCriticalSection(&(a->BufferControlSection[a->ss][a->LO]));
 				}
 			}
-		Sleep(1);
+		// sleep until a buffer becomes ready, a sub-span set completes or we are told to end
+		WaitForSingleObject(a->hDispatchEvent, INFINITE);
 	}
 	a->dispatcher = 0;
 	_endthread();
@@ -933,7 +929,10 @@ void SetAnalyzer (	int disp,			// display identifier
 	EnterCriticalSection(&a->SetAnalyzerSection);
 	a->end_dispatcher = 1;
 	while (a->dispatcher)
+	{
+		SetEvent(a->hDispatchEvent);
 		Sleep(1);
+	}
 	a->stop = 1;
 	while (_InterlockedAnd(a->pnum_threads, 1023))
 		Sleep(1);
@@ -1071,6 +1070,7 @@ void XCreateAnalyzer(	int disp,
 			a->hSnapEvent[i][j] = CreateEvent(NULL, FALSE, FALSE, TEXT("snap"));
 			a->snap[i][j] = 0;
 		}
+	a->hDispatchEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
 	InitializeCriticalSectionAndSpinCount(&a->ResampleSection, 0);
 	InitializeCriticalSectionAndSpinCount(&a->SetAnalyzerSection, 0);
 	InitializeCriticalSectionAndSpinCount(&a->StitchSection, 0);
@@ -1096,8 +1096,8 @@ void XCreateAnalyzer(	int disp,
 			a->plan[i][j] = 0;
 			a->Cplan[i][j] = 0;
 			a->fft_in[i][j]   = (double*) malloc0 (sizeof(double) * a->max_size);
-			a->Cfft_in[i][j]  = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * a->max_size);
-			a->fft_out[i][j]  = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * a->max_size);
+			a->Cfft_in[i][j]  = (fftw_complex*) malloc0 (sizeof(fftw_complex) * a->max_size);
+			a->fft_out[i][j]  = (fftw_complex*) malloc0 (sizeof(fftw_complex) * a->max_size);
 		}
 	a->pre_av_sum = (double*) malloc0 (sizeof(double) * a->max_size * a->max_stitch);
 	a->pre_av_out = (double*) malloc0 (sizeof(double) * a->max_size * a->max_stitch);
@@ -1153,7 +1153,10 @@ void DestroyAnalyzer(int disp)
 
 	a->end_dispatcher = 1;
 	while (a->dispatcher)
+	{
+		SetEvent(a->hDispatchEvent);
 		Sleep(1);
+	}
 
 	for (i = 0; i < a->max_stitch; i++)
 		for (j = 0; j < a->max_num_fft; j++)
@@ -1192,9 +1195,9 @@ void DestroyAnalyzer(int disp)
 		{
 			fftw_destroy_plan (a->plan[i][j]);
 			fftw_destroy_plan (a->Cplan[i][j]);
-			fftw_free (a->Cfft_in[i][j]);
+			_aligned_free (a->Cfft_in[i][j]);
 			_aligned_free (a->fft_in[i][j]);
-			fftw_free (a->fft_out[i][j]);
+			_aligned_free (a->fft_out[i][j]);
 		}
 	
 	for (i = 0; i < a->max_stitch; i++)
@@ -1216,6 +1219,7 @@ void DestroyAnalyzer(int disp)
 	for (i = 0; i < a->max_stitch; i++)
 		for (j = 0; j < a->max_num_fft; j++)
 			CloseHandle(a->hSnapEvent[i][j]);
+	CloseHandle(a->hDispatchEvent);
 
 	_aligned_free ((void *) a->pnum_threads);
 
@@ -1327,6 +1331,8 @@ void CloseBuffer(int disp, int ss, int LO)
 	if((a->IQin_index[ss][LO] += a->buff_size) >= a->bsize)	//REQUIRES buff_size IS A SUB-MULTIPLE OF SIZE OF INPUT SAMPLE BUFFS!
 		a->IQin_index[ss][LO] = 0;
 
+	if (_InterlockedAnd(&(a->buff_ready[ss][LO]), 1))
+		SetEvent(a->hDispatchEvent);
 	if (!a->dispatcher)
 	{
 		a->dispatcher = 1;
@@ -1366,6 +1372,8 @@ void Spectrum(int disp, int ss, int LO, dINREAL* pI, dINREAL* pQ)
 	if((a->IQin_index[ss][LO] += a->buff_size) >= a->bsize)	//REQUIRES buff_size IS A SUB-MULTIPLE OF SIZE OF INPUT SAMPLE BUFFS!
 		a->IQin_index[ss][LO] = 0;
 
+	if (_InterlockedAnd(&(a->buff_ready[ss][LO]), 1))
+		SetEvent(a->hDispatchEvent);
 	if (!a->dispatcher)
 	{
 		a->dispatcher = 1;
@@ -1411,6 +1419,8 @@ void Spectrum2(int run, int disp, int ss, int LO, dINREAL* pbuff)
 		if((a->IQin_index[ss][LO] += a->buff_size) >= a->bsize)	//REQUIRES buff_size IS A SUB-MULTIPLE OF SIZE OF INPUT SAMPLE BUFFS!
 			a->IQin_index[ss][LO] = 0;
 
+		if (_InterlockedAnd(&(a->buff_ready[ss][LO]), 1))
+			SetEvent(a->hDispatchEvent);
 		if (!a->dispatcher)
 		{
 			a->dispatcher = 1;
@@ -1457,6 +1467,8 @@ void Spectrum0(int run, int disp, int ss, int LO, double* pbuff)
 		if((a->IQin_index[ss][LO] += a->buff_size) >= a->bsize)	//REQUIRES buff_size IS A SUB-MULTIPLE OF SIZE OF INPUT SAMPLE BUFFS!
 			a->IQin_index[ss][LO] = 0;
 
+		if (_InterlockedAnd(&(a->buff_ready[ss][LO]), 1))
+			SetEvent(a->hDispatchEvent);
 		if (!a->dispatcher)
 		{
 			a->dispatcher = 1;
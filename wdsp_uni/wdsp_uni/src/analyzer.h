@@ -101,6 +101,7 @@ typedef struct _dp
 	int stop;												// when set, fft threads will be returned to the pool
 	int end_dispatcher;										// set this flag to one to destroy the dispatcher thread
 	int dispatcher;											// one if the dispatcher thread is alive & active
+	HANDLE hDispatchEvent;									// wakes the dispatcher when there may be work or it must end
 	int ss;													// sub-span being processed
 	int LO;													// LO (within current sub-span) being processed 
 	int flag;
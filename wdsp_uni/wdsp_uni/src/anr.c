@@ -68,7 +68,7 @@ ANR create_anr	(
 	a->lincr = lincr;
 	a->ldecr = ldecr;
 	
-	memset (a->d, 0, sizeof(double) * ANR_DLINE_SIZE);
+	memset (a->d, 0, sizeof(double) * 2 * ANR_DLINE_SIZE);
 	memset (a->w, 0, sizeof(double) * ANR_DLINE_SIZE);
 	
 	return a;
@@ -81,25 +81,22 @@ void destroy_anr (ANR a)
 
 void xanr (ANR a, int position)
 {
-    int i, j, idx;
+    int i, idx, delay, taps;
     double c0, c1;
     double y, error, sigma, inv_sigp;
 	double nel, nev;
+	double ys[2];
     if (a->run && (a->position == position))
 	{
+		// the delay line is mirrored above dline_size so the taps for any in_idx are contiguous
+		delay = a->delay & a->mask;
+		taps = min (a->n_taps, a->dline_size - 1 - delay);
+		a->d[a->in_idx] = a->d[a->in_idx + a->dline_size] = a->in_buff[0];
+		lmsdot (ys, a->w, &a->d[a->in_idx + delay], taps);
 		for (i = 0; i < a->buff_size; i++)
 		{
-			a->d[a->in_idx] = a->in_buff[2 * i + 0];
-
-			y = 0;
-			sigma = 0;
-
-			for (j = 0; j < a->n_taps; j++)
-			{
-				idx = (a->in_idx + j + a->delay) & a->mask;
-				y += a->w[j] * a->d[idx];
-				sigma += a->d[idx] * a->d[idx];
-			}
+			y = ys[0];
+			sigma = ys[1];
 			inv_sigp = 1.0 / (sigma + 1e-10);
 			error = a->d[a->in_idx] - y;
 
@@ -117,12 +114,13 @@ void xanr (ANR a, int position)
 			c0 = 1.0 - a->two_mu * a->ngamma;
 			c1 = a->two_mu * error * inv_sigp;
 
-			for (j = 0; j < a->n_taps; j++)
-			{
-				idx = (a->in_idx + j + a->delay) & a->mask;
-				a->w[j] = c0 * a->w[j] + c1 * a->d[idx];
-			}
+			idx = a->in_idx;
 			a->in_idx = (a->in_idx + a->mask) & a->mask;
+			// the next sample lands outside the current taps; adapt and form the next output in one pass,
+			// the output formed after the last sample is discarded and recomputed on the next call
+			if (i + 1 < a->buff_size)
+				a->d[a->in_idx] = a->d[a->in_idx + a->dline_size] = a->in_buff[2 * (i + 1) + 0];
+			lmsupd (ys, a->w, &a->d[idx + delay], &a->d[a->in_idx + delay], taps, c0, c1);
 		}
 	}
 	else if (a->in_buff != a->out_buff)
@@ -131,7 +129,7 @@ void xanr (ANR a, int position)
 
 void flush_anr (ANR a)
 {
-	memset (a->d, 0, sizeof(double) * ANR_DLINE_SIZE);
+	memset (a->d, 0, sizeof(double) * 2 * ANR_DLINE_SIZE);
 	memset (a->w, 0, sizeof(double) * ANR_DLINE_SIZE);
 	a->in_idx = 0;
 }
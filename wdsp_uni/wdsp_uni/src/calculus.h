@@ -1,2 +1,3 @@
-extern double GG[];
-extern double GGS[];
+#define CALCULUS_SIZE 241
+extern const float GG[];
+extern const float GGS[];
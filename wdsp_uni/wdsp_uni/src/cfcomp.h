@@ -27,6 +27,8 @@ warren@wpratt.com
 #ifndef _cfcomp_h
 #define _cfcomp_h
 
+#include "stft.h"
+
 typedef struct _cfcomp
 {
 	int run;
@@ -36,32 +38,15 @@ typedef struct _cfcomp
 	double* out;
 	int fsize;
 	int ovrlp;
-	int incr;
 	double* window;
-	int iasize;
-	double* inaccum;
-	double* forfftin;
-	double* forfftout;
+	STFT p;
+	double* forfftout;				// spectrum of the current frame, owned by p
 	int msize;
-	double* mask;
-	double* revfftin;
-	double* revfftout;
-	double** save;
-	int oasize;
-	double* outaccum;
+	double* mask;					// owned by p
 	double rate;
 	int wintype;
 	double pregain;
 	double postgain;
-	int nsamps;
-	int iainidx;
-	int iaoutidx;
-	int init_oainidx;
-	int oainidx;
-	int oaoutidx;
-	int saveidx;
-	fftw_plan Rfor;
-	fftw_plan Rrev;
 
 	int comp_method;
 	int nfreqs;
@@ -92,6 +77,8 @@ extern void destroy_cfcomp (CFCOMP a);
 
 extern void flush_cfcomp (CFCOMP a);
 
+extern void calc_mask (void* arg);
+
 extern void xcfcomp (CFCOMP a, int pos);
 
 extern void setBuffers_cfcomp (CFCOMP a, double* in, double* out);
@@ -25,6 +25,9 @@ warren@wpratt.com
 */
 
 #include "comm.h"
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_IX86)
+#include <pmmintrin.h>
+#endif
 
 void start_thread (int channel)
 {
@@ -34,7 +37,10 @@ void start_thread (int channel)
 //#else
 //	HANDLE handle = (HANDLE) wdsp_beginthread(main, 0, (void *)channel);
 //#endif
-	HANDLE handle = wdsp_beginthread(wdsp_main, 0, (void *)channel);
+	HANDLE handle;
+	if (attach_chansched (channel))
+		return;
+	handle = wdsp_beginthread(wdsp_main, 0, (void *)channel);
 	SetThreadPriority(handle, THREAD_PRIORITY_HIGHEST);
 }
 
@@ -101,9 +107,6 @@ void OpenChannel (int channel, int in_size, int dsp_size, int input_samplerate,
 		InterlockedBitTestAndReset (&ch[channel].iob.pc->exec_bypass, 0);
 		InterlockedBitTestAndSet (&ch[channel].exchange, 0);
 	}
-#if !defined(linux) && !defined(__APPLE__)
-	_MM_SET_FLUSH_ZERO_MODE (_MM_FLUSH_ZERO_ON);
-#endif
 }
 
 void pre_main_destroy (int channel)
@@ -112,7 +115,8 @@ void pre_main_destroy (int channel)
 	InterlockedBitTestAndReset (&ch[channel].exchange, 0);
 	InterlockedBitTestAndReset (&ch[channel].run, 0);
 	InterlockedBitTestAndSet (&ch[channel].iob.pc->exec_bypass, 0);
-	ReleaseSemaphore (a->Sem_BuffReady, 1, 0);
+	if (!detach_chansched (channel))
+		ReleaseSemaphore (a->Sem_BuffReady, 1, 0);
 	Sleep (25);
 }
 
@@ -137,6 +141,7 @@ void flushChannel (void* p)
 	EnterCriticalSection (&ch[channel].csDSP);
 	EnterCriticalSection (&ch[channel].csEXCH);
 	flush_iobuffs (channel);
+	flush_chansched (channel);
 	InterlockedBitTestAndSet (&ch[channel].iob.pc->exec_bypass, 0);
 	flush_main (channel);
 	LeaveCriticalSection (&ch[channel].csEXCH);
@@ -341,3 +346,48 @@ void SetChannelTSlewDown (int channel, double time)
 	create_slews (a);
 	LeaveCriticalSection (&ch[channel].csEXCH);
 }
+
+/********************************************************************************************************
+*																										*
+*											Denormal Handling											*
+*																										*
+********************************************************************************************************/
+
+// decaying filter, AGC and LMS state can sink into denormals on silence, which are very slow on x86;
+// the DSP threads flush them to zero unless told otherwise
+static volatile long flush_denormals = 1;
+
+PORT
+void SetFlushDenormals (int flush)
+{
+	// channel threads pick up the change before their next buffer
+	InterlockedExchange (&flush_denormals, flush ? 1 : 0);
+}
+
+int GetFlushDenormals (void)
+{
+	return _InterlockedAnd (&flush_denormals, 1);
+}
+
+PORT
+void SetThreadFlushDenormals (int flush)
+{
+	// applies to the calling thread only
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_IX86)
+	// FTZ for results, DAZ for inputs
+	_MM_SET_FLUSH_ZERO_MODE (flush ? _MM_FLUSH_ZERO_ON : _MM_FLUSH_ZERO_OFF);
+	_MM_SET_DENORMALS_ZERO_MODE (flush ? _MM_DENORMALS_ZERO_ON : _MM_DENORMALS_ZERO_OFF);
+#elif defined(__aarch64__)
+	// FZ is bit 24 of FPCR and covers both inputs and results
+	unsigned long long fpcr;
+	__asm__ __volatile__ ("mrs %0, fpcr" : "=r" (fpcr));
+	fpcr = flush ? (fpcr | (1ULL << 24)) : (fpcr & ~(1ULL << 24));
+	__asm__ __volatile__ ("msr fpcr, %0" : : "r" (fpcr));
+#elif defined(__arm__) && defined(__ARM_FP)
+	// FZ is bit 24 of FPSCR
+	unsigned int fpscr;
+	__asm__ __volatile__ ("vmrs %0, fpscr" : "=r" (fpscr));
+	fpscr = flush ? (fpscr | (1U << 24)) : (fpscr & ~(1U << 24));
+	__asm__ __volatile__ ("vmsr fpscr, %0" : : "r" (fpscr));
+#endif
+}
@@ -79,4 +79,10 @@ PORT void SetAllRates (int channel, int in_rate, int dsp_rate, int out_rate);
 
 PORT int SetChannelState (int channel, int state, int dmode);
 
+PORT void SetFlushDenormals (int flush);
+
+extern int GetFlushDenormals (void);
+
+PORT void SetThreadFlushDenormals (int flush);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,335 @@
+/*  chansched.c
+
+This file is part of a program that implements a Software-Defined Radio.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+// Without a scheduler each channel runs on a thread of its own, woken once per block by Sem_BuffReady.
+// With one, the channels opened afterwards are served by a fixed set of pinned workers instead: releasing
+// blocks puts the channel on a ready queue, a worker runs one block of it and puts it back at the tail
+// while it still has blocks pending, so busy channels take turns.  A channel is on a queue or being run
+// at most once, which keeps its blocks in order without a thread of its own.  TX channels can be given
+// a worker and core of their own.
+//
+// Every block is given a due time one block period after it is released, or after the previous block's
+// due time when that is later; a block done after its due time counts as a deadline miss.  This holds
+// whether the channel runs on its own thread or on the workers.
+
+#include "comm.h"
+
+typedef struct _schedw
+{
+	readyq* q;									// queue the worker serves
+	int core;									// core the worker is pinned to, -1 to leave it unpinned
+} schedw;
+
+static schedch sch[MAX_CHANNELS];
+static readyq pool_q;							// RX channels, and TX channels without a worker of their own
+static readyq tx_q;
+static schedw worker[MAX_SCHED_WORKERS + 1];
+static int nworkers;							// workers on pool_q
+static int ntotal;								// all workers, including the TX worker
+static int fifo;								// SCHED_FIFO priority of the workers, 0 for none
+static volatile long sched_run;
+static volatile long nattached;					// channels served by the workers
+static HANDLE Sem_Exit;
+static int initialized;
+
+static long long sched_now_ns (void)
+{
+#ifdef _WINDOWS_
+	LARGE_INTEGER c, f;
+	QueryPerformanceCounter (&c);
+	QueryPerformanceFrequency (&f);
+	return (long long)((double)c.QuadPart * 1.0e9 / (double)f.QuadPart);
+#else
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+#endif
+}
+
+static void create_readyq (readyq* q)
+{
+	InitializeCriticalSectionAndSpinCount (&q->cs, 2500);
+	q->Sem_Ready = CreateSemaphore (0, 0, MAX_CHANNELS + MAX_SCHED_WORKERS + 1, 0);
+	q->head = 0;
+	q->count = 0;
+}
+
+static void push_readyq (readyq* q, int channel)
+{
+	EnterCriticalSection (&q->cs);
+	q->chan[(q->head + q->count) % MAX_CHANNELS] = channel;
+	q->count++;
+	LeaveCriticalSection (&q->cs);
+	ReleaseSemaphore (q->Sem_Ready, 1, 0);
+}
+
+static int pop_readyq (readyq* q)
+{
+	int channel = -1;
+	EnterCriticalSection (&q->cs);
+	if (q->count > 0)
+	{
+		channel = q->chan[q->head];
+		q->head = (q->head + 1) % MAX_CHANNELS;
+		q->count--;
+	}
+	LeaveCriticalSection (&q->cs);
+	return channel;
+}
+
+static void queue_channel (int channel)
+{
+	if (!InterlockedBitTestAndSet (&sch[channel].queued, 0))
+		push_readyq (sch[channel].q, channel);
+}
+
+static void run_channel (int channel)
+{
+	schedch* s = &sch[channel];
+	EnterCriticalSection (&ch[channel].csDSP);
+	if (!_InterlockedAnd (&ch[channel].run, 1))
+		InterlockedExchange (&s->pending, 0);
+	else if (s->pending > 0)
+	{
+		InterlockedDecrement (&s->pending);
+		xmain (channel);
+	}
+	LeaveCriticalSection (&ch[channel].csDSP);
+	if (s->pending > 0)
+		push_readyq (s->q, channel);
+	else
+	{
+		// a block released after the test above finds the channel still queued, so look again
+		InterlockedBitTestAndReset (&s->queued, 0);
+		if (s->pending > 0)
+			queue_channel (channel);
+	}
+}
+
+void sched_worker (void* arg)
+{
+	schedw* w = (schedw *)arg;
+	int channel;
+	int flush = GetFlushDenormals ();
+	SetThreadFlushDenormals (flush);
+#if defined(linux) || defined(__APPLE__)
+	if (fifo > 0)
+		SetThreadFifoPriority (GetCurrentThread (), fifo);
+#else
+	SetThreadPriority (GetCurrentThread (), fifo > 0 ? THREAD_PRIORITY_TIME_CRITICAL : THREAD_PRIORITY_HIGHEST);
+#endif
+	if (w->core >= 0)
+		SetThreadAffinityMask (GetCurrentThread (), (DWORD_PTR)1 << w->core);
+	while (1)
+	{
+		WaitForSingleObject (w->q->Sem_Ready, INFINITE);
+		if (!_InterlockedAnd (&sched_run, 1))
+			break;
+		if ((channel = pop_readyq (w->q)) < 0)
+			continue;
+		if (GetFlushDenormals () != flush)
+			SetThreadFlushDenormals (flush = GetFlushDenormals ());
+		run_channel (channel);
+	}
+	ReleaseSemaphore (Sem_Exit, 1, 0);
+	_endthread ();
+}
+
+static void start_workers (void)
+{
+	int i;
+	InterlockedBitTestAndSet (&sched_run, 0);
+	for (i = 0; i < ntotal; i++)
+		wdsp_beginthread (sched_worker, 0, (void *)&worker[i]);
+}
+
+static void stop_workers (void)
+{
+	int i;
+	InterlockedBitTestAndReset (&sched_run, 0);
+	for (i = 0; i < ntotal; i++)
+		ReleaseSemaphore (worker[i].q->Sem_Ready, 1, 0);
+	for (i = 0; i < ntotal; i++)
+		WaitForSingleObject (Sem_Exit, INFINITE);
+	ntotal = 0;
+	nworkers = 0;
+}
+
+void release_chansched (int channel, int n)
+{
+	// called by fexchange with n more blocks ready to run
+	int i;
+	schedch* s = &sch[channel];
+	long long now = sched_now_ns ();
+	long long period = 1000000000LL * ch[channel].dsp_insize / ch[channel].in_rate;
+	for (i = 0; i < n; i++)
+	{
+		s->last_due = max (now, s->last_due) + period;
+		if (((s->due_in + 1) & (SCHED_DUE_SIZE - 1)) != s->due_out)
+		{
+			s->due[s->due_in] = s->last_due;
+			MemoryBarrier ();
+			s->due_in = (s->due_in + 1) & (SCHED_DUE_SIZE - 1);
+		}
+	}
+	if (_InterlockedAnd (&s->attached, 1))
+	{
+		InterlockedExchangeAdd (&s->pending, n);
+		queue_channel (channel);
+	}
+	else
+		ReleaseSemaphore (ch[channel].iob.pe->Sem_BuffReady, n, 0);
+}
+
+int attach_chansched (int channel)
+{
+	// returns TRUE if the workers take the channel, FALSE if it needs a thread of its own
+	schedch* s = &sch[channel];
+	s->pending = 0;
+	s->queued = 0;
+	s->due_in = 0;
+	s->due_out = 0;
+	s->last_due = 0;
+	s->blocks = 0;
+	s->misses = 0;
+	s->max_late_ns = 0;
+	if (ch[channel].type == 1 && ntotal > nworkers)
+		s->q = &tx_q;
+	else if (nworkers > 0)
+		s->q = &pool_q;
+	else
+		return FALSE;
+	InterlockedIncrement (&nattached);
+	InterlockedBitTestAndSet (&s->attached, 0);
+	return TRUE;
+}
+
+int detach_chansched (int channel)
+{
+	// ch[channel].run is already clear; returns FALSE if the channel has a thread of its own
+	schedch* s = &sch[channel];
+	if (!_InterlockedAnd (&s->attached, 1))
+		return FALSE;
+	// stays attached until no worker has it, dexchange() must not end a worker
+	while (_InterlockedAnd (&s->queued, 1))
+		Sleep (1);
+	InterlockedBitTestAndReset (&s->attached, 0);
+	InterlockedDecrement (&nattached);
+	return TRUE;
+}
+
+int attached_chansched (int channel)
+{
+	return _InterlockedAnd (&sch[channel].attached, 1);
+}
+
+void flush_chansched (int channel)
+{
+	// the caller holds csDSP and csEXCH
+	schedch* s = &sch[channel];
+	InterlockedExchange (&s->pending, 0);
+	s->due_out = s->due_in;
+	s->last_due = 0;
+}
+
+void complete_chansched (int channel, int ran)
+{
+	// called under csDSP once a block is taken, ran is 0 if it was bypassed
+	schedch* s = &sch[channel];
+	long long late;
+	if (ran)
+		s->blocks++;
+	if (s->due_out == s->due_in)
+		return;
+	MemoryBarrier ();
+	late = sched_now_ns () - s->due[s->due_out];
+	s->due_out = (s->due_out + 1) & (SCHED_DUE_SIZE - 1);
+	if (ran && late > 0)
+	{
+		s->misses++;
+		if (late > s->max_late_ns)
+			s->max_late_ns = late;
+	}
+}
+
+/********************************************************************************************************
+*																										*
+*											Properties													*
+*																										*
+********************************************************************************************************/
+
+PORT
+void SetChannelScheduler (int workers, int first_core, int fifo_priority, int tx_core)
+{
+	// applies to channels opened afterwards, and is ignored while any channel is served by the workers;
+	// workers 0 and tx_core -1 give every channel a thread of its own, as without a scheduler.
+	// Workers are pinned to first_core, first_core + 1, ... unless first_core is -1, the TX worker to
+	// tx_core.  fifo_priority 1 to 99 runs the workers SCHED_FIFO, which needs CAP_SYS_NICE on Linux.
+	int i;
+	if (_InterlockedAnd (&nattached, 0x7fffffff))
+		return;
+	if (!initialized)
+	{
+		create_readyq (&pool_q);
+		create_readyq (&tx_q);
+		Sem_Exit = CreateSemaphore (0, 0, MAX_SCHED_WORKERS + 1, 0);
+		initialized = 1;
+	}
+	if (ntotal > 0)
+		stop_workers ();
+	if (workers < 0) workers = 0;
+	if (workers > MAX_SCHED_WORKERS) workers = MAX_SCHED_WORKERS;
+	fifo = fifo_priority;
+	for (i = 0; i < workers; i++)
+	{
+		worker[i].q = &pool_q;
+		worker[i].core = first_core >= 0 ? first_core + i : -1;
+	}
+	nworkers = workers;
+	ntotal = workers;
+	if (tx_core >= 0)
+	{
+		worker[ntotal].q = &tx_q;
+		worker[ntotal].core = tx_core;
+		ntotal++;
+	}
+	if (ntotal > 0)
+		start_workers ();
+}
+
+PORT
+void GetChannelSchedStats (int channel, long* blocks, long* misses, double* max_late_us)
+{
+	EnterCriticalSection (&ch[channel].csDSP);
+	*blocks = sch[channel].blocks;
+	*misses = sch[channel].misses;
+	*max_late_us = 1.0e-3 * (double)sch[channel].max_late_ns;
+	LeaveCriticalSection (&ch[channel].csDSP);
+}
+
+PORT
+void ResetChannelSchedStats (int channel)
+{
+	EnterCriticalSection (&ch[channel].csDSP);
+	sch[channel].blocks = 0;
+	sch[channel].misses = 0;
+	sch[channel].max_late_ns = 0;
+	LeaveCriticalSection (&ch[channel].csDSP);
+}
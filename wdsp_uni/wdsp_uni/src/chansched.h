@@ -0,0 +1,78 @@
+/*  chansched.h
+
+This file is part of a program that implements a Software-Defined Radio.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+/********************************************************************************************************
+*																										*
+*										Channel Scheduler												*
+*																										*
+********************************************************************************************************/
+
+#ifndef _chansched_h
+#define _chansched_h
+#include "comm.h"
+
+#define MAX_SCHED_WORKERS	16
+#define SCHED_DUE_SIZE		64						// power of 2, well above the DSP_MULT blocks an input ring holds
+
+typedef struct _readyq
+{
+	CRITICAL_SECTION cs;
+	HANDLE Sem_Ready;								// count = channels on the queue
+	int chan[MAX_CHANNELS];							// a channel is on at most one queue, at most once
+	int head;
+	int count;
+} readyq;
+
+typedef struct _schedch
+{
+	volatile long attached;							// blocks are run by the workers instead of a thread of its own
+	volatile long pending;							// blocks released and not yet run
+	volatile long queued;							// on a ready queue or being run
+	readyq* q;										// queue that serves the channel
+	long long due[SCHED_DUE_SIZE];					// time each pending block should be done by
+	volatile int due_in;							// written by fexchange
+	volatile int due_out;							// written by the thread running the channel
+	long long last_due;
+	long blocks;									// blocks run
+	long misses;									// blocks done after their due time
+	long long max_late_ns;							// latest a block was done
+} schedch;
+
+extern void release_chansched (int channel, int n);
+
+extern int attach_chansched (int channel);
+
+extern int detach_chansched (int channel);
+
+extern int attached_chansched (int channel);
+
+extern void flush_chansched (int channel);
+
+extern void complete_chansched (int channel, int ran);
+
+// Properties
+
+extern __declspec (dllexport) void SetChannelScheduler (int workers, int first_core, int fifo_priority, int tx_core);
+
+extern __declspec (dllexport) void GetChannelSchedStats (int channel, long* blocks, long* misses, double* max_late_us);
+
+extern __declspec (dllexport) void ResetChannelSchedStats (int channel);
+
+#endif
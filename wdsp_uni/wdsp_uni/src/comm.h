@@ -45,6 +45,7 @@ warren@wpratt.com
 #include <process.h>
 #include <intrin.h>
 #include "fftw/fftw3.h"
+#define InterlockedLoadPointer(target) InterlockedCompareExchangePointer((PVOID volatile *)(target), NULL, NULL)
 #endif
 #include <math.h>
 #include <time.h>
@@ -62,6 +63,7 @@ warren@wpratt.com
 #include "cfcomp.h"
 #include "cfir.h"
 #include "channel.h"
+#include "chansched.h"
 #include "compress.h"
 #include "delay.h"
 #include "div.h"
@@ -89,14 +91,17 @@ warren@wpratt.com
 #include "nobII.h"
 #include "osctrl.h"
 #include "patchpanel.h"
+#include "pipeline.h"
 #include "resample.h"
 #include "rmatch.h"
 #include "RXA.h"
 #include "sender.h"
 #include "shift.h"
 #include "siphon.h"
+#include "simd.h"
 #include "slew.h"
 #include "snb.h"
+#include "stft.h"
 #include "TXA.h"
 #include "utilities.h"
 #include "varsamp.h"
@@ -213,42 +213,14 @@ void calc_emnr(EMNR a)
 		3.100, 3.380, 4.150, 4.350, 4.250, 3.900, 4.100, 4.700, 5.000 };
 	a->incr = a->fsize / a->ovrlp;
 	a->gain = a->ogain / a->fsize / (double)a->ovrlp;
-	if (a->fsize > a->bsize)
-		a->iasize = a->fsize;
-	else
-		a->iasize = a->bsize + a->fsize - a->incr;
-	a->iainidx = 0;
-	a->iaoutidx = 0;
-	if (a->fsize > a->bsize)
-	{
-		if (a->bsize > a->incr)  a->oasize = a->bsize;
-		else					 a->oasize = a->incr;
-		a->oainidx = (a->fsize - a->bsize - a->incr) % a->oasize;
-	}
-	else
-	{
-		a->oasize = a->bsize;
-		a->oainidx = a->fsize - a->incr;
-	}
-	a->init_oainidx = a->oainidx;
-	a->oaoutidx = 0;
 	a->msize = a->fsize / 2 + 1;
 	a->window = (double *)malloc0(a->fsize * sizeof(double));
-	a->inaccum = (double *)malloc0(a->iasize * sizeof(double));
-	a->forfftin = (double *)malloc0(a->fsize * sizeof(double));
-	a->forfftout = (double *)malloc0(a->msize * sizeof(complex));
-	a->mask = (double *)malloc0(a->msize * sizeof(double));
-	a->revfftin = (double *)malloc0(a->msize * sizeof(complex));
-	a->revfftout = (double *)malloc0(a->fsize * sizeof(double));
-	a->save = (double **)malloc0(a->ovrlp * sizeof(double *));
-	for (i = 0; i < a->ovrlp; i++)
-		a->save[i] = (double *)malloc0(a->fsize * sizeof(double));
-	a->outaccum = (double *)malloc0(a->oasize * sizeof(double));
-	a->nsamps = 0;
-	a->saveidx = 0;
-	a->Rfor = fftw_plan_dft_r2c_1d(a->fsize, a->forfftin, (fftw_complex *)a->forfftout, FFTW_ESTIMATE);
-	a->Rrev = fftw_plan_dft_c2r_1d(a->fsize, (fftw_complex *)a->revfftin, a->revfftout, FFTW_ESTIMATE);
+	a->stft = create_stft (a->bsize, a->fsize, a->ovrlp, calc_gain, a);
+	a->forfftout = a->stft->forfftout;
+	a->mask = a->stft->mask;
 	calc_window(a);
+	// the output gain is applied with the synthesis window
+	setWindow_stft (a->stft, a->window, 1.0, a->gain);
 
 	a->g.msize = a->msize;
 	a->g.mask = a->mask;
@@ -273,17 +245,9 @@ void calc_emnr(EMNR a)
 	}
 	a->g.gmax = 10000.0;
 	//
-	a->g.GG = (double *)malloc0(241 * 241 * sizeof(double));
-	a->g.GGS = (double *)malloc0(241 * 241 * sizeof(double));
-#if defined(linux) || defined(__APPLE__)
-        memcpy(a->g.GG, GG, 241 * 241 * sizeof(double));
-        memcpy(a->g.GGS, GGS, 241 * 241 * sizeof(double));
-#else
-	a->g.fileb = fopen("calculus", "rb");
-	fread(a->g.GG, sizeof(double), 241 * 241, a->g.fileb);
-	fread(a->g.GGS, sizeof(double), 241 * 241, a->g.fileb);
-	fclose(a->g.fileb);
-#endif
+	// read-only and shared by every instance
+	a->g.GG = GG;
+	a->g.GGS = GGS;
 	//
 
 	a->np.incr = a->incr;
@@ -443,25 +407,12 @@ void decalc_emnr(EMNR a)
 	_aligned_free(a->np.alphaOptHat);
 	_aligned_free(a->np.p);
 
-	_aligned_free(a->g.GGS);
-	_aligned_free(a->g.GG);
 	_aligned_free(a->g.prev_mask);
 	_aligned_free(a->g.prev_gamma);
 	_aligned_free(a->g.lambda_d);
 	_aligned_free(a->g.lambda_y);
 
-	fftw_destroy_plan(a->Rrev);
-	fftw_destroy_plan(a->Rfor);
-	_aligned_free(a->outaccum);
-	for (i = 0; i < a->ovrlp; i++)
-		_aligned_free(a->save[i]);
-	_aligned_free(a->save);
-	_aligned_free(a->revfftout);
-	_aligned_free(a->revfftin);
-	_aligned_free(a->mask);
-	_aligned_free(a->forfftout);
-	_aligned_free(a->forfftin);
-	_aligned_free(a->inaccum);
+	destroy_stft (a->stft);
 	_aligned_free(a->window);
 }
 
@@ -489,17 +440,7 @@ EMNR create_emnr (int run, int position, int size, double* in, double* out, int
 
 void flush_emnr (EMNR a)
 {
-	int i;
-	memset (a->inaccum, 0, a->iasize * sizeof (double));
-	for (i = 0; i < a->ovrlp; i++)
-		memset (a->save[i], 0, a->fsize * sizeof (double));
-	memset (a->outaccum, 0, a->oasize * sizeof (double));
-	a->nsamps   = 0;
-	a->iainidx  = 0;
-	a->iaoutidx = 0;
-	a->oainidx  = a->init_oainidx;
-	a->oaoutidx = 0;
-	a->saveidx  = 0;
+	flush_stft (a->stft);
 }
 
 void destroy_emnr (EMNR a)
@@ -680,54 +621,67 @@ void aepf(EMNR a)
 	memcpy (a->mask + n, a->ae.nmask, (a->ae.msize - 2 * n) * sizeof (double));
 }
 
-double getKey(double* type, double gamma, double xi)
+// GG and GGS are 241 x 241 tables over gamma and xi from 0.001 to 1000 in quarter dB steps, addressed
+// [xi][gamma]; a table position is 40 * log10 (x) + 120, clamped to 0 .. 240
+void keyPos (double pos, int* n1, int* n2, double* frac)
 {
-	int ngamma1, ngamma2, nxi1, nxi2;
-	double tg, tx, dg, dx;
-	const double dmin = 0.001;
-	const double dmax = 1000.0;
-	if (gamma <= dmin)
+	// written so that a NaN clamps low rather than indexing outside the table
+	if (!(pos > 0.0))
 	{
-		ngamma1 = ngamma2 = 0;
-		tg = 0.0;
+		*n1 = *n2 = 0;
+		*frac = 0.0;
 	}
-	else if (gamma >= dmax)
+	else if (pos >= 240.0)
 	{
-		ngamma1 = ngamma2 = 240;
-		tg = 60.0;
+		*n1 = *n2 = 240;
+		*frac = 0.0;
 	}
 	else
 	{
-		tg = 10.0 * log10(gamma / dmin);
-		ngamma1 = (int)(4.0 * tg);
-		ngamma2 = ngamma1 + 1;
-	}
-	if (xi <= dmin)
-	{
-		nxi1 = nxi2 = 0;
-		tx = 0.0;
-	}
-	else if (xi >= dmax)
-	{
-		nxi1 = nxi2 = 240;
-		tx = 60.0;
+		*n1 = (int)pos;
+		*n2 = *n1 + 1;
+		*frac = pos - *n1;
 	}
-	else
-	{
-		tx = 10.0 * log10(xi / dmin);
-		nxi1 = (int)(4.0 * tx);
-		nxi2 = nxi1 + 1;
+}
+
+double getKey (const float* type, int ng1, int ng2, double dg, double xpos)
+{
+	int nx1, nx2;
+	double dx;
+	keyPos (xpos, &nx1, &nx2, &dx);
+	return (1.0 - dg)  * (1.0 - dx) * type[CALCULUS_SIZE * nx1 + ng1]
+		+  (1.0 - dg)  *        dx  * type[CALCULUS_SIZE * nx2 + ng1]
+		+         dg   * (1.0 - dx) * type[CALCULUS_SIZE * nx1 + ng2]
+		+         dg   *        dx  * type[CALCULUS_SIZE * nx2 + ng2];
+}
+
+void calc_gain_tables (EMNR a)
+{
+	int k, ng1, ng2;
+	double gamma, dg, xpos;
+	// eps_p = eps_hat / (1 - q) is a fixed offset in table position
+	const double pshift = -40.0 * log10 (1.0 - a->g.q);
+	// elementwise pass, gamma is kept in prev_gamma and eps_hat in mask until the lookups replace it
+	for (k = 0; k < a->msize; k++)
+	{
+		gamma = min (a->g.lambda_y[k] / a->g.lambda_d[k], a->g.gamma_max);
+		a->g.mask[k] = a->g.alpha * a->g.prev_mask[k] * a->g.prev_mask[k] * a->g.prev_gamma[k]
+			+ (1.0 - a->g.alpha) * max (gamma - 1.0, a->g.eps_floor);
+		a->g.prev_gamma[k] = gamma;
+	}
+	// lookups, one logarithm each for gamma and eps_hat shared by both tables
+	for (k = 0; k < a->msize; k++)
+	{
+		keyPos (40.0 * log10 (a->g.prev_gamma[k]) + 120.0, &ng1, &ng2, &dg);
+		xpos = 40.0 * log10 (a->g.mask[k]) + 120.0;
+		a->g.mask[k] = getKey (a->g.GG, ng1, ng2, dg, xpos) * getKey (a->g.GGS, ng1, ng2, dg, xpos + pshift);
+		a->g.prev_mask[k] = a->g.mask[k];
 	}
-	dg = (tg - 0.25 * ngamma1) / 0.25;
-	dx = (tx - 0.25 * nxi1) / 0.25;
-	return (1.0 - dg)  * (1.0 - dx) * type[241 * nxi1 + ngamma1]
-		+  (1.0 - dg)  *        dx  * type[241 * nxi2 + ngamma1]
-		+         dg   * (1.0 - dx) * type[241 * nxi1 + ngamma2]
-		+         dg   *        dx  * type[241 * nxi2 + ngamma2];
 }
 
-void calc_gain (EMNR a)
+void calc_gain (void* arg)
 {
+	EMNR a = (EMNR)arg;
 	int k;
 	for (k = 0; k < a->g.msize; k++)
 	{
@@ -787,20 +741,8 @@ void calc_gain (EMNR a)
 			break;
 		}
 	case 2:
-		{
-			double gamma, eps_hat, eps_p;
-			for (k = 0; k < a->msize; k++)
-			{
-				gamma = min(a->g.lambda_y[k] / a->g.lambda_d[k], a->g.gamma_max);
-				eps_hat = a->g.alpha * a->g.prev_mask[k] * a->g.prev_mask[k] * a->g.prev_gamma[k]
-					+ (1.0 - a->g.alpha) * max(gamma - 1.0, a->g.eps_floor);
-				eps_p = eps_hat / (1.0 - a->g.q);
-				a->g.mask[k] = getKey(a->g.GG, gamma, eps_hat) * getKey(a->g.GGS, gamma, eps_p);
-				a->g.prev_gamma[k] = gamma;
-				a->g.prev_mask[k] = a->g.mask[k];
-			}
-			break;
-		}
+		calc_gain_tables (a);
+		break;
 	}
 	if (a->g.ae_run) aepf(a);
 }
@@ -808,54 +750,7 @@ void calc_gain (EMNR a)
 void xemnr (EMNR a, int pos)
 {
 	if (a->run && pos == a->position)
-	{
-		int i, j, k, sbuff, sbegin;
-		double g1;
-		for (i = 0; i < 2 * a->bsize; i += 2)
-		{
-			a->inaccum[a->iainidx] = a->in[i];
-			a->iainidx = (a->iainidx + 1) % a->iasize;
-		}
-		a->nsamps += a->bsize;
-		while (a->nsamps >= a->fsize)
-		{
-			for (i = 0, j = a->iaoutidx; i < a->fsize; i++, j = (j + 1) % a->iasize)
-				a->forfftin[i] = a->window[i] * a->inaccum[j];
-			a->iaoutidx = (a->iaoutidx + a->incr) % a->iasize;
-			a->nsamps -= a->incr;
-			fftw_execute (a->Rfor);
-			calc_gain(a);
-			for (i = 0; i < a->msize; i++)
-			{
-				g1 = a->gain * a->mask[i];
-				a->revfftin[2 * i + 0] = g1 * a->forfftout[2 * i + 0];
-				a->revfftin[2 * i + 1] = g1 * a->forfftout[2 * i + 1];
-			}
-			fftw_execute (a->Rrev);
-			for (i = 0; i < a->fsize; i++)
-				a->save[a->saveidx][i] = a->window[i] * a->revfftout[i];
-			for (i = a->ovrlp; i > 0; i--)
-			{
-				sbuff = (a->saveidx + i) % a->ovrlp;
-				sbegin = a->incr * (a->ovrlp - i);
-				for (j = sbegin, k = a->oainidx; j < a->incr + sbegin; j++, k = (k + 1) % a->oasize)
-				{
-					if ( i == a->ovrlp)
-						a->outaccum[k]  = a->save[sbuff][j];
-					else
-						a->outaccum[k] += a->save[sbuff][j];
-				}
-			}
-			a->saveidx = (a->saveidx + 1) % a->ovrlp;
-			a->oainidx = (a->oainidx + a->incr) % a->oasize;
-		}
-		for (i = 0; i < a->bsize; i++)
-		{
-			a->out[2 * i + 0] = a->outaccum[a->oaoutidx];
-			a->out[2 * i + 1] = 0.0;
-			a->oaoutidx = (a->oaoutidx + 1) % a->oasize;
-		}
-	}
+		xstft (a->stft, a->in, a->out);
 	else if (a->out != a->in)
 		memcpy (a->out, a->in, a->bsize * sizeof (complex));
 }
@@ -27,6 +27,8 @@ warren@wpratt.com
 #ifndef _emnr_h
 #define _emnr_h
 
+#include "stft.h"
+
 typedef struct _emnr
 {
 	int run;
@@ -38,30 +40,14 @@ typedef struct _emnr
 	int ovrlp;
 	int incr;
 	double* window;
-	int iasize;
-	double* inaccum;
-	double* forfftin;
-	double* forfftout;
+	STFT stft;
+	double* forfftout;			// spectrum of the current frame, owned by stft
 	int msize;
-	double* mask;
-	double* revfftin;
-	double* revfftout;
-	double** save;
-	int oasize;
-	double* outaccum;
+	double* mask;				// owned by stft
 	double rate;
 	int wintype;
 	double ogain;
 	double gain;
-	int nsamps;
-	int iainidx;
-	int iaoutidx;
-	int init_oainidx;
-	int oainidx;
-	int oaoutidx;
-	int saveidx;
-	fftw_plan Rfor;
-	fftw_plan Rrev;
 	struct _g
 	{
 		int gain_method;
@@ -81,9 +67,8 @@ typedef struct _emnr
 		double q;
 		double gmax;
 		//
-		double* GG;
-		double* GGS;
-		FILE* fileb;
+		const float* GG;
+		const float* GGS;
 	} g;
 	struct _npest
 	{
@@ -162,6 +147,8 @@ extern void destroy_emnr (EMNR a);
 
 extern void flush_emnr (EMNR a);
 
+extern void calc_gain (void* arg);
+
 extern void xemnr (EMNR a, int pos);
 
 extern void setBuffers_emnr (EMNR a, double* in, double* out);
@@ -170,4 +157,6 @@ extern void setSamplerate_emnr (EMNR a, int rate);
 
 extern void setSize_emnr (EMNR a, int size);
 
+extern __declspec (dllexport) void SetRXAEMNRRun (int channel, int run);
+
 #endif
@@ -295,35 +295,44 @@ void plan_fircore (FIRCORE a)
 	a->cset = 0;
 	a->buffidx = 0;
 	a->idxmask = a->nfor - 1;
+	a->tile = min (FIRCORE_TILE, 2 * a->size);
 	a->fftin = (double *) malloc0 (2 * a->size * sizeof (complex));
 	a->fftout   = (double **) malloc0 (a->nfor * sizeof (double *));
-	a->fmask    = (double ***) malloc0 (2 * sizeof (double **));
-	a->fmask[0] = (double **) malloc0 (a->nfor * sizeof (double *));
-	a->fmask[1] = (double **) malloc0 (a->nfor * sizeof (double *));
+	a->fmask    = (double **) malloc0 (2 * sizeof (double *));
+	a->fmask[0] = (double *) malloc0 (a->nfor * 2 * a->size * sizeof (complex));
+	a->fmask[1] = (double *) malloc0 (a->nfor * 2 * a->size * sizeof (complex));
 	a->maskgen = (double *) malloc0 (2 * a->size * sizeof (complex));
+	a->maskfft = (double *) malloc0 (2 * a->size * sizeof (complex));
 	a->pcfor = (fftw_plan *) malloc0 (a->nfor * sizeof (fftw_plan));
-	a->maskplan    = (fftw_plan **) malloc0 (2 * sizeof (fftw_plan *));
-	a->maskplan[0] = (fftw_plan *) malloc0 (a->nfor * sizeof (fftw_plan));
-	a->maskplan[1] = (fftw_plan *) malloc0 (a->nfor * sizeof (fftw_plan));
 	for (i = 0; i < a->nfor; i++)
 	{
 		a->fftout[i]   = (double *) malloc0 (2 * a->size * sizeof (complex));
-		a->fmask[0][i] = (double *) malloc0 (2 * a->size * sizeof (complex));
-		a->fmask[1][i] = (double *) malloc0 (2 * a->size * sizeof (complex));
 		a->pcfor[i] = fftw_plan_dft_1d(2 * a->size, (fftw_complex *)a->fftin, (fftw_complex *)a->fftout[i], FFTW_FORWARD, FFTW_PATIENT);
-		a->maskplan[0][i] = fftw_plan_dft_1d(2 * a->size, (fftw_complex *)a->maskgen, (fftw_complex *)a->fmask[0][i], FFTW_FORWARD, FFTW_PATIENT);
-		a->maskplan[1][i] = fftw_plan_dft_1d(2 * a->size, (fftw_complex *)a->maskgen, (fftw_complex *)a->fmask[1][i], FFTW_FORWARD, FFTW_PATIENT);
 	}
+	a->maskplan = fftw_plan_dft_1d(2 * a->size, (fftw_complex *)a->maskgen, (fftw_complex *)a->maskfft, FFTW_FORWARD, FFTW_PATIENT);
 	a->accum = (double *) malloc0 (2 * a->size * sizeof (complex));
 	a->crev = fftw_plan_dft_1d(2 * a->size, (fftw_complex *)a->accum, (fftw_complex *)a->out, FFTW_BACKWARD, FFTW_PATIENT);
+	a->live = a->fmask[0];
+	a->inuse = 0;
 	a->masks_ready = 0;
 }
 
+void publish_fircore (FIRCORE a)
+{
+	// call with 'update' held, makes the spare mask set live
+	void* old = InterlockedExchangePointer (&a->live, a->fmask[1 - a->cset]);
+	a->cset = 1 - a->cset;
+	// xfircore may still be on the old set; it becomes the spare, so wait until it is off it
+	while (InterlockedLoadPointer (&a->inuse) == old)
+		SwitchToThread ();
+}
+
 void calc_fircore (FIRCORE a, int flip)
 {
 	// call for change in frequency, rate, wintype, gain
 	// must also call after a call to plan_firopt()
-	int i;
+	int i, t;
+	double* mask = a->fmask[1 - a->cset];
 	if (a->mp)
 		mp_imp (a->nc, a->impulse, a->imp, 16, 0);
 	else
@@ -333,13 +342,16 @@ void calc_fircore (FIRCORE a, int flip)
 		// I right-justified the impulse response => take output from left side of output buff, discard right side
 		// Be careful about flipping an asymmetrical impulse response.
 		memcpy (&(a->maskgen[2 * a->size]), &(a->imp[2 * a->size * i]), a->size * sizeof(complex));
-		fftw_execute (a->maskplan[1 - a->cset][i]);
+		fftw_execute (a->maskplan);
+		// tile t of partition i goes to slot t * nfor + i so xfircore reads the masks in one stream
+		for (t = 0; t < 2 * a->size / a->tile; t++)
+			memcpy (&(mask[2 * a->tile * (t * a->nfor + i)]), &(a->maskfft[2 * a->tile * t]), a->tile * sizeof (complex));
 	}
 	a->masks_ready = 1;
 	if (flip)
 	{
 		EnterCriticalSection (&a->update);
-		a->cset = 1 - a->cset;
+		publish_fircore (a);
 		LeaveCriticalSection (&a->update);
 		a->masks_ready = 0;
 	}
@@ -370,16 +382,11 @@ void deplan_fircore (FIRCORE a)
 	for (i = 0; i < a->nfor; i++)
 	{
 		_aligned_free (a->fftout[i]);
-		_aligned_free (a->fmask[0][i]);
-		_aligned_free (a->fmask[1][i]);
 		fftw_destroy_plan (a->pcfor[i]);
-		fftw_destroy_plan (a->maskplan[0][i]);
-		fftw_destroy_plan (a->maskplan[1][i]);
 	}
-	_aligned_free (a->maskplan[0]);
-	_aligned_free (a->maskplan[1]);
-	_aligned_free (a->maskplan);
+	fftw_destroy_plan (a->maskplan);
 	_aligned_free (a->pcfor);
+	_aligned_free (a->maskfft);
 	_aligned_free (a->maskgen);
 	_aligned_free (a->fmask[0]);
 	_aligned_free (a->fmask[1]);
@@ -408,22 +415,29 @@ void flush_fircore (FIRCORE a)
 
 void xfircore (FIRCORE a)
 {
-	int i, j, k;
+	int j, k, t;
+	double* mask;
 	memcpy (&(a->fftin[2 * a->size]), a->in, a->size * sizeof (complex));
 	fftw_execute (a->pcfor[a->buffidx]);
-	k = a->buffidx;
 	memset (a->accum, 0, 2 * a->size * sizeof (complex));
-	EnterCriticalSection (&a->update);
-	for (j = 0; j < a->nfor; j++)
+	// claim the live mask set without blocking; a set published between the two reads is simply retried
+	do
 	{
-		for (i = 0; i < 2 * a->size; i++)
+		mask = (double *) InterlockedLoadPointer (&a->live);
+		(void) InterlockedExchangePointer (&a->inuse, mask);
+	} while (mask != InterlockedLoadPointer (&a->live));
+	// accumulate one tile over every partition before moving on so the tile stays in L1
+	for (t = 0; t < 2 * a->size; t += a->tile)
+	{
+		k = a->buffidx;
+		for (j = 0; j < a->nfor; j++)
 		{
-			a->accum[2 * i + 0] += a->fftout[k][2 * i + 0] * a->fmask[a->cset][j][2 * i + 0] - a->fftout[k][2 * i + 1] * a->fmask[a->cset][j][2 * i + 1];
-			a->accum[2 * i + 1] += a->fftout[k][2 * i + 0] * a->fmask[a->cset][j][2 * i + 1] + a->fftout[k][2 * i + 1] * a->fmask[a->cset][j][2 * i + 0];
+			cmac (&(a->accum[2 * t]), &(a->fftout[k][2 * t]), mask, a->tile);
+			mask += 2 * a->tile;
+			k = (k + a->idxmask) & a->idxmask;
 		}
-		k = (k + a->idxmask) & a->idxmask;
 	}
-	LeaveCriticalSection (&a->update);
+	(void) InterlockedExchangePointer (&a->inuse, 0);
 	a->buffidx = (a->buffidx + 1) & a->idxmask;
 	fftw_execute (a->crev);
 	memcpy (a->fftin, &(a->fftin[2 * a->size]), a->size * sizeof(complex));
@@ -477,7 +491,7 @@ void setUpdate_fircore (FIRCORE a)
 	if (a->masks_ready)
 	{
 		EnterCriticalSection (&a->update);
-		a->cset = 1 - a->cset;
+		publish_fircore (a);
 		LeaveCriticalSection (&a->update);
 		a->masks_ready = 0;
 	}
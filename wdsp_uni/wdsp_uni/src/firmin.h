@@ -135,6 +135,9 @@ extern void setFreqs_firopt (FIROPT a, double f_low, double f_high);
 #ifndef _fircore_h
 #define _fircore_h
 
+// complex bins accumulated over all partitions in one pass, the accumulator, delay line and mask tiles fit L1
+#define FIRCORE_TILE					256
+
 typedef struct _fircore
 {
 	int size;				// input/output buffer size, power of two
@@ -145,17 +148,21 @@ typedef struct _fircore
 	double* imp;
 	int nfor;				// number of buffers in delay line
 	double* fftin;			// fft input buffer
-	double*** fmask;		// frequency domain masks
+	double** fmask;			// frequency domain masks, one block per set, laid out tile by tile
 	double** fftout;		// fftout delay line
 	double* accum;			// frequency domain accumulator
 	int buffidx;			// fft out buffer index
 	int idxmask;			// mask for index computations
 	double* maskgen;		// input for mask generation FFT
+	double* maskfft;		// output of mask generation FFT
+	int tile;				// complex bins per accumulation pass
 	fftw_plan* pcfor;		// array of forward FFT plans
 	fftw_plan crev;			// reverse fft plan
-	fftw_plan** maskplan;	// plans for frequency domain masks
-	CRITICAL_SECTION update;
-	int cset;
+	fftw_plan maskplan;		// plan for frequency domain masks
+	CRITICAL_SECTION update;	// serialises mask updates, never taken by xfircore
+	int cset;				// mask set last published
+	void* volatile live;	// mask set xfircore reads
+	void* volatile inuse;	// mask set xfircore is reading, NULL between blocks
 	int mp;
 	int masks_ready;
 } fircore, *FIRCORE;
@@ -472,7 +472,7 @@ void fexchange0 (int channel, double* in, double* out, int* error)
 		if ((a->r1_unqueuedsamps += a->in_size) >= a->r1_outsize)
 		{
 			n = a->r1_unqueuedsamps / a->r1_outsize;
-			ReleaseSemaphore(a->Sem_BuffReady, n, 0);
+			release_chansched (channel, n);
 			a->r1_unqueuedsamps -= n * a->r1_outsize;
 		}
 		if ((a->r1_inidx += a->in_size) == a->r1_active_buffsize)
@@ -530,7 +530,7 @@ void fexchange2 (int channel, INREAL *Iin, INREAL *Qin, OUTREAL *Iout, OUTREAL *
 		if ((a->r1_unqueuedsamps += a->in_size) >= a->r1_outsize)
 		{
 			n = a->r1_unqueuedsamps / a->r1_outsize;
-			ReleaseSemaphore(a->Sem_BuffReady, n, 0);	
+			release_chansched (channel, n);
 			a->r1_unqueuedsamps -= n * a->r1_outsize;
 		}
 		if ((a->r1_inidx += a->in_size) == a->r1_active_buffsize)
@@ -576,7 +576,7 @@ void dexchange (int channel, double* in, double* out)
 {
 	int n;
 	IOB a = ch[channel].iob.pd;
-	if (!_InterlockedAnd (&ch[channel].run, 1)) _endthread();
+	if (!_InterlockedAnd (&ch[channel].run, 1) && !attached_chansched (channel)) _endthread();
 	EnterCriticalSection (&a->r2_ControlSection);
 	a->r2_havesamps += a->r2_insize;
 	LeaveCriticalSection (&a->r2_ControlSection);
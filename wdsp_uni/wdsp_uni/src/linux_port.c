@@ -25,8 +25,15 @@ john.d.melton@googlemail.com
 
 */
 
+#if defined(linux) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
 #include "linux_port.h"
 #include "comm.h"
+#include <time.h>
+#ifdef linux
+#include <sched.h>
+#endif
 
 /********************************************************************************************************
 *													*
@@ -36,10 +43,198 @@ john.d.melton@googlemail.com
 
 #if defined(linux) || defined(__APPLE__)
 
-void QueueUserWorkItem(void *function,void *context,int flags) {
+/********************************************************************************************************
+*													*
+*	Work Pool											*
+*													*
+*	QueueUserWorkItem hands the item to a fixed pool of worker threads, one pinned to each CPU		*
+*	other than core 0 up to WORK_POOL_MAX_THREADS, created on first use. Items go through a			*
+*	bounded lock-free queue (sequence numbered cells, any number of producers and consumers) and	*
+*	a semaphore counts the items so idle workers sleep. If the queue is ever full the item is run	*
+*	by the caller.																					*
+*													*
+********************************************************************************************************/
+
+#define WORK_POOL_MAX_THREADS	8
+#define WORK_QUEUE_SIZE			1024		// power of 2
+#define WORK_QUEUE_MASK			(WORK_QUEUE_SIZE - 1)
+
+typedef DWORD (*WORK_FUNCTION)(void *);
+
+typedef struct _work_item
+{
+	long seq;
+	WORK_FUNCTION function;
+	void *context;
+	long long queued_ns;
+} WORK_ITEM;
+
+static WORK_ITEM work_queue[WORK_QUEUE_SIZE];
+static long work_enq_pos;
+static long work_deq_pos;
+static sem_t *work_sem;
+static int work_pool_threads;
+static pthread_once_t work_pool_once = PTHREAD_ONCE_INIT;
+static WORK_POOL_STATS work_stats;
+
+static long long work_now_ns() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int work_push(WORK_FUNCTION function, void *context) {
+	WORK_ITEM *cell;
+	long pos = __atomic_load_n(&work_enq_pos, __ATOMIC_RELAXED);
+	long dif;
+	for (;;) {
+		cell = &work_queue[pos & WORK_QUEUE_MASK];
+		dif = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) - pos;
+		if (dif == 0) {
+			// cell is free, claim it
+			if (__atomic_compare_exchange_n(&work_enq_pos, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+				break;
+		} else if (dif < 0) {
+			// full
+			return FALSE;
+		} else {
+			pos = __atomic_load_n(&work_enq_pos, __ATOMIC_RELAXED);
+		}
+	}
+	cell->function = function;
+	cell->context = context;
+	cell->queued_ns = work_now_ns();
+	__atomic_store_n(&cell->seq, pos + 1, __ATOMIC_RELEASE);
+	return TRUE;
+}
+
+static int work_pop(WORK_ITEM *item) {
+	WORK_ITEM *cell;
+	long pos = __atomic_load_n(&work_deq_pos, __ATOMIC_RELAXED);
+	long dif;
+	for (;;) {
+		cell = &work_queue[pos & WORK_QUEUE_MASK];
+		dif = __atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) - (pos + 1);
+		if (dif == 0) {
+			// cell is published, claim it
+			if (__atomic_compare_exchange_n(&work_deq_pos, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+				break;
+		} else if (dif < 0) {
+			// empty
+			return FALSE;
+		} else {
+			pos = __atomic_load_n(&work_deq_pos, __ATOMIC_RELAXED);
+		}
+	}
+	*item = *cell;
+	// free the cell for the producer one lap on
+	__atomic_store_n(&cell->seq, pos + WORK_QUEUE_SIZE, __ATOMIC_RELEASE);
+	return TRUE;
+}
+
+static void *work_pool_worker(void *arg) {
+	WORK_ITEM item;
+	long long latency;
+	long long max;
+	(void)arg;
+	SetThreadFlushDenormals(GetFlushDenormals());
+	for (;;) {
+		// a signal can interrupt the wait before an item is counted off, wait again
+		if (sem_wait(work_sem) != 0)
+			continue;
+		// the semaphore counts items so there is always one to take, retry if a race loses it
+		while (!work_pop(&item))
+			sched_yield();
+		__atomic_sub_fetch(&work_stats.depth, 1, __ATOMIC_RELAXED);
+		latency = work_now_ns() - item.queued_ns;
+		__atomic_add_fetch(&work_stats.latency_ns_sum, latency, __ATOMIC_RELAXED);
+		max = __atomic_load_n(&work_stats.max_latency_ns, __ATOMIC_RELAXED);
+		while (latency > max && !__atomic_compare_exchange_n(&work_stats.max_latency_ns, &max, latency, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+		item.function(item.context);
+		__atomic_add_fetch(&work_stats.completed, 1, __ATOMIC_RELAXED);
+	}
+	return NULL;
+}
+
+static void work_pool_create() {
+	int i;
+	long ncpu;
 	pthread_t t;
-	pthread_create(&t, NULL, function, context);
-	pthread_join(t, NULL);
+	pthread_attr_t attr;
+#ifdef linux
+	cpu_set_t cpus;
+#endif
+	for (i = 0; i < WORK_QUEUE_SIZE; i++)
+		work_queue[i].seq = i;
+	work_sem = LinuxCreateSemaphore(0, 0, 0, 0);
+	ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+	if (ncpu < 1) ncpu = 1;
+	// leave core 0 to the radio i/o, a single core machine has to share it
+	work_pool_threads = ncpu > 1 ? min(ncpu - 1, WORK_POOL_MAX_THREADS) : 1;
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	for (i = 0; i < work_pool_threads; i++) {
+		if (pthread_create(&t, &attr, work_pool_worker, NULL) != 0)
+			break;
+#ifdef linux
+		pthread_setname_np(t, "WDSP pool");
+		// pin to a core, spread down from the top
+		CPU_ZERO(&cpus);
+		CPU_SET((int)(ncpu - 1 - i), &cpus);
+		pthread_setaffinity_np(t, sizeof(cpu_set_t), &cpus);
+#endif
+	}
+	work_pool_threads = i;
+	pthread_attr_destroy(&attr);
+}
+
+void QueueUserWorkItem(void *function,void *context,int flags) {
+	long depth;
+	long max;
+	pthread_once(&work_pool_once, work_pool_create);
+	__atomic_add_fetch(&work_stats.queued, 1, __ATOMIC_RELAXED);
+	if (work_pool_threads == 0 || !work_push((WORK_FUNCTION)function, context)) {
+		// no pool or queue full, run it here
+		__atomic_add_fetch(&work_stats.inline_runs, 1, __ATOMIC_RELAXED);
+		((WORK_FUNCTION)function)(context);
+		__atomic_add_fetch(&work_stats.completed, 1, __ATOMIC_RELAXED);
+		return;
+	}
+	depth = __atomic_add_fetch(&work_stats.depth, 1, __ATOMIC_RELAXED);
+	max = __atomic_load_n(&work_stats.max_depth, __ATOMIC_RELAXED);
+	while (depth > max && !__atomic_compare_exchange_n(&work_stats.max_depth, &max, depth, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+	sem_post(work_sem);
+}
+
+void GetWorkPoolStats(WORK_POOL_STATS *stats) {
+	stats->threads = work_pool_threads;
+	stats->queued = __atomic_load_n(&work_stats.queued, __ATOMIC_RELAXED);
+	stats->completed = __atomic_load_n(&work_stats.completed, __ATOMIC_RELAXED);
+	stats->inline_runs = __atomic_load_n(&work_stats.inline_runs, __ATOMIC_RELAXED);
+	stats->depth = __atomic_load_n(&work_stats.depth, __ATOMIC_RELAXED);
+	stats->max_depth = __atomic_load_n(&work_stats.max_depth, __ATOMIC_RELAXED);
+	stats->latency_ns_sum = __atomic_load_n(&work_stats.latency_ns_sum, __ATOMIC_RELAXED);
+	stats->max_latency_ns = __atomic_load_n(&work_stats.max_latency_ns, __ATOMIC_RELAXED);
+}
+
+void ResetWorkPoolStats() {
+	// depth is live so it is kept
+	__atomic_store_n(&work_stats.queued, 0, __ATOMIC_RELAXED);
+	__atomic_store_n(&work_stats.completed, 0, __ATOMIC_RELAXED);
+	__atomic_store_n(&work_stats.inline_runs, 0, __ATOMIC_RELAXED);
+	__atomic_store_n(&work_stats.max_depth, 0, __ATOMIC_RELAXED);
+	__atomic_store_n(&work_stats.latency_ns_sum, 0, __ATOMIC_RELAXED);
+	__atomic_store_n(&work_stats.max_latency_ns, 0, __ATOMIC_RELAXED);
+}
+
+void *LinuxAlignedMalloc(size_t size,size_t alignment) {
+	void *p;
+	// posix_memalign needs a power of 2 multiple of the pointer size, the memory is released with free()
+	if (alignment < sizeof(void *))
+		alignment = sizeof(void *);
+	if (posix_memalign(&p, alignment, size) != 0)
+		return NULL;
+	return p;
 }
 
 void InitializeCriticalSectionAndSpinCount(pthread_mutex_t *mutex,int count) {
@@ -177,6 +372,43 @@ void SetThreadPriority(HANDLE thread, int priority)  {
 */
 }
 
+DWORD_PTR SetThreadAffinityMask(HANDLE thread, DWORD_PTR mask) {
+#ifdef linux
+	int i;
+	DWORD_PTR old = 0;
+	cpu_set_t cpus;
+	if (pthread_getaffinity_np((pthread_t)thread, sizeof(cpu_set_t), &cpus) != 0)
+		return 0;
+	for (i = 0; i < (int)(8 * sizeof(DWORD_PTR)); i++)
+		if (CPU_ISSET(i, &cpus))
+			old |= (DWORD_PTR)1 << i;
+	CPU_ZERO(&cpus);
+	for (i = 0; i < (int)(8 * sizeof(DWORD_PTR)); i++)
+		if (mask & ((DWORD_PTR)1 << i))
+			CPU_SET(i, &cpus);
+	if (pthread_setaffinity_np((pthread_t)thread, sizeof(cpu_set_t), &cpus) != 0)
+		return 0;
+	return old;
+#else
+	return 0;
+#endif
+}
+
+int SetThreadFifoPriority(HANDLE thread, int priority) {
+	struct sched_param param;
+	int policy = priority > 0 ? SCHED_FIFO : SCHED_OTHER;
+	if (priority > 0) {
+		priority = max(priority, sched_get_priority_min(SCHED_FIFO));
+		priority = min(priority, sched_get_priority_max(SCHED_FIFO));
+	}
+	param.sched_priority = priority > 0 ? priority : 0;
+	if (pthread_setschedparam((pthread_t)thread, policy, &param) != 0) {
+		fprintf(stderr, "WDSP: could not set SCHED_FIFO priority %d, running at normal priority\n", priority);
+		return FALSE;
+	}
+	return TRUE;
+}
+
 int CloseHandle(HANDLE hObject) {
 }
 
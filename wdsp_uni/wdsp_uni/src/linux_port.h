@@ -25,6 +25,9 @@ john.d.melton@googlemail.com
 
 */
 
+#ifndef _linux_port_h
+#define _linux_port_h
+
 #if defined(linux) || defined(__APPLE__)
 
 
@@ -37,6 +40,7 @@ john.d.melton@googlemail.com
 #define CRITICAL_SECTION pthread_mutex_t
 #define LONG long
 #define DWORD long
+#define DWORD_PTR unsigned long
 #define HANDLE void *
 #define WINAPI
 #define FALSE 0
@@ -52,20 +56,27 @@ john.d.melton@googlemail.com
 #define InterlockedBitTestAndReset(base,bit) __sync_fetch_and_and(base,~(1L<<bit))
 
 #define InterlockedExchange(target,value) __sync_lock_test_and_set(target,value)
+#define InterlockedExchangeAdd(base,value) __sync_fetch_and_add(base,value)
+// full barrier like the Windows call
+#define InterlockedExchangePointer(target,value) __atomic_exchange_n(target,value,__ATOMIC_SEQ_CST)
+// ordered with the Interlocked calls, see comm.h for Windows
+#define InterlockedLoadPointer(target) __atomic_load_n(target,__ATOMIC_SEQ_CST)
 #define InterlockedAnd(base,mask) __sync_fetch_and_and(base,mask)
 #define _InterlockedAnd(base,mask) __sync_fetch_and_and(base,mask)
+#define MemoryBarrier() __sync_synchronize()
 #define __declspec(x)
 #define __cdecl
 #define __forceinline
 #define _int64 long long
-#define _aligned_malloc(x,y) malloc(x);
-#define _aligned_free(x) free(x);
+#define _aligned_malloc(x,y) LinuxAlignedMalloc(x,y)
+#define _aligned_free(x) free(x)
 #define freopen_s freopen
 #define min(x,y) (x<y?x:y)
 #define max(x,y) (x<y?y:x)
 #define THREAD_PRIORITY_HIGHEST 0
 
 #define Sleep(ms) usleep(ms*1000)
+#define SwitchToThread() sched_yield()
 
 #define CreateSemaphore(a,b,c,d) LinuxCreateSemaphore(a,b,c,d)
 #define WaitForSingleObject(x, y) LinuxWaitForSingleObject(x, y)
@@ -74,8 +85,27 @@ john.d.melton@googlemail.com
 
 #define INFINITE -1
 
+void *LinuxAlignedMalloc(size_t size,size_t alignment);
+
 void QueueUserWorkItem(void *function,void *context,int flags);
 
+// work pool counters, latency is from queueing to a worker starting the item
+typedef struct _work_pool_stats
+{
+	int threads;					// pool workers
+	long queued;					// items queued
+	long completed;					// items run to completion
+	long inline_runs;				// items run by the caller as the queue was full
+	long depth;						// items waiting now
+	long max_depth;					// most items waiting
+	long long latency_ns_sum;		// total queue latency, divide by queued - inline_runs - depth for the mean
+	long long max_latency_ns;		// worst queue latency
+} WORK_POOL_STATS;
+
+void GetWorkPoolStats(WORK_POOL_STATS *stats);
+
+void ResetWorkPoolStats();
+
 void InitializeCriticalSectionAndSpinCount(pthread_mutex_t *mutex,int count);
 
 void EnterCriticalSection(pthread_mutex_t *mutex);
@@ -101,7 +131,16 @@ void _endthread();
 
 void SetThreadPriority(HANDLE thread, int priority);
 
+#define GetCurrentThread() ((HANDLE)pthread_self())
+
+// pins the thread to the cores set in mask, returns the previous mask or 0 on failure
+DWORD_PTR SetThreadAffinityMask(HANDLE thread, DWORD_PTR mask);
+
+// priority 1 to 99 runs the thread SCHED_FIFO, 0 puts it back to SCHED_OTHER, returns FALSE on failure
+int SetThreadFifoPriority(HANDLE thread, int priority);
+
 int CloseHandle(HANDLE hObject);
 
 #endif
 
+#endif
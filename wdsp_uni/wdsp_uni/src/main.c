@@ -35,34 +35,44 @@ warren@wpratt.com
 void wdsp_main(void *pargs)
 {
 	int channel = (int)pargs;
+	int flush = GetFlushDenormals ();
+	SetThreadFlushDenormals (flush);
 	while (_InterlockedAnd (&ch[channel].run, 1))
 	{
 		WaitForSingleObject(ch[channel].iob.pd->Sem_BuffReady,INFINITE);
+		if (GetFlushDenormals () != flush)
+			SetThreadFlushDenormals (flush = GetFlushDenormals ());
 		EnterCriticalSection (&ch[channel].csDSP);
-		if (!_InterlockedAnd (&ch[channel].iob.pd->exec_bypass, 1))
-		{
-			switch (ch[channel].type)
-			{
-			case 0:		// rxa
-				dexchange (channel, rxa[channel].outbuff, rxa[channel].inbuff);
-				xrxa (channel);
-				break;
-			case 1:		// txa
-				dexchange (channel, txa[channel].outbuff, txa[channel].inbuff);
-				xtxa (channel);
-				break;
-			case 31:	//
-
-				break;
-			}
-		}
-		else {
-		}
+		xmain (channel);
 		LeaveCriticalSection (&ch[channel].csDSP);
 	}
 	_endthread();
 }
 
+void xmain (int channel)
+{
+	// runs one block of the channel, the caller holds csDSP
+	int ran = !_InterlockedAnd (&ch[channel].iob.pd->exec_bypass, 1);
+	if (ran)
+	{
+		switch (ch[channel].type)
+		{
+		case 0:		// rxa
+			dexchange (channel, rxa[channel].outbuff, rxa[channel].inbuff);
+			xrxa (channel);
+			break;
+		case 1:		// txa
+			dexchange (channel, txa[channel].outbuff, txa[channel].inbuff);
+			xtxa (channel);
+			break;
+		case 31:	//
+
+			break;
+		}
+	}
+	complete_chansched (channel, ran);
+}
+
 void create_main (int channel)
 {
 	switch (ch[channel].type)
@@ -35,6 +35,8 @@ warren@wpratt.com
 // *BC*
 extern void wdsp_main(void *pargs);
 
+extern void xmain (int channel);
+
 extern void create_main (int channel);
 
 extern void destroy_main (int channel);
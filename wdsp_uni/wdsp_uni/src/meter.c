@@ -28,12 +28,25 @@ warren@wpratt.com
 
 void calc_meter (METER a)
 {
+	int i;
 	a->mult_average = exp(-1.0 / (a->rate * a->tau_average));
 	a->mult_peak = exp(-1.0 / (a->rate * a->tau_peak_decay));
+	// a block of the per sample recurrence avg = avg * mult + (1 - mult) * smag in closed form
+	a->wavg = (double *)malloc0 (a->size * sizeof (double));
+	a->wavg[a->size - 1] = 1.0 - a->mult_average;
+	for (i = a->size - 2; i >= 0; i--)
+		a->wavg[i] = a->wavg[i + 1] * a->mult_average;
+	a->blk_average = pow (a->mult_average, a->size);
+	a->blk_peak = pow (a->mult_peak, a->size);
 	flush_meter(a);
 }
 
-METER create_meter (int run, int* prun, int size, double* buff, int rate, double tau_av, double tau_decay, double* result, CRITICAL_SECTION** pmtupdate, int enum_av, int enum_pk, int enum_gain, double* pgain)
+void decalc_meter (METER a)
+{
+	_aligned_free (a->wavg);
+}
+
+METER create_meter (int run, int* prun, int size, double* buff, int rate, double tau_av, double tau_decay, double* result, volatile long** pmtseq, int enum_av, int enum_pk, int enum_gain, double* pgain)
 {
 	METER a = (METER) malloc0 (sizeof (meter));
 	a->run = run;
@@ -48,17 +61,17 @@ METER create_meter (int run, int* prun, int size, double* buff, int rate, double
 	a->enum_pk = enum_pk;
 	a->enum_gain = enum_gain;
 	a->pgain = pgain;
+	a->seq = 0;
 	calc_meter(a);
-	InitializeCriticalSectionAndSpinCount (&a->mtupdate, 2500);
-	pmtupdate[enum_av]   = &a->mtupdate;
-	pmtupdate[enum_pk]   = &a->mtupdate;
-	pmtupdate[enum_gain] = &a->mtupdate;
+	if (enum_av   >= 0) pmtseq[enum_av]   = &a->seq;
+	if (enum_pk   >= 0) pmtseq[enum_pk]   = &a->seq;
+	if (enum_gain >= 0) pmtseq[enum_gain] = &a->seq;
 	return a;
 }
 
 void destroy_meter (METER a)
 {
-	DeleteCriticalSection (&a->mtupdate);
+	decalc_meter (a);
 	_aligned_free (a);
 }
 
@@ -66,45 +79,44 @@ void flush_meter (METER a)
 {
 	a->avg  = 0.0;
 	a->peak = 0.0;
+	InterlockedIncrement (&a->seq);
 	a->result[a->enum_av] = -400.0;
 	a->result[a->enum_pk] = -400.0;
 	if ((a->pgain != 0) && (a->enum_gain >= 0))
 		a->result[a->enum_gain] = -400.0;
+	InterlockedIncrement (&a->seq);
 }
 
 void xmeter (METER a)
 {
 	int srun;
-	EnterCriticalSection (&a->mtupdate);
 	if (a->prun != 0)
 		srun = *(a->prun);
 	else
 		srun = 1;
 	if (a->run && srun)
 	{
-		int i;
-		double smag;
-		double np = 0.0;
-		for (i = 0; i < a->size; i++)
-		{
-			smag = a->buff[2 * i + 0] * a->buff[2 * i + 0] + a->buff[2 * i + 1] * a->buff[2 * i + 1];
-			a->avg = a->avg * a->mult_average + (1.0 - a->mult_average) * smag;
-			a->peak *= a->mult_peak;
-			if (smag > np) np = smag;
-		}
-		if (np > a->peak) a->peak = np;
+		double pwr[2];
+		cpwr (pwr, a->buff, a->wavg, a->size);
+		a->avg = a->avg * a->blk_average + pwr[0];
+		a->peak *= a->blk_peak;
+		if (pwr[1] > a->peak) a->peak = pwr[1];
+		// results are only written inside the odd count, readers retry around it instead of locking
+		InterlockedIncrement (&a->seq);
 		a->result[a->enum_av] = 10.0 * mlog10 (a->avg + 1.0e-40);
 		a->result[a->enum_pk] = 10.0 * mlog10 (a->peak + 1.0e-40);
 		if ((a->pgain != 0) && (a->enum_gain >= 0))
 			a->result[a->enum_gain] = 20.0 * mlog10 (*a->pgain + 1.0e-40);
+		InterlockedIncrement (&a->seq);
 	}
 	else
 	{
+		InterlockedIncrement (&a->seq);
 		if (a->enum_av   >= 0) a->result[a->enum_av]   = - 400.0;
 		if (a->enum_pk   >= 0) a->result[a->enum_pk]   = - 400.0;
 		if (a->enum_gain >= 0) a->result[a->enum_gain] = +   0.0;
+		InterlockedIncrement (&a->seq);
 	}
-	LeaveCriticalSection (&a->mtupdate);
 }
 
 void setBuffers_meter (METER a, double* in)
@@ -114,14 +126,31 @@ void setBuffers_meter (METER a, double* in)
 
 void setSamplerate_meter (METER a, int rate)
 {
+	decalc_meter (a);
 	a->rate = rate;
 	calc_meter(a);
 }
 
 void setSize_meter (METER a, int size)
 {
+	decalc_meter (a);
 	a->size = size;
-	flush_meter (a);
+	calc_meter (a);
+}
+
+double read_meter (volatile long* seq, double* result)
+{
+	long s;
+	double val;
+	do
+	{
+		while ((s = *seq) & 1)
+			Sleep (0);
+		MemoryBarrier ();
+		val = *result;
+		MemoryBarrier ();
+	} while (*seq != s);
+	return val;
 }
 
 /********************************************************************************************************
@@ -133,12 +162,7 @@ void setSize_meter (METER a, int size)
 PORT
 double GetRXAMeter (int channel, int mt)
 {
-	double val;
-	CRITICAL_SECTION* a = rxa[channel].pmtupdate[mt];
-	EnterCriticalSection (a);
-	val = rxa[channel].meter[mt];
-	LeaveCriticalSection (a);
-	return val;
+	return read_meter (rxa[channel].pmtseq[mt], &rxa[channel].meter[mt]);
 }
 
 /********************************************************************************************************
@@ -150,10 +174,5 @@ double GetRXAMeter (int channel, int mt)
 PORT
 double GetTXAMeter (int channel, int mt)
 {
-	double val;
-	CRITICAL_SECTION* a = txa[channel].pmtupdate[mt];
-	EnterCriticalSection (a);
-	val = txa[channel].meter[mt];
-	LeaveCriticalSection (a);
-	return val;
+	return read_meter (txa[channel].pmtseq[mt], &txa[channel].meter[mt]);
 }
\ No newline at end of file
@@ -38,6 +38,9 @@ typedef struct _meter
 	double tau_peak_decay;
 	double mult_average;
 	double mult_peak;
+	double* wavg;					// per sample weights of one block in the average
+	double blk_average;				// mult_average to the power of size
+	double blk_peak;				// mult_peak to the power of size
 	double* result;
 	int enum_av;
 	int enum_pk;
@@ -45,10 +48,10 @@ typedef struct _meter
 	double* pgain;
 	double avg;
 	double peak;
-	CRITICAL_SECTION mtupdate;
+	volatile long seq;				// odd while results are being written
 } meter, *METER;
 
-extern METER create_meter (int run, int* prun, int size, double* buff, int rate, double tau_av, double tau_decay, double* result, CRITICAL_SECTION** pmtupdate, int enum_av, int enum_pk, int enum_gain, double* pgain);
+extern METER create_meter (int run, int* prun, int size, double* buff, int rate, double tau_av, double tau_decay, double* result, volatile long** pmtseq, int enum_av, int enum_pk, int enum_gain, double* pgain);
 
 extern void destroy_meter (METER a);
 
@@ -0,0 +1,251 @@
+/*  pipeline.c
+
+This file is part of a program that implements a Software-Defined Radio.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+// A chain is a fixed sequence of stage groups that each work in place on one buffer.  With more than one
+// segment, each step runs segment 0 on the calling thread and segments 1.. on their own workers, every
+// segment on a different block: segment s handles the block that entered the chain s steps earlier.
+// A block moves on at the end of a step through a pair of slots per boundary, one being filled while
+// the other is emptied, so no locks are taken inside a step.  xpipeline() returns only when every segment
+// has finished, so whoever holds the channel's csDSP still sees the whole chain at rest.
+
+#include "comm.h"
+
+static long long pipe_now_ns (void)
+{
+#ifdef _WINDOWS_
+	LARGE_INTEGER c, f;
+	QueryPerformanceCounter (&c);
+	QueryPerformanceFrequency (&f);
+	return (long long)((double)c.QuadPart * 1.0e9 / (double)f.QuadPart);
+#else
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+#endif
+}
+
+static void xsegment (PIPELINE a, int seg)
+{
+	int g;
+	int par = (int)(a->step & 1);
+	long long t0;
+	pipeseg* w = &a->worker[seg];
+	if (a->step < seg)
+		return;
+	t0 = pipe_now_ns ();
+	if (seg > 0)
+		memcpy (a->buff[seg], a->slot[seg][par ^ 1], a->size * sizeof (complex));
+	for (g = a->first[seg]; g < a->first[seg + 1]; g++)
+		(*a->xgroup) (a->channel, g);
+	if (seg < a->nsegs - 1)
+		memcpy (a->slot[seg + 1][par], a->buff[seg], a->size * sizeof (complex));
+	t0 = pipe_now_ns () - t0;
+	w->ns += t0;
+	if (t0 > w->max_ns)
+		w->max_ns = t0;
+}
+
+void pipeline_worker (void* arg)
+{
+	pipeseg* w = (pipeseg *)arg;
+	PIPELINE a = w->p;
+	int flush = GetFlushDenormals ();
+	SetThreadFlushDenormals (flush);
+	SetThreadPriority (GetCurrentThread (), THREAD_PRIORITY_HIGHEST);
+	if (a->core[w->seg] >= 0)
+		SetThreadAffinityMask (GetCurrentThread (), (DWORD_PTR)1 << a->core[w->seg]);
+	while (1)
+	{
+		WaitForSingleObject (w->Sem_Go, INFINITE);
+		if (!_InterlockedAnd (&a->run, 1))
+			break;
+		if (GetFlushDenormals () != flush)
+			SetThreadFlushDenormals (flush = GetFlushDenormals ());
+		xsegment (a, w->seg);
+		ReleaseSemaphore (a->Sem_Done, 1, 0);
+	}
+	ReleaseSemaphore (a->Sem_Done, 1, 0);
+	_endthread ();
+}
+
+static void start_workers (PIPELINE a)
+{
+	int s;
+	InterlockedBitTestAndSet (&a->run, 0);
+	for (s = 1; s < a->nsegs; s++)
+	{
+		a->worker[s].p = a;
+		a->worker[s].seg = s;
+		a->worker[s].Sem_Go = CreateSemaphore (0, 0, 1, 0);
+		wdsp_beginthread (pipeline_worker, 0, (void *)&a->worker[s]);
+	}
+}
+
+static void stop_workers (PIPELINE a)
+{
+	int s;
+	InterlockedBitTestAndReset (&a->run, 0);
+	for (s = 1; s < a->nsegs; s++)
+		ReleaseSemaphore (a->worker[s].Sem_Go, 1, 0);
+	for (s = 1; s < a->nsegs; s++)
+		WaitForSingleObject (a->Sem_Done, INFINITE);
+	for (s = 1; s < a->nsegs; s++)
+		CloseHandle (a->worker[s].Sem_Go);
+}
+
+static void calc_pipeline (PIPELINE a)
+{
+	int s;
+	a->buff[0] = a->mbuff;
+	for (s = 1; s < a->nsegs; s++)
+	{
+		// sized as the chain's own buffer
+		a->buff[s] = (double *) malloc0 (2 * a->size * sizeof (complex));
+		a->slot[s][0] = (double *) malloc0 (a->size * sizeof (complex));
+		a->slot[s][1] = (double *) malloc0 (a->size * sizeof (complex));
+	}
+	flush_pipeline (a);
+}
+
+static void decalc_pipeline (PIPELINE a)
+{
+	int s;
+	for (s = 1; s < a->nsegs; s++)
+	{
+		_aligned_free (a->slot[s][1]);
+		_aligned_free (a->slot[s][0]);
+		_aligned_free (a->buff[s]);
+	}
+}
+
+PIPELINE create_pipeline (int channel, int ngroups, void (*xgroup) (int channel, int group), int size, double* mbuff)
+{
+	PIPELINE a = (PIPELINE) malloc0 (sizeof (pipeline));
+	a->channel = channel;
+	a->ngroups = ngroups;
+	a->xgroup = xgroup;
+	a->size = size;
+	a->mbuff = mbuff;
+	a->nsegs = 1;
+	a->first[0] = 0;
+	a->first[1] = ngroups;
+	a->core[0] = -1;
+	a->Sem_Done = CreateSemaphore (0, 0, MAX_PIPE_SEGS, 0);
+	calc_pipeline (a);
+	return a;
+}
+
+void destroy_pipeline (PIPELINE a)
+{
+	if (a->nsegs > 1)
+		stop_workers (a);
+	decalc_pipeline (a);
+	CloseHandle (a->Sem_Done);
+	_aligned_free (a);
+}
+
+void flush_pipeline (PIPELINE a)
+{
+	int s;
+	for (s = 1; s < a->nsegs; s++)
+	{
+		memset (a->buff[s], 0, 2 * a->size * sizeof (complex));
+		memset (a->slot[s][0], 0, a->size * sizeof (complex));
+		memset (a->slot[s][1], 0, a->size * sizeof (complex));
+	}
+	for (s = 0; s < MAX_PIPE_SEGS; s++)
+	{
+		a->worker[s].ns = 0;
+		a->worker[s].max_ns = 0;
+	}
+	a->step = 0;
+}
+
+void xpipeline (PIPELINE a)
+{
+	int s;
+	if (a->nsegs == 1)
+	{
+		xsegment (a, 0);
+		a->step++;
+		return;
+	}
+	for (s = 1; s < a->nsegs; s++)
+		ReleaseSemaphore (a->worker[s].Sem_Go, 1, 0);
+	xsegment (a, 0);
+	for (s = 1; s < a->nsegs; s++)
+		WaitForSingleObject (a->Sem_Done, INFINITE);
+	a->step++;
+}
+
+void setBuffers_pipeline (PIPELINE a, double* mbuff)
+{
+	a->mbuff = mbuff;
+	a->buff[0] = mbuff;
+}
+
+void setSize_pipeline (PIPELINE a, int size)
+{
+	// the workers only touch the buffers inside a step
+	decalc_pipeline (a);
+	a->size = size;
+	calc_pipeline (a);
+}
+
+void setSegments_pipeline (PIPELINE a, int nsegs, const int* first, int first_core)
+{
+	// first[] holds nsegs + 1 entries, 0 up to ngroups; the caller keeps the chain at rest
+	int s;
+	if (a->nsegs > 1)
+		stop_workers (a);
+	decalc_pipeline (a);
+	a->nsegs = nsegs;
+	for (s = 0; s <= nsegs; s++)
+		a->first[s] = first[s];
+	for (s = 0; s < nsegs; s++)
+		a->core[s] = (first_core >= 0 && s > 0) ? first_core + s - 1 : -1;
+	calc_pipeline (a);
+	if (a->nsegs > 1)
+		start_workers (a);
+}
+
+int segment_pipeline (PIPELINE a, int group)
+{
+	int s = 0;
+	while (group >= a->first[s + 1])
+		s++;
+	return s;
+}
+
+double* groupBuffer_pipeline (PIPELINE a, int group)
+{
+	return a->buff[segment_pipeline (a, group)];
+}
+
+void getStats_pipeline (PIPELINE a, double* mean_us, double* max_us)
+{
+	// per segment, over the blocks it has run since the last flush
+	int s;
+	for (s = 0; s < a->nsegs; s++)
+	{
+		mean_us[s] = a->step > s ? 1.0e-3 * (double)a->worker[s].ns / (double)(a->step - s) : 0.0;
+		max_us[s] = 1.0e-3 * (double)a->worker[s].max_ns;
+	}
+}
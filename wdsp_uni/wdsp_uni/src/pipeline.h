@@ -0,0 +1,81 @@
+/*  pipeline.h
+
+This file is part of a program that implements a Software-Defined Radio.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+/********************************************************************************************************
+*																										*
+*										Stage Pipeline Executor											*
+*																										*
+********************************************************************************************************/
+
+#ifndef _wdsp_pipeline_h
+#define _wdsp_pipeline_h
+
+#define MAX_PIPE_SEGS		4
+
+typedef struct _pipeline *PIPELINE;
+
+typedef struct _pipeseg
+{
+	PIPELINE p;
+	int seg;								// segment run by this worker
+	HANDLE Sem_Go;							// released once per step
+	long long ns;							// total time spent in the segment
+	long long max_ns;						// longest time spent in the segment
+} pipeseg;
+
+typedef struct _pipeline
+{
+	int channel;
+	int ngroups;							// stage groups making up the chain
+	void (*xgroup) (int channel, int group);	// runs one stage group in place on its segment's buffer
+	int size;								// complex samples handed on per block
+	double* mbuff;							// the chain's own working buffer, used by segment 0
+	int nsegs;								// segments, 1 runs every group in turn on the calling thread
+	int first[MAX_PIPE_SEGS + 1];			// first group of each segment, first[nsegs] = ngroups
+	int core[MAX_PIPE_SEGS];				// core each worker is pinned to, -1 to leave it unpinned
+	double* buff[MAX_PIPE_SEGS];			// working buffer of each segment
+	double* slot[MAX_PIPE_SEGS][2];			// hand-off into each segment, filled and emptied on alternate steps
+	long step;								// steps run since the last flush
+	long run;								// workers keep running while set
+	pipeseg worker[MAX_PIPE_SEGS];
+	HANDLE Sem_Done;						// released by each worker when its segment of the step is done
+} pipeline;
+
+extern PIPELINE create_pipeline (int channel, int ngroups, void (*xgroup) (int channel, int group), int size, double* mbuff);
+
+extern void destroy_pipeline (PIPELINE a);
+
+extern void flush_pipeline (PIPELINE a);
+
+extern void xpipeline (PIPELINE a);
+
+extern void setBuffers_pipeline (PIPELINE a, double* mbuff);
+
+extern void setSize_pipeline (PIPELINE a, int size);
+
+extern void setSegments_pipeline (PIPELINE a, int nsegs, const int* first, int first_core);
+
+extern int segment_pipeline (PIPELINE a, int group);
+
+extern double* groupBuffer_pipeline (PIPELINE a, int group);
+
+extern void getStats_pipeline (PIPELINE a, double* mean_us, double* max_us);
+
+#endif
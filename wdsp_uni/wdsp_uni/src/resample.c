@@ -71,7 +71,8 @@ void calc_resample (RESAMPLE a)
 		for (k = 0; k < a->ncoef; k += a->L)
 			a->h[i++] = impulse[j + k];
 	a->ringsize = a->cpp;
-	a->ring = (double *)malloc0(a->ringsize * sizeof(complex));
+	// every sample is written twice, ringsize apart, so a phase reads one contiguous run
+	a->ring = (double *)malloc0(2 * a->ringsize * sizeof(complex));
 	a->idx_in = a->ringsize - 1;
 	a->phnum = 0;
 	_aligned_free(impulse);
@@ -112,7 +113,7 @@ void destroy_resample (RESAMPLE a)
 PORT
 void flush_resample (RESAMPLE a)
 {
-	memset (a->ring, 0, a->ringsize * sizeof (complex));
+	memset (a->ring, 0, 2 * a->ringsize * sizeof (complex));
 	a->idx_in = a->ringsize - 1;
 	a->phnum = 0;
 }
@@ -123,31 +124,33 @@ int xresample (RESAMPLE a)
 	int outsamps = 0;
 	if (a->run)
 	{
-		int i, j, n;
-		int idx_out;
-		double I, Q;
+		int i;
+		double* ring;
 
 		for (i = 0; i < a->size; i++)
 		{
-			a->ring[2 * a->idx_in + 0] = a->in[2 * i + 0];
-			a->ring[2 * a->idx_in + 1] = a->in[2 * i + 1];
-			while (a->phnum < a->L)
+			ring = &(a->ring[2 * a->idx_in]);
+			ring[0] = ring[2 * a->ringsize + 0] = a->in[2 * i + 0];
+			ring[1] = ring[2 * a->ringsize + 1] = a->in[2 * i + 1];
+			if (a->L == 1)
 			{
-				I = 0.0;
-				Q = 0.0;
-				n = a->cpp * a->phnum;
-				for (j = 0; j < a->cpp; j++)
+				// integer decimation, one output every M inputs and always phase 0
+				if (a->phnum == 0)
 				{
-					if ((idx_out = a->idx_in + j) >= a->ringsize) idx_out -= a->ringsize;
-					I += a->h[n + j] * a->ring[2 * idx_out + 0];
-					Q += a->h[n + j] * a->ring[2 * idx_out + 1];
+					cdotr (&(a->out[2 * outsamps++]), ring, a->h, a->cpp);
+					a->phnum = a->M;
 				}
-				a->out[2 * outsamps + 0] = I;
-				a->out[2 * outsamps + 1] = Q;
-				outsamps++;
-				a->phnum += a->M;
+				a->phnum--;
+			}
+			else
+			{
+				while (a->phnum < a->L)
+				{
+					cdotr (&(a->out[2 * outsamps++]), ring, &(a->h[a->cpp * a->phnum]), a->cpp);
+					a->phnum += a->M;
+				}
+				a->phnum -= a->L;
 			}
-			a->phnum -= a->L;
 			if (--a->idx_in < 0) a->idx_in = a->ringsize - 1;
 		}
 	}
@@ -52,7 +52,7 @@ typedef struct _resample
 	int M;				// decimation factor
 	double* h;			// coefficients
 	int ringsize;		// number of complex pairs the ring buffer holds
-	double* ring;		// ring buffer
+	double* ring;		// ring buffer, mirrored so it holds 2 * ringsize pairs
 	int cpp;			// coefficients of the phase
 	int phnum;			// phase number
 } resample, *RESAMPLE;
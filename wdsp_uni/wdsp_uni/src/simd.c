@@ -0,0 +1,727 @@
+/*  simd.c
+
+This file is part of a program that implements a Software-Defined Radio.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#include "comm.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define SIMD_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#define TARGET(isa)
+#else
+#define TARGET(isa) __attribute__((target(isa)))
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+/********************************************************************************************************
+*																										*
+*										CPU Feature Detection											*
+*																										*
+********************************************************************************************************/
+
+#ifdef SIMD_X86
+static int cpu_has_avx2_fma (void)
+{
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid (info, 1);
+	// FMA, OSXSAVE and AVX, and the OS saves the YMM state
+	if ((info[2] & (1 << 12)) == 0 || (info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0)
+		return 0;
+	if ((_xgetbv (0) & 6) != 6)
+		return 0;
+	__cpuidex (info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	return __builtin_cpu_supports ("avx2") && __builtin_cpu_supports ("fma");
+#endif
+}
+#endif
+
+/********************************************************************************************************
+*																										*
+*									Complex Multiply-Accumulate											*
+*																										*
+********************************************************************************************************/
+
+static void cmac_scalar (double* acc, const double* x, const double* m, int n)
+{
+	int i;
+	for (i = 0; i < n; i++)
+	{
+		acc[2 * i + 0] += x[2 * i + 0] * m[2 * i + 0] - x[2 * i + 1] * m[2 * i + 1];
+		acc[2 * i + 1] += x[2 * i + 0] * m[2 * i + 1] + x[2 * i + 1] * m[2 * i + 0];
+	}
+}
+
+#ifdef SIMD_X86
+// two complex values per vector: re = xr*mr - xi*mi, im = xi*mr + xr*mi
+// the AVX2 kernels clear the upper halves before handing a tail to scalar code, which
+// otherwise runs with a state transition penalty on some cores
+#define CMAC_AVX2(acc, x, m) \
+	_mm256_add_pd (acc, _mm256_fmaddsub_pd (x, _mm256_movedup_pd (m), \
+		_mm256_mul_pd (_mm256_permute_pd (x, 0x5), _mm256_permute_pd (m, 0xF))))
+
+TARGET("avx2,fma")
+static void cmac_avx2 (double* acc, const double* x, const double* m, int n)
+{
+	int i;
+	__m256d a0, a1;
+	// two vectors per pass to overlap the dependent add chains
+	for (i = 0; i + 4 <= n; i += 4)
+	{
+		a0 = CMAC_AVX2 (_mm256_loadu_pd (acc + 2 * i + 0), _mm256_loadu_pd (x + 2 * i + 0), _mm256_loadu_pd (m + 2 * i + 0));
+		a1 = CMAC_AVX2 (_mm256_loadu_pd (acc + 2 * i + 4), _mm256_loadu_pd (x + 2 * i + 4), _mm256_loadu_pd (m + 2 * i + 4));
+		_mm256_storeu_pd (acc + 2 * i + 0, a0);
+		_mm256_storeu_pd (acc + 2 * i + 4, a1);
+	}
+	_mm256_zeroupper ();
+	cmac_scalar (acc + 2 * i, x + 2 * i, m + 2 * i, n - i);
+}
+#endif
+
+#ifdef SIMD_NEON
+static void cmac_neon (double* acc, const double* x, const double* m, int n)
+{
+	int i;
+	float64x2_t vx, vm, va;
+	const float64x2_t sign = { -1.0, 1.0 };
+	// one complex value per vector: acc += x * mr + [xi, xr] * [-mi, mi]
+	for (i = 0; i < n; i++)
+	{
+		vx = vld1q_f64 (x + 2 * i);
+		vm = vld1q_f64 (m + 2 * i);
+		va = vld1q_f64 (acc + 2 * i);
+		va = vfmaq_laneq_f64 (va, vx, vm, 0);
+		va = vfmaq_f64 (va, vextq_f64 (vx, vx, 1), vmulq_f64 (vdupq_laneq_f64 (vm, 1), sign));
+		vst1q_f64 (acc + 2 * i, va);
+	}
+}
+#endif
+
+/********************************************************************************************************
+*																										*
+*								Complex Dot Product, Real Coefficients									*
+*																										*
+********************************************************************************************************/
+
+static void cdotr_scalar (double* out, const double* x, const double* h, int n)
+{
+	int j;
+	double I = 0.0, Q = 0.0;
+	for (j = 0; j < n; j++)
+	{
+		I += h[j] * x[2 * j + 0];
+		Q += h[j] * x[2 * j + 1];
+	}
+	out[0] = I;
+	out[1] = Q;
+}
+
+#ifdef SIMD_X86
+TARGET("avx2,fma")
+static void cdotr_avx2 (double* out, const double* x, const double* h, int n)
+{
+	int j;
+	__m256d a0 = _mm256_setzero_pd ();
+	__m256d a1 = _mm256_setzero_pd ();
+	__m256d hv;
+	__m128d s;
+	// I and Q side by side, four coefficients per pass spread as h0 h0 h1 h1 and h2 h2 h3 h3
+	for (j = 0; j + 4 <= n; j += 4)
+	{
+		hv = _mm256_loadu_pd (h + j);
+		a0 = _mm256_fmadd_pd (_mm256_permute4x64_pd (hv, 0x50), _mm256_loadu_pd (x + 2 * j + 0), a0);
+		a1 = _mm256_fmadd_pd (_mm256_permute4x64_pd (hv, 0xFA), _mm256_loadu_pd (x + 2 * j + 4), a1);
+	}
+	a0 = _mm256_add_pd (a0, a1);
+	s = _mm_add_pd (_mm256_castpd256_pd128 (a0), _mm256_extractf128_pd (a0, 1));
+	for (; j < n; j++)
+		s = _mm_add_pd (s, _mm_mul_pd (_mm_set1_pd (h[j]), _mm_loadu_pd (x + 2 * j)));
+	_mm_storeu_pd (out, s);
+}
+#endif
+
+#ifdef SIMD_NEON
+static void cdotr_neon (double* out, const double* x, const double* h, int n)
+{
+	int j;
+	float64x2_t a0 = vdupq_n_f64 (0.0);
+	float64x2_t a1 = vdupq_n_f64 (0.0);
+	float64x2_t hv;
+	// I and Q side by side, two coefficients per pass
+	for (j = 0; j + 2 <= n; j += 2)
+	{
+		hv = vld1q_f64 (h + j);
+		a0 = vfmaq_laneq_f64 (a0, vld1q_f64 (x + 2 * j + 0), hv, 0);
+		a1 = vfmaq_laneq_f64 (a1, vld1q_f64 (x + 2 * j + 2), hv, 1);
+	}
+	a0 = vaddq_f64 (a0, a1);
+	if (j < n)
+		a0 = vfmaq_n_f64 (a0, vld1q_f64 (x + 2 * j), h[j]);
+	vst1q_f64 (out, a0);
+}
+#endif
+
+/********************************************************************************************************
+*																										*
+*									Weighted Power and Peak												*
+*																										*
+********************************************************************************************************/
+
+static void cpwr_scalar (double* out, const double* x, const double* w, int n)
+{
+	int i;
+	double smag, sum = 0.0, peak = 0.0;
+	for (i = 0; i < n; i++)
+	{
+		smag = x[2 * i + 0] * x[2 * i + 0] + x[2 * i + 1] * x[2 * i + 1];
+		sum += w[i] * smag;
+		if (smag > peak) peak = smag;
+	}
+	out[0] = sum;
+	out[1] = peak;
+}
+
+#ifdef SIMD_X86
+TARGET("avx2,fma")
+static void cpwr_avx2 (double* out, const double* x, const double* w, int n)
+{
+	int i;
+	__m256d a0, a1, smag, acc = _mm256_setzero_pd (), pk = _mm256_setzero_pd ();
+	__m128d s;
+	double smag1, sum, peak;
+	// hadd of two squared pairs leaves |x0|^2 |x2|^2 |x1|^2 |x3|^2, the weights are put in the same order
+	for (i = 0; i + 4 <= n; i += 4)
+	{
+		a0 = _mm256_loadu_pd (x + 2 * i + 0);
+		a1 = _mm256_loadu_pd (x + 2 * i + 4);
+		smag = _mm256_hadd_pd (_mm256_mul_pd (a0, a0), _mm256_mul_pd (a1, a1));
+		acc = _mm256_fmadd_pd (_mm256_permute4x64_pd (_mm256_loadu_pd (w + i), 0xD8), smag, acc);
+		pk = _mm256_max_pd (pk, smag);
+	}
+	s = _mm_add_pd (_mm256_castpd256_pd128 (acc), _mm256_extractf128_pd (acc, 1));
+	sum = _mm_cvtsd_f64 (_mm_add_sd (s, _mm_unpackhi_pd (s, s)));
+	s = _mm_max_pd (_mm256_castpd256_pd128 (pk), _mm256_extractf128_pd (pk, 1));
+	peak = _mm_cvtsd_f64 (_mm_max_sd (s, _mm_unpackhi_pd (s, s)));
+	// the tail stays in this function, calling the scalar kernel with the upper halves dirty stalls
+	for (; i < n; i++)
+	{
+		smag1 = x[2 * i + 0] * x[2 * i + 0] + x[2 * i + 1] * x[2 * i + 1];
+		sum += w[i] * smag1;
+		if (smag1 > peak) peak = smag1;
+	}
+	out[0] = sum;
+	out[1] = peak;
+}
+#endif
+
+#ifdef SIMD_NEON
+static void cpwr_neon (double* out, const double* x, const double* w, int n)
+{
+	int i;
+	float64x2_t a0, a1, smag, acc = vdupq_n_f64 (0.0), pk = vdupq_n_f64 (0.0);
+	double sum, peak, rest[2];
+	for (i = 0; i + 2 <= n; i += 2)
+	{
+		a0 = vld1q_f64 (x + 2 * i + 0);
+		a1 = vld1q_f64 (x + 2 * i + 2);
+		smag = vpaddq_f64 (vmulq_f64 (a0, a0), vmulq_f64 (a1, a1));
+		acc = vfmaq_f64 (acc, vld1q_f64 (w + i), smag);
+		pk = vmaxq_f64 (pk, smag);
+	}
+	sum = vaddvq_f64 (acc);
+	peak = vmaxvq_f64 (pk);
+	cpwr_scalar (rest, x + 2 * i, w + i, n - i);
+	out[0] = sum + rest[0];
+	out[1] = rest[1] > peak ? rest[1] : peak;
+}
+#endif
+
+/********************************************************************************************************
+*																										*
+*										Real Windowing													*
+*																										*
+********************************************************************************************************/
+
+static void rmul_scalar (double* out, const double* w, const double* x, int n)
+{
+	int i;
+	for (i = 0; i < n; i++)
+		out[i] = w[i] * x[i];
+}
+
+static void rmac_scalar (double* acc, const double* w, const double* x, int n)
+{
+	int i;
+	for (i = 0; i < n; i++)
+		acc[i] += w[i] * x[i];
+}
+
+#ifdef SIMD_X86
+TARGET("avx2,fma")
+static void rmul_avx2 (double* out, const double* w, const double* x, int n)
+{
+	int i;
+	for (i = 0; i + 8 <= n; i += 8)
+	{
+		_mm256_storeu_pd (out + i + 0, _mm256_mul_pd (_mm256_loadu_pd (w + i + 0), _mm256_loadu_pd (x + i + 0)));
+		_mm256_storeu_pd (out + i + 4, _mm256_mul_pd (_mm256_loadu_pd (w + i + 4), _mm256_loadu_pd (x + i + 4)));
+	}
+	_mm256_zeroupper ();
+	rmul_scalar (out + i, w + i, x + i, n - i);
+}
+
+TARGET("avx2,fma")
+static void rmac_avx2 (double* acc, const double* w, const double* x, int n)
+{
+	int i;
+	for (i = 0; i + 8 <= n; i += 8)
+	{
+		_mm256_storeu_pd (acc + i + 0, _mm256_fmadd_pd (_mm256_loadu_pd (w + i + 0), _mm256_loadu_pd (x + i + 0), _mm256_loadu_pd (acc + i + 0)));
+		_mm256_storeu_pd (acc + i + 4, _mm256_fmadd_pd (_mm256_loadu_pd (w + i + 4), _mm256_loadu_pd (x + i + 4), _mm256_loadu_pd (acc + i + 4)));
+	}
+	_mm256_zeroupper ();
+	rmac_scalar (acc + i, w + i, x + i, n - i);
+}
+#endif
+
+#ifdef SIMD_NEON
+static void rmul_neon (double* out, const double* w, const double* x, int n)
+{
+	int i;
+	for (i = 0; i + 4 <= n; i += 4)
+	{
+		vst1q_f64 (out + i + 0, vmulq_f64 (vld1q_f64 (w + i + 0), vld1q_f64 (x + i + 0)));
+		vst1q_f64 (out + i + 2, vmulq_f64 (vld1q_f64 (w + i + 2), vld1q_f64 (x + i + 2)));
+	}
+	rmul_scalar (out + i, w + i, x + i, n - i);
+}
+
+static void rmac_neon (double* acc, const double* w, const double* x, int n)
+{
+	int i;
+	for (i = 0; i + 4 <= n; i += 4)
+	{
+		vst1q_f64 (acc + i + 0, vfmaq_f64 (vld1q_f64 (acc + i + 0), vld1q_f64 (w + i + 0), vld1q_f64 (x + i + 0)));
+		vst1q_f64 (acc + i + 2, vfmaq_f64 (vld1q_f64 (acc + i + 2), vld1q_f64 (w + i + 2), vld1q_f64 (x + i + 2)));
+	}
+	rmac_scalar (acc + i, w + i, x + i, n - i);
+}
+#endif
+
+/********************************************************************************************************
+*																										*
+*										Envelope Detection												*
+*																										*
+********************************************************************************************************/
+
+static void cenv_scalar (double* out, const double* x, int n, int pmode)
+{
+	int i;
+	if (pmode == 0)
+		for (i = 0; i < n; i++)
+			out[i] = max (fabs (x[2 * i + 0]), fabs (x[2 * i + 1]));
+	else
+		for (i = 0; i < n; i++)
+			out[i] = sqrt (x[2 * i + 0] * x[2 * i + 0] + x[2 * i + 1] * x[2 * i + 1]);
+}
+
+#ifdef SIMD_X86
+TARGET("avx2,fma")
+static void cenv_avx2 (double* out, const double* x, int n, int pmode)
+{
+	int i;
+	__m256d a0, a1, e;
+	const __m256d mask = _mm256_castsi256_pd (_mm256_set1_epi64x (0x7fffffffffffffffLL));
+	// both forms leave the envelopes of x0 x2 x1 x3, the permute restores their order
+	// the squares are summed with hadd rather than fmadd so |x| rounds exactly as the scalar code does
+	for (i = 0; i + 4 <= n; i += 4)
+	{
+		a0 = _mm256_loadu_pd (x + 2 * i + 0);
+		a1 = _mm256_loadu_pd (x + 2 * i + 4);
+		if (pmode == 0)
+		{
+			a0 = _mm256_and_pd (a0, mask);
+			a1 = _mm256_and_pd (a1, mask);
+			e = _mm256_max_pd (_mm256_unpackhi_pd (a0, a1), _mm256_unpacklo_pd (a0, a1));
+		}
+		else
+			e = _mm256_sqrt_pd (_mm256_hadd_pd (_mm256_mul_pd (a0, a0), _mm256_mul_pd (a1, a1)));
+		_mm256_storeu_pd (out + i, _mm256_permute4x64_pd (e, 0xD8));
+	}
+	_mm256_zeroupper ();
+	cenv_scalar (out + i, x + 2 * i, n - i, pmode);
+}
+#endif
+
+#ifdef SIMD_NEON
+static void cenv_neon (double* out, const double* x, int n, int pmode)
+{
+	int i;
+	float64x2_t a0, a1;
+	for (i = 0; i + 2 <= n; i += 2)
+	{
+		a0 = vld1q_f64 (x + 2 * i + 0);
+		a1 = vld1q_f64 (x + 2 * i + 2);
+		if (pmode == 0)
+			vst1q_f64 (out + i, vmaxq_f64 (vabsq_f64 (vuzp1q_f64 (a0, a1)), vabsq_f64 (vuzp2q_f64 (a0, a1))));
+		else
+			vst1q_f64 (out + i, vsqrtq_f64 (vpaddq_f64 (vmulq_f64 (a0, a0), vmulq_f64 (a1, a1))));
+	}
+	cenv_scalar (out + i, x + 2 * i, n - i, pmode);
+}
+#endif
+
+/********************************************************************************************************
+*																										*
+*										LMS Filter Kernels												*
+*																										*
+********************************************************************************************************/
+
+static void lmsdot_scalar (double* out, const double* w, const double* x, int n)
+{
+	int j;
+	double y = 0.0, sigma = 0.0;
+	for (j = 0; j < n; j++)
+	{
+		y += w[j] * x[j];
+		sigma += x[j] * x[j];
+	}
+	out[0] = y;
+	out[1] = sigma;
+}
+
+static void lmsupd_scalar (double* out, double* w, const double* x, const double* xn, int n, double c0, double c1)
+{
+	int j;
+	double y = 0.0, sigma = 0.0;
+	for (j = 0; j < n; j++)
+	{
+		w[j] = c0 * w[j] + c1 * x[j];
+		y += w[j] * xn[j];
+		sigma += xn[j] * xn[j];
+	}
+	out[0] = y;
+	out[1] = sigma;
+}
+
+#ifdef SIMD_X86
+TARGET("avx2,fma")
+static double hsum_avx2 (__m256d v)
+{
+	__m128d s = _mm_add_pd (_mm256_castpd256_pd128 (v), _mm256_extractf128_pd (v, 1));
+	return _mm_cvtsd_f64 (_mm_add_sd (s, _mm_unpackhi_pd (s, s)));
+}
+
+TARGET("avx2,fma")
+static void lmsdot_avx2 (double* out, const double* w, const double* x, int n)
+{
+	int j;
+	__m256d y0 = _mm256_setzero_pd (), y1 = _mm256_setzero_pd ();
+	__m256d s0 = _mm256_setzero_pd (), s1 = _mm256_setzero_pd ();
+	__m256d x0, x1;
+	double y, sigma;
+	for (j = 0; j + 8 <= n; j += 8)
+	{
+		x0 = _mm256_loadu_pd (x + j + 0);
+		x1 = _mm256_loadu_pd (x + j + 4);
+		y0 = _mm256_fmadd_pd (_mm256_loadu_pd (w + j + 0), x0, y0);
+		y1 = _mm256_fmadd_pd (_mm256_loadu_pd (w + j + 4), x1, y1);
+		s0 = _mm256_fmadd_pd (x0, x0, s0);
+		s1 = _mm256_fmadd_pd (x1, x1, s1);
+	}
+	y = hsum_avx2 (_mm256_add_pd (y0, y1));
+	sigma = hsum_avx2 (_mm256_add_pd (s0, s1));
+	for (; j < n; j++)
+	{
+		y += w[j] * x[j];
+		sigma += x[j] * x[j];
+	}
+	out[0] = y;
+	out[1] = sigma;
+}
+
+TARGET("avx2,fma")
+static void lmsupd_avx2 (double* out, double* w, const double* x, const double* xn, int n, double c0, double c1)
+{
+	int j;
+	const __m256d vc0 = _mm256_set1_pd (c0), vc1 = _mm256_set1_pd (c1);
+	__m256d y0 = _mm256_setzero_pd (), y1 = _mm256_setzero_pd ();
+	__m256d s0 = _mm256_setzero_pd (), s1 = _mm256_setzero_pd ();
+	__m256d w0, w1, x0, x1;
+	double y, sigma;
+	for (j = 0; j + 8 <= n; j += 8)
+	{
+		w0 = _mm256_fmadd_pd (vc1, _mm256_loadu_pd (x + j + 0), _mm256_mul_pd (vc0, _mm256_loadu_pd (w + j + 0)));
+		w1 = _mm256_fmadd_pd (vc1, _mm256_loadu_pd (x + j + 4), _mm256_mul_pd (vc0, _mm256_loadu_pd (w + j + 4)));
+		_mm256_storeu_pd (w + j + 0, w0);
+		_mm256_storeu_pd (w + j + 4, w1);
+		x0 = _mm256_loadu_pd (xn + j + 0);
+		x1 = _mm256_loadu_pd (xn + j + 4);
+		y0 = _mm256_fmadd_pd (w0, x0, y0);
+		y1 = _mm256_fmadd_pd (w1, x1, y1);
+		s0 = _mm256_fmadd_pd (x0, x0, s0);
+		s1 = _mm256_fmadd_pd (x1, x1, s1);
+	}
+	y = hsum_avx2 (_mm256_add_pd (y0, y1));
+	sigma = hsum_avx2 (_mm256_add_pd (s0, s1));
+	for (; j < n; j++)
+	{
+		w[j] = c0 * w[j] + c1 * x[j];
+		y += w[j] * xn[j];
+		sigma += xn[j] * xn[j];
+	}
+	out[0] = y;
+	out[1] = sigma;
+}
+#endif
+
+#ifdef SIMD_NEON
+static void lmsdot_neon (double* out, const double* w, const double* x, int n)
+{
+	int j;
+	float64x2_t y0 = vdupq_n_f64 (0.0), y1 = vdupq_n_f64 (0.0);
+	float64x2_t s0 = vdupq_n_f64 (0.0), s1 = vdupq_n_f64 (0.0);
+	float64x2_t x0, x1;
+	double y, sigma;
+	for (j = 0; j + 4 <= n; j += 4)
+	{
+		x0 = vld1q_f64 (x + j + 0);
+		x1 = vld1q_f64 (x + j + 2);
+		y0 = vfmaq_f64 (y0, vld1q_f64 (w + j + 0), x0);
+		y1 = vfmaq_f64 (y1, vld1q_f64 (w + j + 2), x1);
+		s0 = vfmaq_f64 (s0, x0, x0);
+		s1 = vfmaq_f64 (s1, x1, x1);
+	}
+	y = vaddvq_f64 (vaddq_f64 (y0, y1));
+	sigma = vaddvq_f64 (vaddq_f64 (s0, s1));
+	for (; j < n; j++)
+	{
+		y += w[j] * x[j];
+		sigma += x[j] * x[j];
+	}
+	out[0] = y;
+	out[1] = sigma;
+}
+
+static void lmsupd_neon (double* out, double* w, const double* x, const double* xn, int n, double c0, double c1)
+{
+	int j;
+	float64x2_t y0 = vdupq_n_f64 (0.0), y1 = vdupq_n_f64 (0.0);
+	float64x2_t s0 = vdupq_n_f64 (0.0), s1 = vdupq_n_f64 (0.0);
+	float64x2_t w0, w1, x0, x1;
+	double y, sigma;
+	for (j = 0; j + 4 <= n; j += 4)
+	{
+		w0 = vfmaq_n_f64 (vmulq_n_f64 (vld1q_f64 (w + j + 0), c0), vld1q_f64 (x + j + 0), c1);
+		w1 = vfmaq_n_f64 (vmulq_n_f64 (vld1q_f64 (w + j + 2), c0), vld1q_f64 (x + j + 2), c1);
+		vst1q_f64 (w + j + 0, w0);
+		vst1q_f64 (w + j + 2, w1);
+		x0 = vld1q_f64 (xn + j + 0);
+		x1 = vld1q_f64 (xn + j + 2);
+		y0 = vfmaq_f64 (y0, w0, x0);
+		y1 = vfmaq_f64 (y1, w1, x1);
+		s0 = vfmaq_f64 (s0, x0, x0);
+		s1 = vfmaq_f64 (s1, x1, x1);
+	}
+	y = vaddvq_f64 (vaddq_f64 (y0, y1));
+	sigma = vaddvq_f64 (vaddq_f64 (s0, s1));
+	for (; j < n; j++)
+	{
+		w[j] = c0 * w[j] + c1 * x[j];
+		y += w[j] * xn[j];
+		sigma += xn[j] * xn[j];
+	}
+	out[0] = y;
+	out[1] = sigma;
+}
+#endif
+
+/********************************************************************************************************
+*																										*
+*										Kernel Selection												*
+*																										*
+********************************************************************************************************/
+
+static void cmac_first (double* acc, const double* x, const double* m, int n);
+static void cdotr_first (double* out, const double* x, const double* h, int n);
+static void cpwr_first (double* out, const double* x, const double* w, int n);
+static void cenv_first (double* out, const double* x, int n, int pmode);
+static void rmul_first (double* out, const double* w, const double* x, int n);
+static void rmac_first (double* acc, const double* w, const double* x, int n);
+static void lmsdot_first (double* out, const double* w, const double* x, int n);
+static void lmsupd_first (double* out, double* w, const double* x, const double* xn, int n, double c0, double c1);
+
+// every thread that selects writes the same values, so no locking is needed
+static void (*cmac_fn) (double* acc, const double* x, const double* m, int n) = cmac_first;
+static void (*cdotr_fn) (double* out, const double* x, const double* h, int n) = cdotr_first;
+static void (*cpwr_fn) (double* out, const double* x, const double* w, int n) = cpwr_first;
+static void (*cenv_fn) (double* out, const double* x, int n, int pmode) = cenv_first;
+static void (*rmul_fn) (double* out, const double* w, const double* x, int n) = rmul_first;
+static void (*rmac_fn) (double* acc, const double* w, const double* x, int n) = rmac_first;
+static void (*lmsdot_fn) (double* out, const double* w, const double* x, int n) = lmsdot_first;
+static void (*lmsupd_fn) (double* out, double* w, const double* x, const double* xn, int n, double c0, double c1) = lmsupd_first;
+static const char* simd_name = "scalar";
+static volatile long simd_selected = 0;
+
+static void select_kernels (void)
+{
+	void (*cmac_sel) (double* acc, const double* x, const double* m, int n) = cmac_scalar;
+	void (*cdotr_sel) (double* out, const double* x, const double* h, int n) = cdotr_scalar;
+	void (*cpwr_sel) (double* out, const double* x, const double* w, int n) = cpwr_scalar;
+	void (*cenv_sel) (double* out, const double* x, int n, int pmode) = cenv_scalar;
+	void (*rmul_sel) (double* out, const double* w, const double* x, int n) = rmul_scalar;
+	void (*rmac_sel) (double* acc, const double* w, const double* x, int n) = rmac_scalar;
+	void (*lmsdot_sel) (double* out, const double* w, const double* x, int n) = lmsdot_scalar;
+	void (*lmsupd_sel) (double* out, double* w, const double* x, const double* xn, int n, double c0, double c1) = lmsupd_scalar;
+#if defined(SIMD_X86)
+	if (cpu_has_avx2_fma ())
+	{
+		cmac_sel = cmac_avx2;
+		cdotr_sel = cdotr_avx2;
+		cpwr_sel = cpwr_avx2;
+		cenv_sel = cenv_avx2;
+		rmul_sel = rmul_avx2;
+		rmac_sel = rmac_avx2;
+		lmsdot_sel = lmsdot_avx2;
+		lmsupd_sel = lmsupd_avx2;
+		simd_name = "avx2/fma";
+	}
+#elif defined(SIMD_NEON)
+	cmac_sel = cmac_neon;
+	cdotr_sel = cdotr_neon;
+	cpwr_sel = cpwr_neon;
+	cenv_sel = cenv_neon;
+	rmul_sel = rmul_neon;
+	rmac_sel = rmac_neon;
+	lmsdot_sel = lmsdot_neon;
+	lmsupd_sel = lmsupd_neon;
+	simd_name = "neon";
+#endif
+	cmac_fn = cmac_sel;
+	cdotr_fn = cdotr_sel;
+	cpwr_fn = cpwr_sel;
+	cenv_fn = cenv_sel;
+	rmul_fn = rmul_sel;
+	rmac_fn = rmac_sel;
+	lmsdot_fn = lmsdot_sel;
+	lmsupd_fn = lmsupd_sel;
+	simd_selected = 1;
+}
+
+static void cmac_first (double* acc, const double* x, const double* m, int n)
+{
+	select_kernels ();
+	cmac_fn (acc, x, m, n);
+}
+
+static void cdotr_first (double* out, const double* x, const double* h, int n)
+{
+	select_kernels ();
+	cdotr_fn (out, x, h, n);
+}
+
+static void cpwr_first (double* out, const double* x, const double* w, int n)
+{
+	select_kernels ();
+	cpwr_fn (out, x, w, n);
+}
+
+static void cenv_first (double* out, const double* x, int n, int pmode)
+{
+	select_kernels ();
+	cenv_fn (out, x, n, pmode);
+}
+
+static void rmul_first (double* out, const double* w, const double* x, int n)
+{
+	select_kernels ();
+	rmul_fn (out, w, x, n);
+}
+
+static void rmac_first (double* acc, const double* w, const double* x, int n)
+{
+	select_kernels ();
+	rmac_fn (acc, w, x, n);
+}
+
+static void lmsdot_first (double* out, const double* w, const double* x, int n)
+{
+	select_kernels ();
+	lmsdot_fn (out, w, x, n);
+}
+
+static void lmsupd_first (double* out, double* w, const double* x, const double* xn, int n, double c0, double c1)
+{
+	select_kernels ();
+	lmsupd_fn (out, w, x, xn, n, c0, c1);
+}
+
+void cmac (double* acc, const double* x, const double* m, int n)
+{
+	cmac_fn (acc, x, m, n);
+}
+
+void cdotr (double* out, const double* x, const double* h, int n)
+{
+	cdotr_fn (out, x, h, n);
+}
+
+void cpwr (double* out, const double* x, const double* w, int n)
+{
+	cpwr_fn (out, x, w, n);
+}
+
+void cenv (double* out, const double* x, int n, int pmode)
+{
+	cenv_fn (out, x, n, pmode);
+}
+
+void rmul (double* out, const double* w, const double* x, int n)
+{
+	rmul_fn (out, w, x, n);
+}
+
+void rmac (double* acc, const double* w, const double* x, int n)
+{
+	rmac_fn (acc, w, x, n);
+}
+
+void lmsdot (double* out, const double* w, const double* x, int n)
+{
+	lmsdot_fn (out, w, x, n);
+}
+
+void lmsupd (double* out, double* w, const double* x, const double* xn, int n, double c0, double c1)
+{
+	lmsupd_fn (out, w, x, xn, n, c0, c1);
+}
+
+PORT
+const char* GetSIMDName (void)
+{
+	if (!simd_selected)
+		select_kernels ();
+	return simd_name;
+}
@@ -0,0 +1,59 @@
+/*  simd.h
+
+This file is part of a program that implements a Software-Defined Radio.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+/********************************************************************************************************
+*																										*
+*										Vector Kernels													*
+*																										*
+********************************************************************************************************/
+
+#ifndef _simd_h
+#define _simd_h
+
+// kernels are chosen for the running CPU on first use
+
+// acc[i] += x[i] * m[i] for n interleaved complex values
+extern void cmac (double* acc, const double* x, const double* m, int n);
+
+// out[0], out[1] = sum of h[j] * x[j] over n interleaved complex x and real h
+extern void cdotr (double* out, const double* x, const double* h, int n);
+
+// out[0] = sum of w[i] * |x[i]|^2, out[1] = largest |x[i]|^2 over n interleaved complex x
+extern void cpwr (double* out, const double* x, const double* w, int n);
+
+// out[i] = max(|re|, |im|) of x[i] when pmode is 0, otherwise |x[i]|, over n interleaved complex x
+extern void cenv (double* out, const double* x, int n, int pmode);
+
+// out[i] = w[i] * x[i] over n real values
+extern void rmul (double* out, const double* w, const double* x, int n);
+
+// acc[i] += w[i] * x[i] over n real values
+extern void rmac (double* acc, const double* w, const double* x, int n);
+
+// out[0] = sum of w[j] * x[j], out[1] = sum of x[j] * x[j] over n real values
+extern void lmsdot (double* out, const double* w, const double* x, int n);
+
+// w[j] = c0 * w[j] + c1 * x[j], then lmsdot of the updated w against xn, in one pass
+extern void lmsupd (double* out, double* w, const double* x, const double* xn, int n, double c0, double c1);
+
+// name of the selected instruction set, "scalar" when none
+__declspec (dllexport) const char* GetSIMDName (void);
+
+#endif
@@ -0,0 +1,179 @@
+/*  stft.c
+
+This file is part of a program that implements a Software-Defined Radio.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+#include "comm.h"
+
+int gcd_stft (int a, int b)
+{
+	int t;
+	while (b)
+	{
+		t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+void calc_latency_stft (STFT a)
+{
+	// The output delay matches the circular accumulators this engine replaced: their write index
+	// started at 'init' in a ring of 'rsize' and each read returned the latest write to its slot,
+	// which is the smallest delay congruent to init that never reads ahead of the frames.
+	int c, ncalls, frames, need, init, rsize, level, maxlevel;
+	if (a->fsize > a->bsize)
+	{
+		rsize = max (a->bsize, a->incr);
+		init = (a->fsize - a->bsize - a->incr) % rsize;
+	}
+	else
+	{
+		rsize = a->bsize;
+		init = a->fsize - a->incr;
+	}
+	// the frame pattern repeats every incr / gcd calls once the first frame is out
+	ncalls = a->fsize / a->bsize + 2 * a->incr / gcd_stft (a->bsize, a->incr) + 2;
+	need = 0;
+	for (c = 0; c < ncalls; c++)
+	{
+		frames = (c + 1) * a->bsize >= a->fsize ? ((c + 1) * a->bsize - a->fsize) / a->incr + 1 : 0;
+		if ((c + 1) * a->bsize - frames * a->incr > need)
+			need = (c + 1) * a->bsize - frames * a->incr;
+	}
+	a->init_oalen = need + ((init - need) % rsize + rsize) % rsize;
+	maxlevel = 0;
+	for (c = 0; c < ncalls; c++)
+	{
+		frames = (c + 1) * a->bsize >= a->fsize ? ((c + 1) * a->bsize - a->fsize) / a->incr + 1 : 0;
+		level = a->init_oalen + frames * a->incr - c * a->bsize;
+		if (level > maxlevel) maxlevel = level;
+	}
+	a->oasize = maxlevel + 2 * a->fsize;
+	a->iasize = a->bsize + 2 * a->fsize;
+}
+
+STFT create_stft (int bsize, int fsize, int ovrlp, void (*frame) (void* arg), void* arg)
+{
+	STFT a = (STFT) malloc0 (sizeof (stft));
+	a->bsize = bsize;
+	a->fsize = fsize;
+	a->ovrlp = ovrlp;
+	a->incr = fsize / ovrlp;
+	a->msize = fsize / 2 + 1;
+	a->frame = frame;
+	a->arg = arg;
+	calc_latency_stft (a);
+	a->fwin      = (double *)malloc0 (a->fsize  * sizeof (double));
+	a->rwin      = (double *)malloc0 (a->fsize  * sizeof (double));
+	a->inaccum   = (double *)malloc0 (a->iasize * sizeof (double));
+	a->forfftin  = (double *)malloc0 (a->fsize  * sizeof (double));
+	a->forfftout = (double *)malloc0 (a->msize  * sizeof (complex));
+	a->mask      = (double *)malloc0 (a->msize  * sizeof (double));
+	a->revfftin  = (double *)malloc0 (a->msize  * sizeof (complex));
+	a->revfftout = (double *)malloc0 (a->fsize  * sizeof (double));
+	a->outaccum  = (double *)malloc0 (a->oasize * sizeof (double));
+	a->Rfor = fftw_plan_dft_r2c_1d (a->fsize, a->forfftin, (fftw_complex *)a->forfftout, FFTW_ESTIMATE);
+	a->Rrev = fftw_plan_dft_c2r_1d (a->fsize, (fftw_complex *)a->revfftin, a->revfftout, FFTW_ESTIMATE);
+	flush_stft (a);
+	return a;
+}
+
+void destroy_stft (STFT a)
+{
+	fftw_destroy_plan (a->Rrev);
+	fftw_destroy_plan (a->Rfor);
+	_aligned_free (a->outaccum);
+	_aligned_free (a->revfftout);
+	_aligned_free (a->revfftin);
+	_aligned_free (a->mask);
+	_aligned_free (a->forfftout);
+	_aligned_free (a->forfftin);
+	_aligned_free (a->inaccum);
+	_aligned_free (a->rwin);
+	_aligned_free (a->fwin);
+	_aligned_free (a);
+}
+
+void flush_stft (STFT a)
+{
+	memset (a->inaccum, 0, a->iasize * sizeof (double));
+	memset (a->outaccum, 0, a->oasize * sizeof (double));
+	a->iaoutidx = 0;
+	a->nsamps = 0;
+	a->oaoutidx = 0;
+	a->oalen = a->init_oalen;
+}
+
+void setWindow_stft (STFT a, double* window, double pregain, double postgain)
+{
+	int i;
+	for (i = 0; i < a->fsize; i++)
+	{
+		a->fwin[i] = pregain * window[i];
+		a->rwin[i] = postgain * window[i];
+	}
+}
+
+void xstft (STFT a, double* in, double* out)
+{
+	int i, live;
+	double* x;
+	if (a->iaoutidx + a->nsamps + a->bsize > a->iasize)
+	{
+		memmove (a->inaccum, a->inaccum + a->iaoutidx, a->nsamps * sizeof (double));
+		a->iaoutidx = 0;
+	}
+	x = a->inaccum + a->iaoutidx + a->nsamps;
+	for (i = 0; i < a->bsize; i++)
+		x[i] = in[2 * i + 0];
+	a->nsamps += a->bsize;
+	while (a->nsamps >= a->fsize)
+	{
+		rmul (a->forfftin, a->fwin, a->inaccum + a->iaoutidx, a->fsize);
+		a->iaoutidx += a->incr;
+		a->nsamps -= a->incr;
+		fftw_execute (a->Rfor);
+		a->frame (a->arg);
+		for (i = 0; i < a->msize; i++)
+		{
+			a->revfftin[2 * i + 0] = a->mask[i] * a->forfftout[2 * i + 0];
+			a->revfftin[2 * i + 1] = a->mask[i] * a->forfftout[2 * i + 1];
+		}
+		fftw_execute (a->Rrev);
+		if (a->oaoutidx + a->oalen + a->fsize > a->oasize)
+		{
+			// everything past the live span is kept zero for the next frame to add into
+			live = a->oalen + a->fsize - a->incr;
+			memmove (a->outaccum, a->outaccum + a->oaoutidx, live * sizeof (double));
+			memset (a->outaccum + live, 0, a->oaoutidx * sizeof (double));
+			a->oaoutidx = 0;
+		}
+		rmac (a->outaccum + a->oaoutidx + a->oalen, a->rwin, a->revfftout, a->fsize);
+		a->oalen += a->incr;
+	}
+	x = a->outaccum + a->oaoutidx;
+	for (i = 0; i < a->bsize; i++)
+	{
+		out[2 * i + 0] = x[i];
+		out[2 * i + 1] = 0.0;
+	}
+	a->oaoutidx += a->bsize;
+	a->oalen -= a->bsize;
+}
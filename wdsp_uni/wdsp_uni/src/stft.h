@@ -0,0 +1,74 @@
+/*  stft.h
+
+This file is part of a program that implements a Software-Defined Radio.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+/********************************************************************************************************
+*																										*
+*										Overlap-Add Spectral Engine										*
+*																										*
+********************************************************************************************************/
+
+#ifndef _stft_h
+#define _stft_h
+
+// Windowed real FFT frames of fsize every fsize / ovrlp samples.  For each frame the owner's
+// frame function reads forfftout and fills mask, the masked spectrum is transformed back and
+// overlap-added.  Both accumulators are linear with slack of one frame, what is still live
+// is moved to the front only when the slack is used up.
+
+typedef struct _stft
+{
+	int bsize;
+	int fsize;
+	int ovrlp;
+	int incr;
+	int msize;
+	double* fwin;					// analysis window times pregain
+	double* rwin;					// synthesis window times postgain
+	int iasize;
+	double* inaccum;				// [iaoutidx, iaoutidx + nsamps) not yet fully framed
+	int iaoutidx;
+	int nsamps;
+	double* forfftin;
+	double* forfftout;
+	double* mask;
+	double* revfftin;
+	double* revfftout;
+	int oasize;
+	double* outaccum;				// from oaoutidx, oalen complete samples then fsize - incr partial sums
+	int oaoutidx;
+	int init_oalen;
+	int oalen;
+	fftw_plan Rfor;
+	fftw_plan Rrev;
+	void (*frame) (void* arg);
+	void* arg;
+} stft, *STFT;
+
+extern STFT create_stft (int bsize, int fsize, int ovrlp, void (*frame) (void* arg), void* arg);
+
+extern void destroy_stft (STFT a);
+
+extern void flush_stft (STFT a);
+
+extern void setWindow_stft (STFT a, double* window, double pregain, double postgain);
+
+extern void xstft (STFT a, double* in, double* out);
+
+#endif
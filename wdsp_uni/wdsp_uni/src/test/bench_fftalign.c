@@ -0,0 +1,156 @@
+/*  bench_fftalign.c
+
+This file is part of a program that implements a Software-Defined Radio.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+// FFT convolution throughput against buffer alignment, run by 'make bench'.  Each block is one overlap-save
+// step as fircore does it: a forward FFT of 2 * size complex samples, a multiply by the filter mask and the
+// inverse FFT.  It is timed with every buffer on the 64 byte boundary malloc0 now gives, 16 bytes past it,
+// all plain malloc promised before, and 8 bytes past it, where FFTW can use no vector codelets at all.  The
+// plans are made for the buffers they run on, as WDSP makes them.  The outputs at each offset must match
+// the aligned ones, otherwise it fails.
+
+#include "../comm.h"
+
+// the offset buffers are misaligned on purpose, plan them directly
+#undef fftw_plan_dft_1d
+
+#define MIN_SIZE		64
+#define MAX_SIZE		4096
+#define MIN_TIME		0.1
+#define TOL				1.0e-12
+
+static const int offsets[] = { 0, 16, 8 };
+
+#define NOFFSETS		(int)(sizeof (offsets) / sizeof (offsets[0]))
+
+static double now (void)
+{
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + 1.0e-9 * (double)ts.tv_nsec;
+}
+
+typedef struct _conv
+{
+	int n;					// complex FFT size, 2 * block size
+	char* mem[4];
+	double* in;
+	double* spec;
+	double* mask;
+	double* out;
+	fftw_plan pfor;
+	fftw_plan prev;
+} conv;
+
+static double* place (conv* c, int k, int offset)
+{
+	c->mem[k] = (char *) malloc0 (c->n * sizeof (complex) + offset);
+	return (double *)(c->mem[k] + offset);
+}
+
+static void create_conv (conv* c, int size, int offset, unsigned seed)
+{
+	int i;
+	c->n = 2 * size;
+	c->in = place (c, 0, offset);
+	c->spec = place (c, 1, offset);
+	c->mask = place (c, 2, offset);
+	c->out = place (c, 3, offset);
+	c->pfor = fftw_plan_dft_1d (c->n, (fftw_complex *)c->in, (fftw_complex *)c->spec, FFTW_FORWARD, FFTW_MEASURE);
+	c->prev = fftw_plan_dft_1d (c->n, (fftw_complex *)c->spec, (fftw_complex *)c->out, FFTW_BACKWARD, FFTW_MEASURE);
+	for (i = 0; i < 2 * c->n; i++)
+	{
+		seed = seed * 1103515245u + 12345u;
+		c->in[i] = (double)((seed >> 8) & 0xffff) / 65535.0 - 0.5;
+		c->mask[i] = (i & 1) ? 0.0 : 1.0 / (1.0 + 0.01 * (i / 2));
+	}
+}
+
+static void destroy_conv (conv* c)
+{
+	int k;
+	fftw_destroy_plan (c->prev);
+	fftw_destroy_plan (c->pfor);
+	for (k = 0; k < 4; k++)
+		_aligned_free (c->mem[k]);
+}
+
+static void xconv (conv* c)
+{
+	int i;
+	double I, Q;
+	fftw_execute (c->pfor);
+	for (i = 0; i < c->n; i++)
+	{
+		I = c->spec[2 * i + 0];
+		Q = c->spec[2 * i + 1];
+		c->spec[2 * i + 0] = I * c->mask[2 * i + 0] - Q * c->mask[2 * i + 1];
+		c->spec[2 * i + 1] = I * c->mask[2 * i + 1] + Q * c->mask[2 * i + 0];
+	}
+	fftw_execute (c->prev);
+}
+
+// Msamples/s of block input
+static double time_conv (conv* c, int size)
+{
+	long blocks = 0;
+	double t0, t;
+	xconv (c);
+	t0 = now ();
+	do
+	{
+		xconv (c);
+		blocks++;
+		t = now ();
+	} while (t - t0 < MIN_TIME);
+	return (double)blocks * size / (t - t0) * 1.0e-6;
+}
+
+int main ()
+{
+	int size, k, i, fails = 0;
+	double rate[NOFFSETS], err, ref_max;
+	conv c[NOFFSETS];
+	printf ("bench_fftalign: overlap-save block throughput in Msamples/s, buffers at 64 byte boundary + offset\n");
+	for (size = MIN_SIZE; size <= MAX_SIZE; size *= 2)
+	{
+		for (k = 0; k < NOFFSETS; k++)
+		{
+			create_conv (&c[k], size, offsets[k], 11);
+			rate[k] = time_conv (&c[k], size);
+		}
+		for (k = 1; k < NOFFSETS; k++)
+		{
+			// the same transform whichever codelets ran, to rounding
+			err = ref_max = 0.0;
+			for (i = 0; i < 2 * c[0].n; i++)
+			{
+				if (fabs (c[0].out[i]) > ref_max) ref_max = fabs (c[0].out[i]);
+				if (fabs (c[k].out[i] - c[0].out[i]) > err) err = fabs (c[k].out[i] - c[0].out[i]);
+			}
+			if (err > TOL * ref_max)
+				fails++;
+		}
+		printf ("bench_fftalign: size %4d: +0 %6.1f, +16 %6.1f, +8 %6.1f\n", size, rate[0], rate[1], rate[2]);
+		for (k = 0; k < NOFFSETS; k++)
+			destroy_conv (&c[k]);
+	}
+	printf ("bench_fftalign: outputs against the aligned buffers: %s\n", fails ? "FAIL" : "PASS");
+	return fails ? 1 : 0;
+}
@@ -0,0 +1,125 @@
+/*  bench_fircore.c
+
+This file is part of a program that implements a Software-Defined Radio.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+// Partitioned convolution cost over filter length, run by 'make bench'.  xfircore is timed in us per call
+// at block sizes 64 and 1024 for nc = 256 to 16384 taps, once with the scalar multiply-accumulate and once
+// with the kernel picked for this CPU.  simd.c is built in here so the bench can switch between them, the
+// library's copy is then not linked.  The outputs of the two kernels must agree to rounding, otherwise it
+// fails.
+
+#include "../comm.h"
+#include "../simd.c"
+
+#define MIN_NC			256
+#define MAX_NC			16384
+#define RATE			48000.0
+#define WARM			8
+#define MIN_TIME		0.1
+#define TOL				1.0e-12
+
+static const int sizes[] = { 64, 1024 };
+
+#define NSIZES			(int)(sizeof (sizes) / sizeof (sizes[0]))
+
+static double now (void)
+{
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + 1.0e-9 * (double)ts.tv_nsec;
+}
+
+// the multiply-accumulate xfircore calls, scalar or the selected kernel
+static void use_kernels (int scalar)
+{
+	select_kernels ();
+	if (scalar)
+		cmac_fn = cmac_scalar;
+}
+
+// us per call, leaving the output of the last warm up block in last
+static double time_fircore (FIRCORE p, double* out, double* last, int size)
+{
+	int i;
+	long calls = 0;
+	double t0, t;
+	flush_fircore (p);
+	for (i = 0; i < WARM; i++)
+		xfircore (p);
+	memcpy (last, out, size * sizeof (complex));
+	t0 = now ();
+	do
+	{
+		xfircore (p);
+		calls++;
+		t = now ();
+	} while (t - t0 < MIN_TIME);
+	return (t - t0) / (double)calls * 1.0e6;
+}
+
+int main ()
+{
+	int s, i, size, nc, fails = 0;
+	unsigned seed = 5;
+	double t_scalar, t_sel, err, ref_max;
+	double *in, *out, *ref, *res, *impulse;
+	FIRCORE p;
+	use_kernels (0);
+	printf ("bench_fircore: us per xfircore call, scalar against %s\n", simd_name);
+	for (s = 0; s < NSIZES; s++)
+	{
+		size = sizes[s];
+		in = (double *) malloc0 (size * sizeof (complex));
+		// the inverse FFT writes 2 * size into out, as into the RXA/TXA buffers
+		out = (double *) malloc0 (2 * size * sizeof (complex));
+		ref = (double *) malloc0 (size * sizeof (complex));
+		res = (double *) malloc0 (size * sizeof (complex));
+		for (i = 0; i < 2 * size; i++)
+		{
+			seed = seed * 1103515245u + 12345u;
+			in[i] = (double)((seed >> 8) & 0xffff) / 65535.0 - 0.5;
+		}
+		for (nc = max (MIN_NC, size); nc <= MAX_NC; nc *= 2)
+		{
+			impulse = fir_bandpass (nc, -2850.0, -150.0, RATE, 0, 1, 1.0 / (double)(2 * size));
+			p = create_fircore (size, in, out, nc, 0, impulse);
+			use_kernels (1);
+			t_scalar = time_fircore (p, out, ref, size);
+			use_kernels (0);
+			t_sel = time_fircore (p, out, res, size);
+			err = ref_max = 0.0;
+			for (i = 0; i < 2 * size; i++)
+			{
+				if (fabs (ref[i]) > ref_max) ref_max = fabs (ref[i]);
+				if (fabs (res[i] - ref[i]) > err) err = fabs (res[i] - ref[i]);
+			}
+			if (err > TOL * ref_max)
+				fails++;
+			printf ("bench_fircore: size %4d nc %5d: scalar %7.2f %s %7.2f\n", size, nc, t_scalar, simd_name, t_sel);
+			destroy_fircore (p);
+			_aligned_free (impulse);
+		}
+		_aligned_free (res);
+		_aligned_free (ref);
+		_aligned_free (out);
+		_aligned_free (in);
+	}
+	printf ("bench_fircore: %s against scalar output: %s\n", simd_name, fails ? "FAIL" : "PASS");
+	return fails ? 1 : 0;
+}
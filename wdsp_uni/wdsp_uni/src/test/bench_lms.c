@@ -0,0 +1,231 @@
+/*  bench_lms.c
+
+This file is part of a program that implements a Software-Defined Radio.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+// ANR and ANF cost per sample over tap counts, run by 'make bench'.  Blocks of 1024 samples of tones in
+// noise are run through each filter with the RXA settings and 16 to 256 taps.  Each is timed three ways,
+// best of 3: the masked two pass loop xanr/xanf had before the mirrored delay line, copied here as it was;
+// the current code with the scalar LMS kernels; and the current code with the kernels picked for this CPU.
+// simd.c is built in here so the bench can switch kernels.  After the same input the current output must
+// match the old to rounding, otherwise it fails.
+
+#include "../comm.h"
+#include "../simd.c"
+
+#define SIZE			1024
+#define RATE			48000.0
+#define NBLOCKS			16
+#define MIN_TIME		0.1
+#define RUNS			3
+#define TOL				1.0e-9
+
+static double* in;
+static double* out;
+static double* ref;
+
+static double now (void)
+{
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + 1.0e-9 * (double)ts.tv_nsec;
+}
+
+static void use_kernels (int scalar)
+{
+	select_kernels ();
+	if (scalar)
+	{
+		lmsdot_fn = lmsdot_scalar;
+		lmsupd_fn = lmsupd_scalar;
+	}
+}
+
+// xanr before the mirrored delay line
+static void old_xanr (ANR a)
+{
+	int i, j, idx;
+	double c0, c1;
+	double y, error, sigma, inv_sigp;
+	double nel, nev;
+	for (i = 0; i < a->buff_size; i++)
+	{
+		a->d[a->in_idx] = a->in_buff[2 * i + 0];
+		y = 0;
+		sigma = 0;
+		for (j = 0; j < a->n_taps; j++)
+		{
+			idx = (a->in_idx + j + a->delay) & a->mask;
+			y += a->w[j] * a->d[idx];
+			sigma += a->d[idx] * a->d[idx];
+		}
+		inv_sigp = 1.0 / (sigma + 1e-10);
+		error = a->d[a->in_idx] - y;
+		a->out_buff[2 * i + 0] = y;
+		a->out_buff[2 * i + 1] = 0.0;
+		if((nel = error * (1.0 - a->two_mu * sigma * inv_sigp)) < 0.0) nel = -nel;
+		if((nev = a->d[a->in_idx] - (1.0 - a->two_mu * a->ngamma) * y - a->two_mu * error * sigma * inv_sigp) < 0.0) nev = -nev;
+		if (nev < nel)
+			if((a->lidx += a->lincr) > a->lidx_max) a->lidx = a->lidx_max;
+		else
+			if((a->lidx -= a->ldecr) < a->lidx_min) a->lidx = a->lidx_min;
+		a->ngamma = a->gamma * (a->lidx * a->lidx) * (a->lidx * a->lidx) * a->den_mult;
+		c0 = 1.0 - a->two_mu * a->ngamma;
+		c1 = a->two_mu * error * inv_sigp;
+		for (j = 0; j < a->n_taps; j++)
+		{
+			idx = (a->in_idx + j + a->delay) & a->mask;
+			a->w[j] = c0 * a->w[j] + c1 * a->d[idx];
+		}
+		a->in_idx = (a->in_idx + a->mask) & a->mask;
+	}
+}
+
+// xanf before the mirrored delay line
+static void old_xanf (ANF a)
+{
+	int i, j, idx;
+	double c0, c1;
+	double y, error, sigma, inv_sigp;
+	double nel, nev;
+	for (i = 0; i < a->buff_size; i++)
+	{
+		a->d[a->in_idx] = a->in_buff[2 * i + 0];
+		y = 0;
+		sigma = 0;
+		for (j = 0; j < a->n_taps; j++)
+		{
+			idx = (a->in_idx + j + a->delay) & a->mask;
+			y += a->w[j] * a->d[idx];
+			sigma += a->d[idx] * a->d[idx];
+		}
+		inv_sigp = 1.0 / (sigma + 1e-10);
+		error = a->d[a->in_idx] - y;
+		a->out_buff[2 * i + 0] = error;
+		a->out_buff[2 * i + 1] = 0.0;
+		if((nel = error * (1.0 - a->two_mu * sigma * inv_sigp)) < 0.0) nel = -nel;
+		if((nev = a->d[a->in_idx] - (1.0 - a->two_mu * a->ngamma) * y - a->two_mu * error * sigma * inv_sigp) < 0.0) nev = -nev;
+		if (nev < nel)
+			if((a->lidx += a->lincr) > a->lidx_max) a->lidx = a->lidx_max;
+		else
+			if((a->lidx -= a->ldecr) < a->lidx_min) a->lidx = a->lidx_min;
+		a->ngamma = a->gamma * (a->lidx * a->lidx) * (a->lidx * a->lidx) * a->den_mult;
+		c0 = 1.0 - a->two_mu * a->ngamma;
+		c1 = a->two_mu * error * inv_sigp;
+		for (j = 0; j < a->n_taps; j++)
+		{
+			idx = (a->in_idx + j + a->delay) & a->mask;
+			a->w[j] = c0 * a->w[j] + c1 * a->d[idx];
+		}
+		a->in_idx = (a->in_idx + a->mask) & a->mask;
+	}
+}
+
+// the RXA settings other than the taps, running
+static ANR make_anr (int taps)
+{
+	return create_anr (1, 0, SIZE, in, out, ANR_DLINE_SIZE, taps, 16, 0.0001, 0.1, 120.0, 120.0, 200.0, 0.001, 6.25e-10, 1.0, 3.0);
+}
+
+static ANF make_anf (int taps)
+{
+	return create_anf (1, 0, SIZE, in, out, ANF_DLINE_SIZE, taps, 16, 0.0001, 0.1, 1.0, 0.0, 200.0, 6.25e-12, 6.25e-10, 1.0, 3.0);
+}
+
+// one filter, kind 0 ANR or 1 ANF, way 0 old, 1 current scalar, 2 current selected
+// runs blocks from the start of the input, for timing until MIN_TIME has passed, and returns ns per sample
+static double run (int kind, int way, int taps, int blocks, int timed)
+{
+	ANR r = 0;
+	ANF f = 0;
+	long n = 0;
+	double t0, t;
+	double* block = in;
+	if (kind == 0) r = make_anr (taps);
+	else f = make_anf (taps);
+	use_kernels (way == 1);
+	t0 = now ();
+	do
+	{
+		// the filters read in_buff and write out_buff, point them at the next input block
+		block = in + 2 * SIZE * (n % NBLOCKS);
+		if (kind == 0)
+		{
+			r->in_buff = block;
+			if (way == 0) old_xanr (r);
+			else xanr (r, 0);
+		}
+		else
+		{
+			f->in_buff = block;
+			if (way == 0) old_xanf (f);
+			else xanf (f, 0);
+		}
+		n++;
+		t = now ();
+	} while (timed ? t - t0 < MIN_TIME : n < blocks);
+	if (kind == 0) destroy_anr (r);
+	else destroy_anf (f);
+	return (t - t0) / ((double)n * SIZE) * 1.0e9;
+}
+
+int main ()
+{
+	int kind, taps, i, r, fails = 0;
+	unsigned seed = 3;
+	double ns[3], t, err, ref_max, nz;
+	const char* names[2] = { "ANR", "ANF" };
+	in = (double *) malloc0 (NBLOCKS * SIZE * sizeof (complex));
+	out = (double *) malloc0 (SIZE * sizeof (complex));
+	ref = (double *) malloc0 (SIZE * sizeof (complex));
+	for (i = 0; i < NBLOCKS * SIZE; i++)
+	{
+		seed = seed * 1103515245u + 12345u;
+		nz = (double)((seed >> 8) & 0xffff) / 65535.0 - 0.5;
+		in[2 * i + 0] = 0.1 * sin (TWOPI * 700.0 * i / RATE) + 0.05 * sin (TWOPI * 1850.0 * i / RATE) + 0.05 * nz;
+	}
+	use_kernels (0);
+	printf ("bench_lms: ns per sample in %d sample blocks, best of %d, old loop, scalar kernels, %s kernels\n", SIZE, RUNS, simd_name);
+	for (kind = 0; kind < 2; kind++)
+		for (taps = 16; taps <= 256; taps *= 2)
+		{
+			// the same input from flushed filters, old then current
+			run (kind, 0, taps, NBLOCKS, 0);
+			memcpy (ref, out, SIZE * sizeof (complex));
+			run (kind, 2, taps, NBLOCKS, 0);
+			err = ref_max = 0.0;
+			for (i = 0; i < 2 * SIZE; i++)
+			{
+				if (fabs (ref[i]) > ref_max) ref_max = fabs (ref[i]);
+				if (fabs (out[i] - ref[i]) > err) err = fabs (out[i] - ref[i]);
+			}
+			if (err > TOL * ref_max)
+				fails++;
+			// best of RUNS, the rest is other load
+			for (i = 0; i < 3; i++)
+				for (ns[i] = 1.0e30, r = 0; r < RUNS; r++)
+					if ((t = run (kind, i, taps, 0, 1)) < ns[i])
+						ns[i] = t;
+			printf ("bench_lms: %s taps %3d: old %6.1f scalar %6.1f %s %6.1f\n", names[kind], taps, ns[0], ns[1], simd_name, ns[2]);
+		}
+	printf ("bench_lms: current against old output: %s\n", fails ? "FAIL" : "PASS");
+	_aligned_free (ref);
+	_aligned_free (out);
+	_aligned_free (in);
+	return fails ? 1 : 0;
+}
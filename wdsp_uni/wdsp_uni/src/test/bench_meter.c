@@ -0,0 +1,267 @@
+/*  bench_meter.c
+
+This file is part of a program that implements a Software-Defined Radio.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+// Meter cost per call over block size, run by 'make bench'.  xmeter is timed in ns per call for blocks of
+// 64 to 4096 samples three ways, best of 3: the per sample loop under a critical section it had before,
+// copied here as it was; the block form with the scalar power kernel; and with the kernel picked for this
+// CPU.  simd.c is built in here so the bench can switch kernels.  At 1024 samples both the old and the
+// current meter are also timed while another thread polls the readings as the connector does, giving the
+// mean and the worst call.  After the same blocks the average and peak power must match the old to
+// rounding, otherwise it fails.
+
+#include "../comm.h"
+#include "../simd.c"
+
+#define MIN_SIZE		64
+#define MAX_SIZE		4096
+#define POLL_SIZE		1024
+#define RATE			48000
+#define NBLOCKS			16
+#define MIN_TIME		0.1
+#define RUNS			3
+#define TOL				1.0e-9
+
+extern double read_meter (volatile long* seq, double* result);
+
+static double* in;
+
+static double now (void)
+{
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + 1.0e-9 * (double)ts.tv_nsec;
+}
+
+static void use_kernels (int scalar)
+{
+	select_kernels ();
+	if (scalar)
+		cpwr_fn = cpwr_scalar;
+}
+
+// the meter before the block form, average and peak only
+typedef struct _old_meter
+{
+	CRITICAL_SECTION mtupdate;
+	int size;
+	double* buff;
+	double mult_average;
+	double mult_peak;
+	double avg;
+	double peak;
+	double result[2];
+} old_meter, *OLD_METER;
+
+static OLD_METER create_old_meter (int size, double* buff, int rate, double tau_av, double tau_decay)
+{
+	OLD_METER a = (OLD_METER) malloc0 (sizeof (old_meter));
+	InitializeCriticalSectionAndSpinCount (&a->mtupdate, 2500);
+	a->size = size;
+	a->buff = buff;
+	a->mult_average = exp(-1.0 / ((double)rate * tau_av));
+	a->mult_peak = exp(-1.0 / ((double)rate * tau_decay));
+	return a;
+}
+
+static void destroy_old_meter (OLD_METER a)
+{
+	DeleteCriticalSection (&a->mtupdate);
+	_aligned_free (a);
+}
+
+static void xold_meter (OLD_METER a)
+{
+	int i;
+	double smag;
+	double np = 0.0;
+	EnterCriticalSection (&a->mtupdate);
+	for (i = 0; i < a->size; i++)
+	{
+		smag = a->buff[2 * i + 0] * a->buff[2 * i + 0] + a->buff[2 * i + 1] * a->buff[2 * i + 1];
+		a->avg = a->avg * a->mult_average + (1.0 - a->mult_average) * smag;
+		a->peak *= a->mult_peak;
+		if (smag > np) np = smag;
+	}
+	if (np > a->peak) a->peak = np;
+	a->result[0] = 10.0 * mlog10 (a->avg + 1.0e-40);
+	a->result[1] = 10.0 * mlog10 (a->peak + 1.0e-40);
+	LeaveCriticalSection (&a->mtupdate);
+}
+
+static double read_old_meter (OLD_METER a, int mt)
+{
+	double val;
+	EnterCriticalSection (&a->mtupdate);
+	val = a->result[mt];
+	LeaveCriticalSection (&a->mtupdate);
+	return val;
+}
+
+// one of each kind of meter, way 0 old, 1 current scalar, 2 current selected
+typedef struct _bmeter
+{
+	int way;
+	OLD_METER o;
+	METER m;
+	double result[2];
+	volatile long* pmtseq[2];
+	volatile long stop;
+	volatile long done;
+	long reads;
+} bmeter;
+
+static void create_bmeter (bmeter* b, int way, int size)
+{
+	memset (b, 0, sizeof (bmeter));
+	b->way = way;
+	if (way == 0)
+		b->o = create_old_meter (size, in, RATE, 0.1, 0.1);
+	else
+		b->m = create_meter (1, 0, size, in, RATE, 0.1, 0.1, b->result, b->pmtseq, 0, 1, -1, 0);
+	use_kernels (way == 1);
+}
+
+static void destroy_bmeter (bmeter* b)
+{
+	if (b->o) destroy_old_meter (b->o);
+	if (b->m) destroy_meter (b->m);
+}
+
+// block n of the input
+static void xbmeter (bmeter* b, int size, long n)
+{
+	double* block = in + 2 * MAX_SIZE * (n % NBLOCKS);
+	if (b->way == 0)
+	{
+		b->o->buff = block;
+		xold_meter (b->o);
+	}
+	else
+	{
+		setBuffers_meter (b->m, block);
+		xmeter (b->m);
+	}
+}
+
+static double read_bmeter (bmeter* b, int mt)
+{
+	if (b->way == 0)
+		return read_old_meter (b->o, mt);
+	else
+		return read_meter (b->pmtseq[mt], &b->result[mt]);
+}
+
+// the connector's side, reading both meters until told to stop
+static void poll_bmeter (void* arg)
+{
+	bmeter* b = (bmeter*)arg;
+	volatile double sink = 0.0;
+	while (!b->stop)
+	{
+		sink += read_bmeter (b, 0) + read_bmeter (b, 1);
+		b->reads++;
+		SwitchToThread ();
+	}
+	InterlockedIncrement (&b->done);
+	_endthread ();
+}
+
+// ns per call including a clock read, the mean and with worst the longest single call
+static double time_bmeter (bmeter* b, int size, double* worst)
+{
+	long n = 0;
+	double t0, t1, t, w = 0.0;
+	t0 = t = now ();
+	do
+	{
+		xbmeter (b, size, n++);
+		t1 = now ();
+		if (t1 - t > w) w = t1 - t;
+		t = t1;
+	} while (t - t0 < MIN_TIME);
+	if (worst) *worst = w * 1.0e9;
+	return (t - t0) / (double)n * 1.0e9;
+}
+
+int main ()
+{
+	int size, way, i, r, fails = 0;
+	unsigned seed = 9;
+	double ns[3], t, nz, env, worst[2], mean[2];
+	long reads[2];
+	bmeter b[3];
+	in = (double *) malloc0 (NBLOCKS * MAX_SIZE * sizeof (complex));
+	for (i = 0; i < NBLOCKS * MAX_SIZE; i++)
+	{
+		// noise with the level stepping between blocks, so the peak decays as well as rises
+		seed = seed * 1103515245u + 12345u;
+		nz = (double)((seed >> 8) & 0xffff) / 65535.0 - 0.5;
+		env = 0.01 + 0.5 * ((i / MAX_SIZE) % 4) / 3.0;
+		in[2 * i + 0] = env * (0.5 * sin (TWOPI * 700.0 * i / RATE) + nz);
+		in[2 * i + 1] = env * (0.5 * cos (TWOPI * 700.0 * i / RATE) - nz);
+	}
+	use_kernels (0);
+	printf ("bench_meter: ns per xmeter call, best of %d, old loop, scalar kernel, %s kernel\n", RUNS, simd_name);
+	for (size = MIN_SIZE; size <= MAX_SIZE; size *= 2)
+	{
+		// the same blocks from flushed meters, all three must agree, ending on a step down so the peak
+		// is the decayed one
+		for (way = 0; way < 3; way++)
+		{
+			create_bmeter (&b[way], way, size);
+			for (i = 0; i < 4 * NBLOCKS + 1; i++)
+				xbmeter (&b[way], size, i);
+		}
+		// the readings go through the mlog10 table, compare the power behind them
+		for (way = 1; way < 3; way++)
+		{
+			if (fabs (b[way].m->avg - b[0].o->avg) > TOL * b[0].o->avg)
+				fails++;
+			if (fabs (b[way].m->peak - b[0].o->peak) > TOL * b[0].o->peak)
+				fails++;
+		}
+		// best of RUNS, the rest is other load
+		for (way = 0; way < 3; way++)
+		{
+			for (ns[way] = 1.0e30, r = 0; r < RUNS; r++)
+				if ((t = time_bmeter (&b[way], size, 0)) < ns[way])
+					ns[way] = t;
+			destroy_bmeter (&b[way]);
+		}
+		printf ("bench_meter: size %4d: old %8.1f scalar %8.1f %s %8.1f\n", size, ns[0], ns[1], simd_name, ns[2]);
+	}
+	// the old lock and the current sequence count, each with a reader polling
+	for (way = 0; way < 3; way += 2)
+	{
+		create_bmeter (&b[way], way, POLL_SIZE);
+		wdsp_beginthread (poll_bmeter, 0, (void *)&b[way]);
+		mean[way / 2] = time_bmeter (&b[way], POLL_SIZE, &worst[way / 2]);
+		InterlockedIncrement (&b[way].stop);
+		while (!b[way].done)
+			Sleep (1);
+		reads[way / 2] = b[way].reads;
+		destroy_bmeter (&b[way]);
+	}
+	printf ("bench_meter: size %4d polled: old mean %.1f worst %.0f (%ld reads), %s mean %.1f worst %.0f (%ld reads)\n",
+		POLL_SIZE, mean[0], worst[0], reads[0], simd_name, mean[1], worst[1], reads[1]);
+	printf ("bench_meter: average and peak against the old loop: %s\n", fails ? "FAIL" : "PASS");
+	_aligned_free (in);
+	return fails ? 1 : 0;
+}
@@ -0,0 +1,188 @@
+/*  bench_rxa_pipeline.c
+
+This file is part of a program that implements a Software-Defined Radio.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+// Highest sustainable RXA input rate per mode over pipeline segments, run by 'make bench'.  A channel is
+// built as OpenChannel does on the DSP side, without the exchange thread, and xrxa is run on blocks of
+// 1024 samples at the 48 kHz DSP rate for a few heavy modes, serially and split by SetRXAPipeline into 2
+// to 4 segments.  For each split it gives the input rate the blocks actually ran at on this host, and from
+// GetRXAPipelineStats the rate it would sustain with a core per segment, block / slowest segment, against
+// block / sum of the segments for the serial chain.  The workers are left unpinned.  The output of each
+// split, shifted by its added latency, must be identical to the serial output, otherwise it fails.
+
+#include "../comm.h"
+
+#define DSP_SIZE		1024
+#define DSP_RATE		48000
+#define NCHECK			64
+#define MIN_TIME		0.5
+
+#define RUN_ANR			1
+#define RUN_ANF			2
+#define RUN_SNBA		4
+#define RUN_EMNR		8
+
+extern void SetRXASNBARun (int channel, int run);
+
+typedef struct _bmode
+{
+	const char* name;
+	int mode;
+	int runs;
+	int in_rate;
+} bmode;
+
+static const bmode modes[] =
+{
+	{ "USB",              RXA_USB, 0,                            384000 },
+	{ "USB+ANR+ANF+SNBA", RXA_USB, RUN_ANR | RUN_ANF | RUN_SNBA, 192000 },
+	{ "AM+EMNR",          RXA_AM,  RUN_EMNR,                     384000 }
+};
+
+#define NMODES			(int)(sizeof (modes) / sizeof (modes[0]))
+
+static double now (void)
+{
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + 1.0e-9 * (double)ts.tv_nsec;
+}
+
+static void create_channel (int channel, const bmode* m, int segments)
+{
+	ch[channel].in_rate = m->in_rate;
+	ch[channel].dsp_rate = DSP_RATE;
+	ch[channel].out_rate = DSP_RATE;
+	ch[channel].dsp_size = DSP_SIZE;
+	ch[channel].dsp_insize = DSP_SIZE * (m->in_rate / DSP_RATE);
+	ch[channel].dsp_outsize = DSP_SIZE;
+	InitializeCriticalSectionAndSpinCount (&ch[channel].csDSP, 2500);
+	InitializeCriticalSectionAndSpinCount (&ch[channel].csEXCH, 2500);
+	create_rxa (channel);
+	SetRXAMode (channel, m->mode);
+	if (m->runs & RUN_ANR)  SetRXAANRRun (channel, 1);
+	if (m->runs & RUN_ANF)  SetRXAANFRun (channel, 1);
+	if (m->runs & RUN_SNBA) SetRXASNBARun (channel, 1);
+	if (m->runs & RUN_EMNR) SetRXAEMNRRun (channel, 1);
+	SetRXAPipeline (channel, segments, -1);
+}
+
+static void destroy_channel (int channel)
+{
+	SetRXAPipeline (channel, 1, -1);
+	destroy_rxa (channel);
+	DeleteCriticalSection (&ch[channel].csEXCH);
+	DeleteCriticalSection (&ch[channel].csDSP);
+}
+
+// block n of a signal at -40 dBFS that keys on and off and jumps between two tones, in a little noise
+static void fill (double* buff, int n, int block, int rate, unsigned* seed)
+{
+	int i;
+	long k;
+	double amp, f, nz;
+	for (i = 0; i < n; i++)
+	{
+		k = (long)block * n + i;
+		amp = (k / (rate / 4)) % 3 == 0 ? 0.0 : 0.01;
+		f = (k / (rate / 2)) % 2 ? 13000.0 : 1000.0;
+		*seed = *seed * 1103515245u + 12345u;
+		nz = 1.0e-4 * ((double)((*seed >> 8) & 0xffff) / 65535.0 - 0.5);
+		buff[2 * i + 0] = amp * cos (TWOPI * f * k / rate) + nz;
+		buff[2 * i + 1] = amp * sin (TWOPI * f * k / rate) + nz;
+	}
+}
+
+int main ()
+{
+	int m, segs, b, i, nsegs, fails = 0;
+	unsigned seed;
+	long blocks;
+	double t0, t, bottleneck, total, ran, projected, serial;
+	double mean_us[MAX_PIPE_SEGS], max_us[MAX_PIPE_SEGS];
+	double *ref, *out;
+	SetThreadFlushDenormals (GetFlushDenormals ());
+	printf ("bench_rxa_pipeline: Msps of input, %d sample blocks at %d Hz DSP, as run on this host and projected "
+		"with a core per segment\n", DSP_SIZE, DSP_RATE);
+	for (m = 0; m < NMODES; m++)
+	{
+		// the serial output to check each split against
+		ref = (double *) malloc0 (NCHECK * DSP_SIZE * sizeof (complex));
+		create_channel (0, &modes[m], 1);
+		for (seed = 1, b = 0; b < NCHECK; b++)
+		{
+			fill (rxa[0].inbuff, ch[0].dsp_insize, b, modes[m].in_rate, &seed);
+			xrxa (0);
+			memcpy (ref + 2 * DSP_SIZE * b, rxa[0].outbuff, DSP_SIZE * sizeof (complex));
+		}
+		destroy_channel (0);
+		// a silent chain would pass whatever the split did
+		for (i = 0; i < 2 * NCHECK * DSP_SIZE && ref[i] == 0.0; i++);
+		if (i == 2 * NCHECK * DSP_SIZE)
+			fails++;
+		for (segs = 1; segs <= MAX_PIPE_SEGS; segs++)
+		{
+			create_channel (0, &modes[m], segs);
+			// segment s runs block n at step n + s, the output lags by segs - 1 blocks
+			for (seed = 1, b = 0; b < NCHECK; b++)
+			{
+				fill (rxa[0].inbuff, ch[0].dsp_insize, b, modes[m].in_rate, &seed);
+				xrxa (0);
+				if (b >= segs - 1)
+				{
+					out = ref + 2 * DSP_SIZE * (b - segs + 1);
+					for (i = 0; i < 2 * DSP_SIZE; i++)
+						if (rxa[0].outbuff[i] != out[i])
+							break;
+					if (i < 2 * DSP_SIZE)
+						fails++;
+				}
+			}
+			// timing from fresh segment statistics
+			SetRXAPipeline (0, segs, -1);
+			blocks = 0;
+			t0 = now ();
+			do
+			{
+				xrxa (0);
+				blocks++;
+				t = now ();
+			} while (t - t0 < MIN_TIME);
+			GetRXAPipelineStats (0, &nsegs, mean_us, max_us);
+			bottleneck = total = 0.0;
+			for (i = 0; i < nsegs; i++)
+			{
+				total += mean_us[i];
+				if (mean_us[i] > bottleneck) bottleneck = mean_us[i];
+			}
+			ran = (double)blocks * ch[0].dsp_insize / (t - t0) * 1.0e-6;
+			projected = (double)ch[0].dsp_insize / bottleneck;
+			serial = (double)ch[0].dsp_insize / total;
+			printf ("bench_rxa_pipeline: %-16s %3d kHz, %d segs: ran %6.2f, projected %6.2f (serial %6.2f), us per segment",
+				modes[m].name, modes[m].in_rate / 1000, segs, ran, projected, serial);
+			for (i = 0; i < nsegs; i++)
+				printf (" %.1f", mean_us[i]);
+			printf ("\n");
+			destroy_channel (0);
+		}
+		_aligned_free (ref);
+	}
+	printf ("bench_rxa_pipeline: split output against serial: %s\n", fails ? "FAIL" : "PASS");
+	return fails ? 1 : 0;
+}
@@ -0,0 +1,301 @@
+/*  bench_stft.c
+
+This file is part of a program that implements a Software-Defined Radio.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+// Overlap-add frames per second for CFCOMP and EMNR, run by 'make bench'.  Blocks of 64 samples of tones in
+// noise are run through each module at overlap 4 for fsize = 256 to 4096.  Each is timed three ways, best
+// of 3: the circular accumulators and saved frames xcfcomp/xemnr had before the STFT engine, copied here
+// as they were and driving the module's own frame function; the engine with the scalar window kernels;
+// and the engine with the kernels picked for this CPU.  simd.c is built in here so the bench can switch
+// kernels.  From flushed modules the engine's output must match the old to rounding, otherwise it fails.
+
+#include "../comm.h"
+#include "../simd.c"
+
+#define SIZE			64
+#define RATE			48000
+#define OVRLP			4
+#define MIN_FSIZE		256
+#define MAX_FSIZE		4096
+#define NBLOCKS			256
+#define MIN_TIME		0.1
+#define RUNS			3
+#define TOL				1.0e-9
+
+static double* in;
+static double* out;
+static double* ref;
+
+static double now (void)
+{
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + 1.0e-9 * (double)ts.tv_nsec;
+}
+
+static void use_kernels (int scalar)
+{
+	select_kernels ();
+	if (scalar)
+	{
+		rmul_fn = rmul_scalar;
+		rmac_fn = rmac_scalar;
+	}
+}
+
+// the overlap-add of xcfcomp before the STFT engine, its frame function reads forfftout and fills mask
+typedef struct _old_ola
+{
+	int bsize;
+	int fsize;
+	int ovrlp;
+	int incr;
+	int msize;
+	double* window;
+	double pregain;
+	double postgain;
+	int iasize;
+	double* inaccum;
+	int iainidx;
+	int iaoutidx;
+	int nsamps;
+	double* forfftin;
+	double* forfftout;
+	double* mask;
+	double* revfftin;
+	double* revfftout;
+	double** save;
+	int saveidx;
+	int oasize;
+	double* outaccum;
+	int oainidx;
+	int oaoutidx;
+	fftw_plan Rfor;
+	fftw_plan Rrev;
+	void (*frame) (void* arg);
+	void* arg;
+} old_ola, *OLD_OLA;
+
+// the module's window, gains, spectrum and mask, its own accumulators
+static OLD_OLA create_old_ola (STFT p, double* window, double pregain, double postgain, void (*frame) (void* arg), void* arg)
+{
+	int i;
+	OLD_OLA a = (OLD_OLA) malloc0 (sizeof (old_ola));
+	a->bsize = p->bsize;
+	a->fsize = p->fsize;
+	a->ovrlp = p->ovrlp;
+	a->incr = a->fsize / a->ovrlp;
+	a->msize = p->msize;
+	a->window = window;
+	a->pregain = pregain;
+	a->postgain = postgain;
+	if (a->fsize > a->bsize)
+		a->iasize = a->fsize;
+	else
+		a->iasize = a->bsize + a->fsize - a->incr;
+	if (a->fsize > a->bsize)
+	{
+		if (a->bsize > a->incr)  a->oasize = a->bsize;
+		else					 a->oasize = a->incr;
+		a->oainidx = (a->fsize - a->bsize - a->incr) % a->oasize;
+	}
+	else
+	{
+		a->oasize = a->bsize;
+		a->oainidx = a->fsize - a->incr;
+	}
+	a->inaccum   = (double *)malloc0 (a->iasize * sizeof(double));
+	a->forfftin  = (double *)malloc0 (a->fsize  * sizeof(double));
+	a->forfftout = p->forfftout;
+	a->mask      = p->mask;
+	a->revfftin  = (double *)malloc0 (a->msize  * sizeof(complex));
+	a->revfftout = (double *)malloc0 (a->fsize  * sizeof(double));
+	a->save      = (double **)malloc0(a->ovrlp  * sizeof(double *));
+	for (i = 0; i < a->ovrlp; i++)
+		a->save[i] = (double *)malloc0(a->fsize * sizeof(double));
+	a->outaccum = (double *)malloc0(a->oasize * sizeof(double));
+	a->Rfor = fftw_plan_dft_r2c_1d(a->fsize, a->forfftin, (fftw_complex *)a->forfftout, FFTW_ESTIMATE);
+	a->Rrev = fftw_plan_dft_c2r_1d(a->fsize, (fftw_complex *)a->revfftin, a->revfftout, FFTW_ESTIMATE);
+	a->frame = frame;
+	a->arg = arg;
+	return a;
+}
+
+static void destroy_old_ola (OLD_OLA a)
+{
+	int i;
+	fftw_destroy_plan (a->Rrev);
+	fftw_destroy_plan (a->Rfor);
+	_aligned_free (a->outaccum);
+	for (i = 0; i < a->ovrlp; i++)
+		_aligned_free (a->save[i]);
+	_aligned_free (a->save);
+	_aligned_free (a->revfftout);
+	_aligned_free (a->revfftin);
+	_aligned_free (a->forfftin);
+	_aligned_free (a->inaccum);
+	_aligned_free (a);
+}
+
+static void xold_ola (OLD_OLA a, double* in, double* out)
+{
+	int i, j, k, sbuff, sbegin;
+	for (i = 0; i < 2 * a->bsize; i += 2)
+	{
+		a->inaccum[a->iainidx] = in[i];
+		a->iainidx = (a->iainidx + 1) % a->iasize;
+	}
+	a->nsamps += a->bsize;
+	while (a->nsamps >= a->fsize)
+	{
+		for (i = 0, j = a->iaoutidx; i < a->fsize; i++, j = (j + 1) % a->iasize)
+			a->forfftin[i] = a->pregain * a->window[i] * a->inaccum[j];
+		a->iaoutidx = (a->iaoutidx + a->incr) % a->iasize;
+		a->nsamps -= a->incr;
+		fftw_execute (a->Rfor);
+		a->frame (a->arg);
+		for (i = 0; i < a->msize; i++)
+		{
+			a->revfftin[2 * i + 0] = a->mask[i] * a->forfftout[2 * i + 0];
+			a->revfftin[2 * i + 1] = a->mask[i] * a->forfftout[2 * i + 1];
+		}
+		fftw_execute (a->Rrev);
+		for (i = 0; i < a->fsize; i++)
+			a->save[a->saveidx][i] = a->postgain * a->window[i] * a->revfftout[i];
+		for (i = a->ovrlp; i > 0; i--)
+		{
+			sbuff = (a->saveidx + i) % a->ovrlp;
+			sbegin = a->incr * (a->ovrlp - i);
+			for (j = sbegin, k = a->oainidx; j < a->incr + sbegin; j++, k = (k + 1) % a->oasize)
+			{
+				if ( i == a->ovrlp)
+					a->outaccum[k]  = a->save[sbuff][j];
+				else
+					a->outaccum[k] += a->save[sbuff][j];
+			}
+		}
+		a->saveidx = (a->saveidx + 1) % a->ovrlp;
+		a->oainidx = (a->oainidx + a->incr) % a->oasize;
+	}
+	for (i = 0; i < a->bsize; i++)
+	{
+		out[2 * i + 0] = a->outaccum[a->oaoutidx];
+		out[2 * i + 1] = 0.0;
+		a->oaoutidx = (a->oaoutidx + 1) % a->oasize;
+	}
+}
+
+// one module, kind 0 CFCOMP or 1 EMNR, way 0 old, 1 engine scalar, 2 engine selected
+// runs blocks from the start of the input into out, for timing until MIN_TIME has passed, and returns frames/s
+static double run (int kind, int way, int fsize, int blocks, int timed)
+{
+	double F[5] = { 200.0, 1000.0, 2000.0, 3000.0, 4000.0 };
+	double G[5] = { 0.0, 5.0, 10.0, 10.0, 5.0 };
+	double E[5] = { 7.0, 7.0, 7.0, 7.0, 7.0 };
+	CFCOMP c = 0;
+	EMNR e = 0;
+	OLD_OLA o = 0;
+	long n = 0;
+	double t0, t;
+	double *x, *y;
+	if (kind == 0)
+	{
+		// the TXA settings other than the FFT size, running, post-equalizer on
+		c = create_cfcomp (1, 0, 1, SIZE, in, out, fsize, OVRLP, RATE, 1, 0, 5, 0.0, 0.0, F, G, E, 0.25);
+		if (way == 0) o = create_old_ola (c->p, c->window, c->pregain, c->postgain, calc_mask, c);
+	}
+	else
+	{
+		// the RXA settings other than the FFT size, running
+		e = create_emnr (1, 0, SIZE, in, out, fsize, OVRLP, RATE, 0, 1.0, 2, 0, 1);
+		if (way == 0) o = create_old_ola (e->stft, e->window, 1.0, e->gain, calc_gain, e);
+	}
+	use_kernels (way == 1);
+	t0 = now ();
+	do
+	{
+		x = in + 2 * SIZE * (n % NBLOCKS);
+		y = out + 2 * SIZE * (n % NBLOCKS);
+		if (way == 0)
+			xold_ola (o, x, y);
+		else if (kind == 0)
+		{
+			setBuffers_cfcomp (c, x, y);
+			xcfcomp (c, 0);
+		}
+		else
+		{
+			setBuffers_emnr (e, x, y);
+			xemnr (e, 0);
+		}
+		n++;
+		t = now ();
+	} while (timed ? t - t0 < MIN_TIME : n < blocks);
+	if (o) destroy_old_ola (o);
+	if (kind == 0) destroy_cfcomp (c);
+	else destroy_emnr (e);
+	return (double)n * SIZE / (fsize / OVRLP) / (t - t0);
+}
+
+int main ()
+{
+	int kind, fsize, i, r, fails = 0;
+	unsigned seed = 7;
+	double fps[3], t, err, ref_max, nz;
+	const char* names[2] = { "CFCOMP", "EMNR" };
+	in = (double *) malloc0 (NBLOCKS * SIZE * sizeof (complex));
+	out = (double *) malloc0 (NBLOCKS * SIZE * sizeof (complex));
+	ref = (double *) malloc0 (NBLOCKS * SIZE * sizeof (complex));
+	for (i = 0; i < NBLOCKS * SIZE; i++)
+	{
+		seed = seed * 1103515245u + 12345u;
+		nz = (double)((seed >> 8) & 0xffff) / 65535.0 - 0.5;
+		in[2 * i + 0] = 0.2 * sin (TWOPI * 700.0 * i / RATE) + 0.1 * sin (TWOPI * 1850.0 * i / RATE) + 0.05 * nz;
+	}
+	use_kernels (0);
+	printf ("bench_stft: frames/s in %d sample blocks, overlap %d, best of %d, old accumulators, scalar kernels, %s kernels\n",
+		SIZE, OVRLP, RUNS, simd_name);
+	for (kind = 0; kind < 2; kind++)
+		for (fsize = MIN_FSIZE; fsize <= MAX_FSIZE; fsize *= 2)
+		{
+			// the same input from flushed modules, old then engine
+			run (kind, 0, fsize, NBLOCKS, 0);
+			memcpy (ref, out, NBLOCKS * SIZE * sizeof (complex));
+			run (kind, 2, fsize, NBLOCKS, 0);
+			err = ref_max = 0.0;
+			for (i = 0; i < 2 * NBLOCKS * SIZE; i++)
+			{
+				if (fabs (ref[i]) > ref_max) ref_max = fabs (ref[i]);
+				if (fabs (out[i] - ref[i]) > err) err = fabs (out[i] - ref[i]);
+			}
+			if (ref_max == 0.0 || err > TOL * ref_max)
+				fails++;
+			// best of RUNS, the rest is other load
+			for (i = 0; i < 3; i++)
+				for (fps[i] = 0.0, r = 0; r < RUNS; r++)
+					if ((t = run (kind, i, fsize, 0, 1)) > fps[i])
+						fps[i] = t;
+			printf ("bench_stft: %-6s fsize %4d: old %8.0f scalar %8.0f %s %8.0f\n", names[kind], fsize, fps[0], fps[1], simd_name, fps[2]);
+		}
+	printf ("bench_stft: engine against old output: %s\n", fails ? "FAIL" : "PASS");
+	_aligned_free (ref);
+	_aligned_free (out);
+	_aligned_free (in);
+	return fails ? 1 : 0;
+}
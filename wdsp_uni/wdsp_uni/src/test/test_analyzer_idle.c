@@ -0,0 +1,129 @@
+/*  test_analyzer_idle.c
+
+This file is part of a program that implements a Software-Defined Radio.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+// Idle cost check for the analyzer dispatcher, run by 'make check'.  One display is set up as the server
+// sets up a panadapter, a 4096 point complex FFT at 48K fed 1024 samples at a time.  For the active phase
+// blocks are fed through Spectrum2 at the real rate and the pixel frames are read back with GetPixels.
+// Feeding then stops, which leaves the dispatcher thread running with nothing to do, and the process CPU
+// time and voluntary context switches are taken over the idle phase.  The old Sleep(1) poll cost about
+// 1% CPU and 1000 wakeups a second here, waiting on the dispatch event should cost next to nothing.
+
+#include "../comm.h"
+#include <sys/resource.h>
+
+#define DISP			0
+#define RATE			48000
+#define FFT_SIZE		4096
+#define IN_SZ			1024
+#define PIXELS			1024
+#define FRAME_RATE		15
+#define PHASE_MS		1000
+#define MAX_IDLE_CPU	0.5			// percent
+#define MAX_IDLE_WAKES	50			// voluntary context switches a second
+
+typedef struct _usage
+{
+	double cpu_s;
+	long nvcsw;
+	double wall_s;
+} usage;
+
+static double now (clockid_t clk)
+{
+	struct timespec ts;
+	clock_gettime (clk, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+}
+
+static void take (usage* u)
+{
+	struct rusage ru;
+	getrusage (RUSAGE_SELF, &ru);
+	u->nvcsw = ru.ru_nvcsw;
+	u->cpu_s = now (CLOCK_PROCESS_CPUTIME_ID);
+	u->wall_s = now (CLOCK_MONOTONIC);
+}
+
+static void sleep_until (double t)
+{
+	struct timespec ts;
+	ts.tv_sec = (time_t)t;
+	ts.tv_nsec = (long)((t - ts.tv_sec) * 1.0e9);
+	clock_nanosleep (CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+}
+
+static void open_display ()
+{
+	int success, flp[1] = { 0 };
+	int overlap = (int)max (0.0, ceil (FFT_SIZE - (double)RATE / FRAME_RATE));
+	int clp = (int)floor (0.17 * FFT_SIZE);
+	int max_w = FFT_SIZE + (int)min (0.1 * RATE, 0.1 * FFT_SIZE * FRAME_RATE);
+	XCreateAnalyzer (DISP, &success, FFT_SIZE, 1, 1, NULL);
+	SetAnalyzer (DISP, 1, 1, 1, flp, FFT_SIZE, IN_SZ, 4, 14.0, overlap, clp, 0, 0, PIXELS, 1, 0, 0.0, 0.0, max_w);
+}
+
+int main ()
+{
+	int i, b, blocks, flag, frames = 0, pass;
+	long n = 0;
+	double t, ph = 0.0, idle_cpu, idle_wakes, active_cpu;
+	double* iq = (double *) malloc0 (IN_SZ * sizeof (complex));
+	dOUTREAL* pix = (dOUTREAL *) malloc0 (PIXELS * sizeof (dOUTREAL));
+	usage u0, u1, u2;
+
+	open_display ();
+
+	// active, blocks at the rate the receiver would deliver them
+	blocks = (int)((double)PHASE_MS * RATE / 1000.0 / IN_SZ);
+	take (&u0);
+	t = u0.wall_s;
+	for (b = 0; b < blocks; b++)
+	{
+		for (i = 0; i < IN_SZ; i++, n++)
+		{
+			ph += 2.0 * PI * 3000.0 / RATE;
+			iq[2 * i + 0] = 0.1 * cos (ph) + 1.0e-4 * sin (n * 0.7);
+			iq[2 * i + 1] = 0.1 * sin (ph) + 1.0e-4 * cos (n * 1.3);
+		}
+		Spectrum2 (1, DISP, 0, 0, iq);
+		GetPixels (DISP, 0, pix, &flag);
+		frames += flag;
+		t += (double)IN_SZ / RATE;
+		sleep_until (t);
+	}
+	take (&u1);
+
+	// idle, the dispatcher has been started and is left with nothing to do
+	sleep_until (u1.wall_s + PHASE_MS * 1.0e-3);
+	take (&u2);
+	GetPixels (DISP, 0, pix, &flag);
+	frames += flag;
+	DestroyAnalyzer (DISP);
+
+	active_cpu = 100.0 * (u1.cpu_s - u0.cpu_s) / (u1.wall_s - u0.wall_s);
+	idle_cpu = 100.0 * (u2.cpu_s - u1.cpu_s) / (u2.wall_s - u1.wall_s);
+	idle_wakes = (u2.nvcsw - u1.nvcsw) / (u2.wall_s - u1.wall_s);
+	pass = frames > 0 && idle_cpu <= MAX_IDLE_CPU && idle_wakes <= MAX_IDLE_WAKES;
+	printf ("test_analyzer_idle: active %.2f%% CPU, %d frames; idle %.2f%% CPU, %.0f wakeups/s: %s\n",
+		active_cpu, frames, idle_cpu, idle_wakes, pass ? "PASS" : "FAIL");
+	_aligned_free (pix);
+	_aligned_free (iq);
+	return pass ? 0 : 1;
+}
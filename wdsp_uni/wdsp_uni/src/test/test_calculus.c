@@ -0,0 +1,75 @@
+/*  test_calculus.c
+
+This file is part of a program that implements a Software-Defined Radio.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+// Tolerance test for the EMNR gain tables, run by 'make check'.  GG and GGS are kept in single precision;
+// calculus_golden.txt holds every 131st entry of the computed double tables they were rounded from, as
+// row, column, GG and GGS with the original 25 digits.  Each table entry must be within half a float ulp
+// of its computed value.  getKey() interpolates between four entries with weights summing to one, so
+// the gains EMNR uses are no further off than the entries.
+
+#include "../comm.h"
+#include "../calculus.h"
+
+#define REL_TOL		5.97e-8		// 2^-24, rounding to float
+#define MIN_LINES	440
+
+static int close_to (float x, double ref)
+{
+	return fabs ((double)x - ref) <= REL_TOL * fabs (ref);
+}
+
+int main (int argc, char** argv)
+{
+	int row, col, k, fails = 0, lines = 0;
+	double gg, ggs, err, maxerr = 0.0;
+	FILE* f;
+	const char* path = argc > 1 ? argv[1] : "test/calculus_golden.txt";
+	if ((f = fopen (path, "r")) == NULL)
+	{
+		fprintf (stderr, "test_calculus: cannot open %s\n", path);
+		return 2;
+	}
+	while (fscanf (f, "%d %d %lf %lf", &row, &col, &gg, &ggs) == 4)
+	{
+		if (row < 0 || row >= CALCULUS_SIZE || col < 0 || col >= CALCULUS_SIZE)
+		{
+			fprintf (stderr, "test_calculus: %s has an entry off the table at line %d\n", path, lines + 1);
+			fclose (f);
+			return 2;
+		}
+		k = CALCULUS_SIZE * row + col;
+		if (!close_to (GG[k], gg) || !close_to (GGS[k], ggs))
+		{
+			printf ("row %d column %d: GG %.9g expected %.17g, GGS %.9g expected %.17g\n", row, col, GG[k], gg, GGS[k], ggs);
+			fails++;
+		}
+		if (gg != 0.0 && (err = fabs (GG[k] - gg) / gg) > maxerr) maxerr = err;
+		if (ggs != 0.0 && (err = fabs (GGS[k] - ggs) / ggs) > maxerr) maxerr = err;
+		lines++;
+	}
+	fclose (f);
+	if (lines < MIN_LINES)
+	{
+		fprintf (stderr, "test_calculus: %s is short, %d entries\n", path, lines);
+		return 2;
+	}
+	printf ("test_calculus: %d entries of each table, max relative error %.3g, %d differ: %s\n", lines, maxerr, fails, fails ? "FAIL" : "PASS");
+	return fails ? 1 : 0;
+}
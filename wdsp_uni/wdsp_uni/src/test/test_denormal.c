@@ -0,0 +1,128 @@
+/*  test_denormal.c
+
+This file is part of a program that implements a Software-Defined Radio.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+// Denormal stress test, run by 'make check'.  A four stage SPEAK biquad cascade and the ANR LMS filter
+// are fed noise, then the noise decays by 40 dB a block into silence so their state decays through the
+// denormal range, then the noise comes back.  The chain runs once with denormals flushed to zero, as
+// the channel threads run it, and once without.  Flushed, the silent blocks must cost no more than
+// MAX_RATIO times the loud ones, and every output sample must be within MAX_DIFF of the unflushed run.
+// Flushing only drops values at the bottom of the double range; the filter gain lifts them a little
+// above DBL_MIN but nowhere near anything a 24 bit path can see.
+// The unflushed slowdown is printed for comparison but not checked as it depends on the CPU.
+
+#include "../comm.h"
+
+#define SIZE		1024
+#define RATE		48000
+#define LOUD		50
+#define QUIET		600
+#define AGAIN		50
+#define BLOCKS		(LOUD + QUIET + AGAIN)
+#define SETTLE		10
+#define MAX_RATIO	3.0
+#define MAX_DIFF	1.0e-300
+
+typedef struct _timing
+{
+	double loud_us;				// mean cost of a loud block
+	double quiet_us;			// mean cost of a silent block
+} timing;
+
+static double noise (unsigned* seed)
+{
+	*seed = *seed * 1103515245u + 12345u;
+	return (double)((*seed >> 8) & 0xffff) / 65535.0 - 0.5;
+}
+
+static double cpu_us (void)
+{
+	struct timespec ts;
+	clock_gettime (CLOCK_THREAD_CPUTIME_ID, &ts);
+	return 1.0e6 * (double)ts.tv_sec + 1.0e-3 * (double)ts.tv_nsec;
+}
+
+static void run (int flush, double* out, timing* t)
+{
+	int b, i, nloud = 0, nquiet = 0;
+	unsigned seed = 1;
+	double amp, t0, us;
+	double* buff = (double *) malloc0 (SIZE * sizeof (complex));
+	SPEAK s = create_speak (1, SIZE, buff, buff, RATE, 600.0, 100.0, 2.0, 4, 1);
+	ANR a = create_anr (1, 0, SIZE, buff, buff, ANR_DLINE_SIZE, 64, 16, 0.0001, 0.1,
+		120.0, 120.0, 200.0, 0.001, 6.25e-10, 1.0, 3.0);
+	SetThreadFlushDenormals (flush);
+	t->loud_us = t->quiet_us = 0.0;
+	for (b = 0; b < BLOCKS; b++)
+	{
+		if (b >= LOUD && b < LOUD + QUIET)
+			amp = b < LOUD + 10 ? 0.3 * pow (0.01, b - LOUD + 1) : 0.0;
+		else
+			amp = 0.3;
+		for (i = 0; i < SIZE; i++)
+		{
+			buff[2 * i + 0] = amp * noise (&seed);
+			buff[2 * i + 1] = amp * noise (&seed);
+		}
+		t0 = cpu_us ();
+		xspeak (s);
+		xanr (a, 0);
+		us = cpu_us () - t0;
+		if (b >= SETTLE && b < LOUD)
+		{
+			t->loud_us += us;
+			nloud++;
+		}
+		else if (b >= LOUD + SETTLE && b < LOUD + QUIET)
+		{
+			t->quiet_us += us;
+			nquiet++;
+		}
+		memcpy (out + 2 * SIZE * b, buff, SIZE * sizeof (complex));
+	}
+	SetThreadFlushDenormals (0);
+	t->loud_us /= nloud;
+	t->quiet_us /= nquiet;
+	destroy_anr (a);
+	destroy_speak (s);
+	_aligned_free (buff);
+}
+
+int main (void)
+{
+	int i, n = 2 * SIZE * BLOCKS, pass;
+	double d, maxdiff = 0.0, maxtail = 0.0;
+	double* on = (double *) malloc0 (n * sizeof (double));
+	double* off = (double *) malloc0 (n * sizeof (double));
+	timing ton, toff;
+	run (0, off, &toff);
+	run (1, on, &ton);
+	for (i = 0; i < n; i++)
+	{
+		d = fabs (on[i] - off[i]);
+		if (d > maxdiff) maxdiff = d;
+		if (i >= 2 * SIZE * (LOUD + QUIET) && d > maxtail) maxtail = d;
+	}
+	pass = ton.quiet_us <= MAX_RATIO * ton.loud_us && maxdiff <= MAX_DIFF;
+	printf ("test_denormal: flushed %.1f/%.1f us loud/silent, not flushed %.1f/%.1f us, max output difference %.3g, %.3g once the noise is back: %s\n",
+		ton.loud_us, ton.quiet_us, toff.loud_us, toff.quiet_us, maxdiff, maxtail, pass ? "PASS" : "FAIL");
+	_aligned_free (off);
+	_aligned_free (on);
+	return pass ? 0 : 1;
+}
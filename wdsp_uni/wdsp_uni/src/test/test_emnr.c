@@ -0,0 +1,193 @@
+/*  test_emnr.c
+
+This file is part of a program that implements a Software-Defined Radio.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+// Shortened soak and golden output test for the EMNR, run by 'make check'.  Synthetic SSB, syllables of
+// three tones in noise with gaps of digital silence, goes through xemnr for every gain and noise estimate
+// method and block sizes from 64 to 8192.  No output may be NaN.  For each 0.1 s of output the first
+// sample, the energy and the peak are checked against emnr_golden.txt, which was made with the EMNR as
+// it was before the mask-indexed rings, the split gain table lookup and the single precision tables.
+// The tables move the samples of gain method 2 by up to 2e-9 on a 0.1 signal, well inside the tolerance.
+// 'test_emnr -g file' writes a new golden file instead.
+
+#include "../comm.h"
+
+#define RATE		48000
+#define SECONDS		6
+#define REL_TOL		1.0e-6
+#define ABS_TOL		1.0e-10
+
+typedef struct _emnrcfg
+{
+	int bs;
+	int gain_method;
+	int npe_method;
+	int ae_run;
+} emnrcfg;
+
+static const emnrcfg cfgs[] =
+{
+	{   64, 2, 0, 1 },
+	{ 1024, 2, 0, 1 },
+	{ 4096, 2, 1, 1 },
+	{ 8192, 2, 0, 0 },
+	{ 1024, 0, 0, 1 },
+	{  256, 0, 1, 0 },
+	{ 1024, 1, 1, 1 },
+	{  512, 1, 0, 0 }
+};
+
+#define NCFGS		(int)(sizeof (cfgs) / sizeof (cfgs[0]))
+#define NCHUNKS		(SECONDS * 10)
+
+typedef struct _chunk
+{
+	double i0, q0;				// first output sample of the chunk
+	double energy;				// sum of I*I + Q*Q over the chunk
+	double peak;				// largest |I| or |Q| in the chunk
+} chunk;
+
+static unsigned lcg (unsigned* seed)
+{
+	*seed = *seed * 1103515245u + 12345u;
+	return (*seed >> 8) & 0xffff;
+}
+
+static void stimulus (double* buff, int bs, long n0, unsigned* seed)
+{
+	int i;
+	long n;
+	double sec, syl, env, s, nz;
+	for (i = 0; i < bs; i++)
+	{
+		n = n0 + i;
+		sec = (double)n / (double)RATE;
+		// a second of silence in every three
+		if (fmod (sec, 3.0) >= 2.0)
+		{
+			buff[2 * i + 0] = buff[2 * i + 1] = 0.0;
+			continue;
+		}
+		// syllables of about 0.2 s
+		syl = fmod (sec, 0.23);
+		env = syl < 0.17 ? sin (PI * syl / 0.17) : 0.0;
+		s = 0.1 * env * (sin (2.0 * PI * 440.0 * sec) + 0.6 * sin (2.0 * PI * 1210.0 * sec) + 0.3 * sin (2.0 * PI * 2330.0 * sec));
+		nz = 0.01 * ((double)lcg (seed) / 65535.0 - 0.5);
+		buff[2 * i + 0] = s + nz;
+		buff[2 * i + 1] = 0.01 * ((double)lcg (seed) / 65535.0 - 0.5);
+	}
+}
+
+static int run_cfg (const emnrcfg* c, chunk* out)
+{
+	int i, k, nans = 0;
+	long b, n, blocks;
+	unsigned seed = 11;
+	double I, Q;
+	int chunk_len = RATE / 10;
+	double* buff = (double *) malloc0 (c->bs * sizeof (complex));
+	EMNR a = create_emnr (1, 0, c->bs, buff, buff, 4096, 4, RATE, 0, 1.0, c->gain_method, c->npe_method, c->ae_run);
+	memset (out, 0, NCHUNKS * sizeof (chunk));
+	blocks = ((long)SECONDS * RATE + c->bs - 1) / c->bs;
+	for (b = 0; b < blocks; b++)
+	{
+		stimulus (buff, c->bs, b * c->bs, &seed);
+		xemnr (a, 0);
+		for (i = 0; i < c->bs; i++)
+		{
+			n = b * c->bs + i;
+			k = (int)(n / chunk_len);
+			if (k >= NCHUNKS)
+				break;
+			I = buff[2 * i + 0];
+			Q = buff[2 * i + 1];
+			if (I != I || Q != Q)
+				nans++;
+			if (n % chunk_len == 0)
+			{
+				out[k].i0 = I;
+				out[k].q0 = Q;
+			}
+			out[k].energy += I * I + Q * Q;
+			if (fabs (I) > out[k].peak) out[k].peak = fabs (I);
+			if (fabs (Q) > out[k].peak) out[k].peak = fabs (Q);
+		}
+	}
+	destroy_emnr (a);
+	_aligned_free (buff);
+	return nans;
+}
+
+static int close_to (double x, double ref)
+{
+	return fabs (x - ref) <= ABS_TOL + REL_TOL * fabs (ref);
+}
+
+int main (int argc, char** argv)
+{
+	int c, k, kc, kk, nans, fails = 0, lines = 0;
+	chunk res[NCHUNKS], ref;
+	FILE* f;
+	int generate = argc > 2 && strcmp (argv[1], "-g") == 0;
+	const char* path = generate ? argv[2] : (argc > 1 ? argv[1] : "test/emnr_golden.txt");
+	if ((f = fopen (path, generate ? "w" : "r")) == NULL)
+	{
+		fprintf (stderr, "test_emnr: cannot open %s\n", path);
+		return 2;
+	}
+	for (c = 0; c < NCFGS; c++)
+	{
+		if ((nans = run_cfg (&cfgs[c], res)) != 0)
+		{
+			printf ("config %d (bs %d gain %d npe %d ae %d): %d NaN outputs\n",
+				c, cfgs[c].bs, cfgs[c].gain_method, cfgs[c].npe_method, cfgs[c].ae_run, nans);
+			fails++;
+		}
+		for (k = 0; k < NCHUNKS; k++)
+		{
+			if (generate)
+			{
+				fprintf (f, "%d %d %.17g %.17g %.17g %.17g\n", c, k, res[k].i0, res[k].q0, res[k].energy, res[k].peak);
+				continue;
+			}
+			if (fscanf (f, "%d %d %lf %lf %lf %lf", &kc, &kk, &ref.i0, &ref.q0, &ref.energy, &ref.peak) != 6 || kc != c || kk != k)
+			{
+				fprintf (stderr, "test_emnr: %s is short or out of order at config %d chunk %d\n", path, c, k);
+				fclose (f);
+				return 2;
+			}
+			lines++;
+			if (!close_to (res[k].i0, ref.i0) || !close_to (res[k].q0, ref.q0)
+				|| !close_to (res[k].energy, ref.energy) || !close_to (res[k].peak, ref.peak))
+			{
+				if (fails++ < 10)
+					printf ("config %d (bs %d gain %d npe %d ae %d) chunk %d: energy %.17g expected %.17g, peak %.17g expected %.17g\n",
+						c, cfgs[c].bs, cfgs[c].gain_method, cfgs[c].npe_method, cfgs[c].ae_run, k, res[k].energy, ref.energy, res[k].peak, ref.peak);
+			}
+		}
+	}
+	fclose (f);
+	if (generate)
+	{
+		printf ("test_emnr: wrote %s\n", path);
+		return fails ? 1 : 0;
+	}
+	printf ("test_emnr: %d configs, %d chunks, %d differ: %s\n", NCFGS, lines, fails, fails ? "FAIL" : "PASS");
+	return fails ? 1 : 0;
+}
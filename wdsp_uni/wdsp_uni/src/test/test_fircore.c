@@ -0,0 +1,149 @@
+/*  test_fircore.c
+
+This file is part of a program that implements a Software-Defined Radio.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+// Filter change test for the FIRCORE mask hand-off, run by 'make check'.  One thread runs xfircore block
+// after block while another publishes new masks as fast as it can, alternating between two impulse
+// responses.  A block claims one mask set for all its partitions, so each output block must match that of
+// a core that only ever has the first response or of one that only ever has the second, both fed the same
+// input; a block computed from a set that was being rewritten matches neither.  Once the writer stops on
+// the second response every block must match the second.  A watchdog fails the test if either thread
+// never gets off a mask set.
+
+#include <signal.h>
+#include "../comm.h"
+
+#define SIZE		256
+#define NC			4096
+#define BLOCKS		20000
+#define TAIL		64
+#define TOL			1.0e-9
+#define WATCHDOG	120
+
+static double *in, *out, *impA, *impB;
+static FIRCORE a;
+static volatile long stop;
+static long updates;
+
+static void* writer (void* arg)
+{
+	long n = 0;
+	while (!_InterlockedAnd (&stop, 1))
+	{
+		setImpulse_fircore (a, (n & 1) ? impB : impA, 1);
+		n++;
+	}
+	setImpulse_fircore (a, impB, 1);
+	updates = n;
+	return 0;
+}
+
+static void fill (unsigned* seed)
+{
+	int i;
+	for (i = 0; i < 2 * SIZE; i++)
+	{
+		*seed = *seed * 1103515245u + 12345u;
+		in[i] = (double)((*seed >> 8) & 0xffff) / 65535.0 - 0.5;
+	}
+}
+
+static double block_time (void)
+{
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + 1.0e-9 * (double)ts.tv_nsec;
+}
+
+static void expired (int sig)
+{
+	printf ("test_fircore: no progress after %d s: FAIL\n", WATCHDOG);
+	_exit (1);
+}
+
+static double maxdiff (double* x, double* y)
+{
+	int i;
+	double d = 0.0;
+	for (i = 0; i < 2 * SIZE; i++)
+		if (!(fabs (x[i] - y[i]) <= d))
+			d = isfinite (x[i]) ? fabs (x[i] - y[i]) : INFINITY;
+	return d;
+}
+
+int main (int argc, char** argv)
+{
+	int b, torn = 0, wrong = 0;
+	unsigned seed = 7;
+	double t0, t, worst = 0.0;
+	double period = (double)SIZE / 48000.0;
+	double *outA, *outB;
+	FIRCORE ra, rb;
+	pthread_t th;
+	signal (SIGALRM, expired);
+	alarm (WATCHDOG);
+	// the core writes the whole 2 * SIZE inverse FFT to out and the caller keeps the first SIZE
+	in   = (double *) malloc0 (SIZE * sizeof (complex));
+	out  = (double *) malloc0 (2 * SIZE * sizeof (complex));
+	outA = (double *) malloc0 (2 * SIZE * sizeof (complex));
+	outB = (double *) malloc0 (2 * SIZE * sizeof (complex));
+	impA = (double *) malloc0 (NC * sizeof (complex));
+	impB = (double *) malloc0 (NC * sizeof (complex));
+	for (b = 0; b < 2 * NC; b++)
+	{
+		impA[b] = ((double)(b * 7919 % 1000) / 1000.0 - 0.5) / NC * 8.0;
+		impB[b] = ((double)(b * 104729 % 1000) / 1000.0 - 0.5) / NC * 8.0;
+	}
+	a  = create_fircore (SIZE, in, out,  NC, 0, impA);
+	ra = create_fircore (SIZE, in, outA, NC, 0, impA);
+	rb = create_fircore (SIZE, in, outB, NC, 0, impB);
+	pthread_create (&th, 0, writer, 0);
+	for (b = 0; b < BLOCKS; b++)
+	{
+		fill (&seed);
+		t0 = block_time ();
+		xfircore (a);
+		t = block_time () - t0;
+		if (t > worst)
+			worst = t;
+		xfircore (ra);
+		xfircore (rb);
+		if (maxdiff (out, outA) > TOL && maxdiff (out, outB) > TOL)
+			torn++;
+		// leave the writer some of the CPU on a single core machine
+		if ((b & 7) == 0)
+			sched_yield ();
+	}
+	InterlockedBitTestAndSet (&stop, 0);
+	pthread_join (th, 0);
+	for (b = 0; b < TAIL; b++)
+	{
+		fill (&seed);
+		xfircore (a);
+		xfircore (rb);
+		if (maxdiff (out, outB) > TOL)
+			wrong++;
+	}
+	destroy_fircore (rb);
+	destroy_fircore (ra);
+	destroy_fircore (a);
+	printf ("test_fircore: %ld filter changes over %d blocks, worst block %.0f us of %.0f us, %d blocks matching neither filter, %d wrong after the last change: %s\n",
+		updates, BLOCKS, worst * 1.0e6, period * 1.0e6, torn, wrong, (updates > 0 && torn == 0 && wrong == 0) ? "PASS" : "FAIL");
+	return (updates > 0 && torn == 0 && wrong == 0) ? 0 : 1;
+}
@@ -0,0 +1,154 @@
+/*  test_resample.c
+
+This file is part of a program that implements a Software-Defined Radio.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+// Regression test for the resampler, run by 'make check'.  xresample() reads each phase from a mirrored
+// history through cdotr(); old_xresample() below is the ring-wrapping scalar loop it replaced, run on a
+// second resampler made alike.  The rate pairs cover pure decimation (L == 1) and the polyphase path
+// (L > 1).  Both are fed the same tones and noise in blocks of random size and must give the same number
+// of outputs, every one within TOL of the old value.
+
+#include "../comm.h"
+
+#define MAXSIZE		1024
+#define BLOCKS		64
+#define TOL			1.0e-12
+
+typedef struct _ratepair
+{
+	int in_rate;
+	int out_rate;
+} ratepair;
+
+static const ratepair pairs[] =
+{
+	{ 384000,  48000 },
+	{ 192000,  48000 },
+	{  96000,  48000 },
+	{  48000,  48000 },
+	{  48000, 192000 },
+	{  48000, 384000 },
+	{  44100,  48000 },
+	{  48000,   8000 }
+};
+
+#define NPAIRS		(int)(sizeof (pairs) / sizeof (pairs[0]))
+
+static unsigned rnd (unsigned* seed)
+{
+	*seed = *seed * 1103515245u + 12345u;
+	return (*seed >> 8) & 0xffff;
+}
+
+// xresample() as it was, the history is the first ringsize pairs of the ring and wraps on every tap
+static int old_xresample (RESAMPLE a)
+{
+	int outsamps = 0;
+	int i, j, n;
+	int idx_out;
+	double I, Q;
+
+	for (i = 0; i < a->size; i++)
+	{
+		a->ring[2 * a->idx_in + 0] = a->in[2 * i + 0];
+		a->ring[2 * a->idx_in + 1] = a->in[2 * i + 1];
+		while (a->phnum < a->L)
+		{
+			I = 0.0;
+			Q = 0.0;
+			n = a->cpp * a->phnum;
+			for (j = 0; j < a->cpp; j++)
+			{
+				if ((idx_out = a->idx_in + j) >= a->ringsize) idx_out -= a->ringsize;
+				I += a->h[n + j] * a->ring[2 * idx_out + 0];
+				Q += a->h[n + j] * a->ring[2 * idx_out + 1];
+			}
+			a->out[2 * outsamps + 0] = I;
+			a->out[2 * outsamps + 1] = Q;
+			outsamps++;
+			a->phnum += a->M;
+		}
+		a->phnum -= a->L;
+		if (--a->idx_in < 0) a->idx_in = a->ringsize - 1;
+	}
+	return outsamps;
+}
+
+int main (void)
+{
+	int p, b, i, n, nnew, nold, total, fails = 0;
+	unsigned seed = 1;
+	long t;
+	double w, err, maxerr, peak;
+	double *in, *outnew, *outold;
+	RESAMPLE anew, aold;
+
+	in = (double *)malloc0 (MAXSIZE * sizeof (complex));
+	for (p = 0; p < NPAIRS; p++)
+	{
+		// at most 8 outputs per input, for 48k -> 384k
+		outnew = (double *)malloc0 ((MAXSIZE * 8 + 2) * sizeof (complex));
+		outold = (double *)malloc0 ((MAXSIZE * 8 + 2) * sizeof (complex));
+		anew = create_resample (1, MAXSIZE, in, outnew, pairs[p].in_rate, pairs[p].out_rate, 0.0, 0, 1.0);
+		aold = create_resample (1, MAXSIZE, in, outold, pairs[p].in_rate, pairs[p].out_rate, 0.0, 0, 1.0);
+		w = 2.0 * PI * 1000.0 / pairs[p].in_rate;
+		t = 0;
+		total = 0;
+		maxerr = peak = 0.0;
+		for (b = 0; b < BLOCKS; b++)
+		{
+			n = 1 + rnd (&seed) % MAXSIZE;
+			for (i = 0; i < n; i++, t++)
+			{
+				in[2 * i + 0] = 0.5 * cos (w * t) + 0.1 * cos (7.3 * w * t) + 1.0e-3 * ((double)rnd (&seed) / 65535.0 - 0.5);
+				in[2 * i + 1] = 0.5 * sin (w * t) - 0.1 * sin (7.3 * w * t) + 1.0e-3 * ((double)rnd (&seed) / 65535.0 - 0.5);
+			}
+			// setSize_resample() would flush the history
+			anew->size = aold->size = n;
+			nnew = xresample (anew);
+			nold = old_xresample (aold);
+			if (nnew != nold)
+			{
+				printf ("%d -> %d block %d: %d outputs, expected %d\n", pairs[p].in_rate, pairs[p].out_rate, b, nnew, nold);
+				fails++;
+				break;
+			}
+			for (i = 0; i < 2 * nold; i++)
+			{
+				if ((err = fabs (outnew[i] - outold[i])) > maxerr) maxerr = err;
+				if (fabs (outold[i]) > peak) peak = fabs (outold[i]);
+			}
+			total += nold;
+		}
+		if (maxerr > TOL)
+		{
+			printf ("%d -> %d: error %.3g\n", pairs[p].in_rate, pairs[p].out_rate, maxerr);
+			fails++;
+		}
+		printf ("test_resample: %d -> %d (L %d M %d), %d outputs, peak %.3f, max error %.3g\n",
+			pairs[p].in_rate, pairs[p].out_rate, anew->L, anew->M, total, peak, maxerr);
+		destroy_resample (aold);
+		destroy_resample (anew);
+		_aligned_free (outold);
+		_aligned_free (outnew);
+	}
+	_aligned_free (in);
+	printf ("test_resample: %d rate pairs, %d fail: %s\n", NPAIRS, fails, fails ? "FAIL" : "PASS");
+	return fails ? 1 : 0;
+}
@@ -0,0 +1,197 @@
+/*  test_wcpagc.c
+
+This file is part of a program that implements a Software-Defined Radio.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+*/
+
+// Golden output test for the WCPAGC, run by 'make check'.  The AGC is driven through decaying, silent,
+// faint, impulsive, modulated and steady envelopes, with the parameters reloaded a third of the way in
+// and a flush at two thirds.  For each 0.1 s of output the first sample, the energy and the peak are
+// checked against wcpagc_golden.txt, which was made with the attack-window rescan the deque replaced.
+// 'test_wcpagc -g file' writes a new golden file instead.
+
+#include "../comm.h"
+
+#define SECONDS		4
+#define REL_TOL		1.0e-9
+#define ABS_TOL		1.0e-12
+
+typedef struct _agccfg
+{
+	int bs;
+	int rate;
+	int pmode;
+	int hang;
+	int n_tau;
+	double tau_attack;
+} agccfg;
+
+static const agccfg cfgs[] =
+{
+	{   64,  48000, 1, 0, 4, 0.001 },
+	{ 1000,  48000, 0, 1, 4, 0.002 },
+	{ 4096,  48000, 1, 1, 6, 0.001 },
+	{ 1000,  48000, 1, 1, 6, 0.002 },
+	{   64, 192000, 0, 0, 6, 0.002 },
+	{ 1000, 192000, 1, 0, 4, 0.002 },
+	{ 4096, 192000, 0, 1, 4, 0.001 },
+	{   64, 192000, 1, 1, 4, 0.001 }
+};
+
+#define NCFGS		(int)(sizeof (cfgs) / sizeof (cfgs[0]))
+#define NCHUNKS		(SECONDS * 10)
+
+typedef struct _chunk
+{
+	double i0, q0;				// first output sample of the chunk
+	double energy;				// sum of I*I + Q*Q over the chunk
+	double peak;				// largest |I| or |Q| in the chunk
+} chunk;
+
+static unsigned lcg (unsigned* seed)
+{
+	*seed = *seed * 1103515245u + 12345u;
+	return (*seed >> 8) & 0xffff;
+}
+
+static void stimulus (double* buff, int bs, long n0, int rate, unsigned* seed, double* ph)
+{
+	int i, seg;
+	long n;
+	double sec, amp, nz;
+	for (i = 0; i < bs; i++)
+	{
+		n = n0 + i;
+		sec = (double)n / (double)rate;
+		seg = (int)(sec * 4.0) % 7;
+		switch (seg)
+		{
+		case 0:  amp = 0.3 * exp (-fmod (sec, 0.25) * 20.0); break;
+		case 1:  amp = 0.0; break;
+		case 2:  amp = 1.0e-4; break;
+		case 3:  amp = (n % 977 == 0) ? 0.9 : 1.0e-3; break;
+		case 4:  amp = 0.05 * (1.0 + sin (sec * 30.0)); break;
+		case 5:  amp = 0.8; break;
+		default: amp = 1.0e-6; break;
+		}
+		nz = ((double)lcg (seed) / 65535.0 - 0.5) * amp * 0.2;
+		*ph += 0.05 + 0.01 * seg;
+		buff[2 * i + 0] = amp * cos (*ph) + nz;
+		buff[2 * i + 1] = amp * sin (*ph) - nz;
+		if (seg == 3 && n % 5 == 0)
+			buff[2 * i + 1] = -buff[2 * i + 0];
+	}
+}
+
+static void run_cfg (const agccfg* c, chunk* out)
+{
+	int i, k;
+	long b, n, blocks;
+	unsigned seed = 7;
+	double ph = 0.0, I, Q;
+	int chunk_len = c->rate / 10;
+	double* buff = (double *) malloc0 (c->bs * sizeof (complex));
+	WCPAGC a = create_wcpagc (1, 3, c->pmode, buff, buff, c->bs, c->rate, c->tau_attack, 0.250, c->n_tau,
+		10000.0, 1.5, 1000.0, 1.0, 1.0, 0.250, 0.005, 5.0, c->hang, 0.5, 0.25, 0.25, 0.1);
+	memset (out, 0, NCHUNKS * sizeof (chunk));
+	blocks = (long)SECONDS * c->rate / c->bs;
+	for (b = 0; b < blocks; b++)
+	{
+		stimulus (buff, c->bs, b * c->bs, c->rate, &seed, &ph);
+		if (b == blocks / 3)
+		{
+			a->tau_decay = 0.5;
+			a->hang_enable = !c->hang;
+			loadWcpAGC (a);
+		}
+		if (b == (2 * blocks) / 3)
+			flush_wcpagc (a);
+		xwcpagc (a);
+		for (i = 0; i < c->bs; i++)
+		{
+			n = b * c->bs + i;
+			k = (int)(n / chunk_len);
+			if (k >= NCHUNKS)
+				break;
+			I = buff[2 * i + 0];
+			Q = buff[2 * i + 1];
+			if (n % chunk_len == 0)
+			{
+				out[k].i0 = I;
+				out[k].q0 = Q;
+			}
+			out[k].energy += I * I + Q * Q;
+			if (fabs (I) > out[k].peak) out[k].peak = fabs (I);
+			if (fabs (Q) > out[k].peak) out[k].peak = fabs (Q);
+		}
+	}
+	destroy_wcpagc (a);
+	_aligned_free (buff);
+}
+
+static int close_to (double x, double ref)
+{
+	return fabs (x - ref) <= ABS_TOL + REL_TOL * fabs (ref);
+}
+
+int main (int argc, char** argv)
+{
+	int c, k, kc, kk, fails = 0, lines = 0;
+	chunk res[NCHUNKS], ref;
+	FILE* f;
+	int generate = argc > 2 && strcmp (argv[1], "-g") == 0;
+	const char* path = generate ? argv[2] : (argc > 1 ? argv[1] : "test/wcpagc_golden.txt");
+	if ((f = fopen (path, generate ? "w" : "r")) == NULL)
+	{
+		fprintf (stderr, "test_wcpagc: cannot open %s\n", path);
+		return 2;
+	}
+	for (c = 0; c < NCFGS; c++)
+	{
+		run_cfg (&cfgs[c], res);
+		for (k = 0; k < NCHUNKS; k++)
+		{
+			if (generate)
+			{
+				fprintf (f, "%d %d %.17g %.17g %.17g %.17g\n", c, k, res[k].i0, res[k].q0, res[k].energy, res[k].peak);
+				continue;
+			}
+			if (fscanf (f, "%d %d %lf %lf %lf %lf", &kc, &kk, &ref.i0, &ref.q0, &ref.energy, &ref.peak) != 6 || kc != c || kk != k)
+			{
+				fprintf (stderr, "test_wcpagc: %s is short or out of order at config %d chunk %d\n", path, c, k);
+				fclose (f);
+				return 2;
+			}
+			lines++;
+			if (!close_to (res[k].i0, ref.i0) || !close_to (res[k].q0, ref.q0)
+				|| !close_to (res[k].energy, ref.energy) || !close_to (res[k].peak, ref.peak))
+			{
+				if (fails++ < 10)
+					printf ("config %d (bs %d rate %d pmode %d) chunk %d: energy %.17g expected %.17g, peak %.17g expected %.17g\n",
+						c, cfgs[c].bs, cfgs[c].rate, cfgs[c].pmode, k, res[k].energy, ref.energy, res[k].peak, ref.peak);
+			}
+		}
+	}
+	fclose (f);
+	if (generate)
+	{
+		printf ("test_wcpagc: wrote %s\n", path);
+		return 0;
+	}
+	printf ("test_wcpagc: %d configs, %d chunks, %d differ: %s\n", NCFGS, lines, fails, fails ? "FAIL" : "PASS");
+	return fails ? 1 : 0;
+}
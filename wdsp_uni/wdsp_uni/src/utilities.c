@@ -36,12 +36,25 @@ warren@wpratt.com
 PORT
 void *malloc0 (int size)
 {
-	int alignment = 16;
+	int alignment = WDSP_ALIGNMENT;
 	void* p = _aligned_malloc (size, alignment);
 	if (p != 0) memset (p, 0, size);
 	return p;
 }
 
+#ifdef WDSP_ALIGN_CHECK
+#include <assert.h>
+#include <stdint.h>
+
+void *wdsp_check_aligned (void *p, const char *what)
+{
+	if (((uintptr_t)p & (WDSP_ALIGNMENT - 1)) != 0)
+		fprintf (stderr, "WDSP: %s buffer %p is not %d byte aligned\n", what, p, WDSP_ALIGNMENT);
+	assert (((uintptr_t)p & (WDSP_ALIGNMENT - 1)) == 0);
+	return p;
+}
+#endif
+
 #if !defined(linux) && !defined(__APPLE__)
 // Exported calls
 
@@ -24,8 +24,22 @@ warren@wpratt.com
 
 */
 
+// alignment of every malloc0 buffer, one cache line and a full AVX-512 vector
+#define WDSP_ALIGNMENT					64
+
 __declspec (dllexport) void *malloc0 (int size);
 
+// debug build check that every buffer given to an fftw planner is aligned, define WDSP_ALIGN_CHECK to enable
+#ifdef WDSP_ALIGN_CHECK
+extern void *wdsp_check_aligned (void *p, const char *what);
+#define fftw_plan_dft_1d(n, in, out, sign, flags) \
+	fftw_plan_dft_1d(n, wdsp_check_aligned(in, "fftw_plan_dft_1d in"), wdsp_check_aligned(out, "fftw_plan_dft_1d out"), sign, flags)
+#define fftw_plan_dft_r2c_1d(n, in, out, flags) \
+	fftw_plan_dft_r2c_1d(n, wdsp_check_aligned(in, "fftw_plan_dft_r2c_1d in"), wdsp_check_aligned(out, "fftw_plan_dft_r2c_1d out"), flags)
+#define fftw_plan_dft_c2r_1d(n, in, out, flags) \
+	fftw_plan_dft_c2r_1d(n, wdsp_check_aligned(in, "fftw_plan_dft_c2r_1d in"), wdsp_check_aligned(out, "fftw_plan_dft_c2r_1d out"), flags)
+#endif
+
 extern void print_impulse (const char* filename, int N, double* impulse, int rtype, int pr_mode);
 
 void print_peak_val(const char* filename, int N, double* buff, double thresh);
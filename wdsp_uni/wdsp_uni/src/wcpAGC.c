@@ -48,11 +48,17 @@ void calc_wcpagc (WCPAGC a)
 	a->state = 0;
 	a->ring = (double *)malloc0(RB_SIZE * sizeof(complex));
 	a->abs_ring = (double *)malloc0(RB_SIZE * sizeof(double));
+	a->env = (double *)malloc0(a->io_buffsize * sizeof(double));
+	a->dq_val = (double *)malloc0(DQ_SIZE * sizeof(double));
+	a->dq_stamp = (unsigned int *)malloc0(DQ_SIZE * sizeof(unsigned int));
 	loadWcpAGC(a);
 }
 
 void decalc_wcpagc (WCPAGC a)
 {
+	_aligned_free(a->dq_stamp);
+	_aligned_free(a->dq_val);
+	_aligned_free(a->env);
 	_aligned_free(a->abs_ring);
 	_aligned_free(a->ring);
 }
@@ -112,6 +118,29 @@ WCPAGC create_wcpagc (	int run,
 	return a;
 }
 
+// dq_val holds the envelopes in the attack window that are larger than every later one, oldest first,
+// so dq_val[dq_head] is the window maximum; dq_stamp counts samples and retires an entry attack_buffsize on
+
+static void calc_ring_max (WCPAGC a)
+{
+	int j, k;
+	unsigned int stamp = a->dq_now - a->attack_buffsize;
+	a->dq_head = a->dq_tail = 0;
+	k = a->out_index;
+	for (j = 0; j < a->attack_buffsize; j++)
+	{
+		if (++k >= a->ring_buffsize)
+			k -= a->ring_buffsize;
+		++stamp;
+		while (a->dq_tail != a->dq_head && a->dq_val[(a->dq_tail - 1) & (DQ_SIZE - 1)] <= a->abs_ring[k])
+			--a->dq_tail;
+		a->dq_val[a->dq_tail & (DQ_SIZE - 1)] = a->abs_ring[k];
+		a->dq_stamp[a->dq_tail & (DQ_SIZE - 1)] = stamp;
+		++a->dq_tail;
+	}
+	a->ring_max = a->dq_tail != a->dq_head ? a->dq_val[a->dq_head & (DQ_SIZE - 1)] : 0.0;
+}
+
 void loadWcpAGC (WCPAGC a)
 {
 	double tmp;
@@ -143,6 +172,9 @@ void loadWcpAGC (WCPAGC a)
 	a->onemhang_backmult = 1.0 - a->hang_backmult;
 
 	a->hang_decay_mult = 1.0 - exp(-1.0 / (a->sample_rate * a->tau_hang_decay));
+
+	// the attack window may have moved
+	calc_ring_max (a);
 }
 
 void destroy_wcpagc (WCPAGC a)
@@ -156,12 +188,14 @@ void flush_wcpagc (WCPAGC a)
 	memset ((void *)a->ring, 0, sizeof(double) * RB_SIZE * 2);
 	a->ring_max = 0.0;
 	memset ((void *)a->abs_ring, 0, sizeof(double)* RB_SIZE);
+	a->dq_head = a->dq_tail = 0;
 }
 
 void xwcpagc (WCPAGC a)
 {
-	int i, j, k;
-	double mult;
+	int i;
+	unsigned int head, tail, now;
+	double env, mult = 0.0, mult_volts = 0.0;
 	if (a->run)
 	{
 		if (a->mode == 0)
@@ -173,6 +207,12 @@ void xwcpagc (WCPAGC a)
 			}
 			return;
 		}
+
+		// envelopes for the whole block, before any of the output is written
+		cenv (a->env, a->in, a->io_buffsize, a->pmode);
+		head = a->dq_head;
+		tail = a->dq_tail;
+		now = a->dq_now;
 	
 		for (i = 0; i < a->io_buffsize; i++)
 		{
@@ -186,28 +226,21 @@ void xwcpagc (WCPAGC a)
 			a->abs_out_sample = a->abs_ring[a->out_index];
 			a->ring[2 * a->in_index + 0] = a->in[2 * i + 0];
 			a->ring[2 * a->in_index + 1] = a->in[2 * i + 1];
-			if (a->pmode == 0)
-				a->abs_ring[a->in_index] = max(fabs(a->ring[2 * a->in_index + 0]), fabs(a->ring[2 * a->in_index + 1]));
-			else
-				a->abs_ring[a->in_index] = sqrt(a->ring[2 * a->in_index + 0] * a->ring[2 * a->in_index + 0] + a->ring[2 * a->in_index + 1] * a->ring[2 * a->in_index + 1]);
+			a->abs_ring[a->in_index] = env = a->env[i];
 
 			a->fast_backaverage = a->fast_backmult * a->abs_out_sample + a->onemfast_backmult * a->fast_backaverage;
 			a->hang_backaverage = a->hang_backmult * a->abs_out_sample + a->onemhang_backmult * a->hang_backaverage;
 
-			if ((a->abs_out_sample >= a->ring_max) && (a->abs_out_sample > 0.0))
-			{
-				a->ring_max = 0.0;
-				k = a->out_index;
-				for (j = 0; j < a->attack_buffsize; j++)
-				{
-					if (++k == a->ring_buffsize)
-						k = 0;
-					if (a->abs_ring[k] > a->ring_max)
-						a->ring_max = a->abs_ring[k];
-				}
-			}
-			if (a->abs_ring[a->in_index] > a->ring_max)
-				a->ring_max = a->abs_ring[a->in_index];
+			// retire the oldest envelope once it has left the attack window, then add the newest
+			++now;
+			while (tail != head && now - a->dq_stamp[head & (DQ_SIZE - 1)] >= (unsigned int)a->attack_buffsize)
+				++head;
+			while (tail != head && a->dq_val[(tail - 1) & (DQ_SIZE - 1)] <= env)
+				--tail;
+			a->dq_val[tail & (DQ_SIZE - 1)] = env;
+			a->dq_stamp[tail & (DQ_SIZE - 1)] = now;
+			++tail;
+			a->ring_max = a->dq_val[head & (DQ_SIZE - 1)];
 
 			if (a->hang_counter > 0)
 				--a->hang_counter;
@@ -332,10 +365,18 @@ void xwcpagc (WCPAGC a)
 			if (a->volts < a->min_volts)
 				a->volts = a->min_volts;
 			a->gain = a->volts * a->inv_out_target;
-			mult = (a->out_target - a->slope_constant * min (0.0, log10(a->inv_max_input * a->volts))) / a->volts;
+			// volts holds steady through hang and at min_volts, the gain need not be recomputed there
+			if (a->volts != mult_volts)
+			{
+				mult_volts = a->volts;
+				mult = (a->out_target - a->slope_constant * min (0.0, log10(a->inv_max_input * a->volts))) / a->volts;
+			}
 			a->out[2 * i + 0] = a->out_sample[0] * mult;
 			a->out[2 * i + 1] = a->out_sample[1] * mult;
 		}
+		a->dq_head = head;
+		a->dq_tail = tail;
+		a->dq_now = now;
 	}
 	else if (a->out != a->in)
 		memcpy(a->out, a->in, a->io_buffsize * sizeof (complex));
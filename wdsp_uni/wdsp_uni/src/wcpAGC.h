@@ -31,6 +31,7 @@ warren@wpratt.com
 #define MAX_N_TAU			(8)
 #define MAX_TAU_ATTACK		(0.01)
 #define RB_SIZE				(int)(MAX_SAMPLE_RATE * MAX_N_TAU * MAX_TAU_ATTACK + 1)
+#define DQ_SIZE				(32768)					// power of two, at least RB_SIZE
 
 #define AGCPORT				__declspec(dllexport)
 
@@ -68,6 +69,12 @@ typedef struct _wcpagc
 	double* abs_ring;
 	int ring_buffsize;
 	double ring_max;
+	double* env;
+	double* dq_val;
+	unsigned int* dq_stamp;
+	unsigned int dq_head;
+	unsigned int dq_tail;
+	unsigned int dq_now;
 
 	double attack_mult;
 	double decay_mult;